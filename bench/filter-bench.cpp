@@ -0,0 +1,110 @@
+// filter-bench [megabytes]
+//
+// Compresses a synthetic, text-like payload (HTTP access log lines) through
+// DeflateFilter, GzipFilter and ZstdFilter at several levels, feeding 16K pieces
+// as a response body would arrive, and reports throughput and compression ratio.
+
+#include <xio/DeflateFilter.h>
+#include <xio/ZstdFilter.h>
+#include <xio/Buffer.h>
+#include <algorithm>
+#include <memory>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace xio;
+
+typedef std::chrono::high_resolution_clock Clock;
+
+static Buffer payload(size_t size)
+{
+	static const char* methods[] = { "GET", "POST", "HEAD" };
+	static const char* paths[] = { "/", "/index.html", "/api/v1/users", "/static/app.js", "/favicon.ico" };
+	static const char* agents[] = { "Mozilla/5.0 (X11; Linux x86_64)", "curl/7.88.1", "Wget/1.21" };
+
+	Buffer result;
+	unsigned seed = 42;
+
+	while (result.size() < size) {
+		seed = seed * 1103515245 + 12345;
+		result.push_back("10.0.");
+		result.push_back((seed >> 8) % 256);
+		result.push_back('.');
+		result.push_back((seed >> 16) % 256);
+		result.push_back(" - - [18/Oct/2013:13:37:");
+		result.push_back((seed >> 4) % 60);
+		result.push_back(" +0200] \"");
+		result.push_back(methods[seed % 3]);
+		result.push_back(' ');
+		result.push_back(paths[(seed >> 3) % 5]);
+		result.push_back(" HTTP/1.1\" 200 ");
+		result.push_back((seed >> 5) % 100000);
+		result.push_back(" \"-\" \"");
+		result.push_back(agents[(seed >> 7) % 3]);
+		result.push_back("\"\n");
+	}
+
+	return result;
+}
+
+static void bench(const char* name, int level, Filter* filter, const Buffer& input)
+{
+	static const size_t pieceSize = 16 * 1024;
+	Buffer output;
+	output.reserve(input.size());
+
+	auto start = Clock::now();
+
+	for (size_t i = 0; i < input.size(); i += pieceSize) {
+		size_t n = std::min(pieceSize, input.size() - i);
+		if (filter->process(input.ref(i, n), output) < 0) {
+			perror(name);
+			return;
+		}
+	}
+
+	if (filter->finish(output) < 0) {
+		perror(name);
+		return;
+	}
+
+	double secs = std::chrono::duration<double>(Clock::now() - start).count();
+
+	printf("%-8s %6d %10.1f %8.2f\n", name, level,
+		input.size() / secs / (1024 * 1024),
+		static_cast<double>(input.size()) / output.size());
+}
+
+int main(int argc, const char* argv[])
+{
+	size_t megabytes = argc > 1 ? strtoul(argv[1], nullptr, 10) : 64;
+	Buffer input = payload(megabytes * 1024 * 1024);
+
+	printf("%-8s %6s %10s %8s\n", "filter", "level", "MB/s", "ratio");
+
+	if (DeflateFilter::isSupported()) {
+		for (int level: { 1, 6, 9 }) {
+			std::unique_ptr<Filter> filter(new DeflateFilter(level));
+			bench("deflate", level, filter.get(), input);
+		}
+
+		for (int level: { 1, 6, 9 }) {
+			std::unique_ptr<Filter> filter(new GzipFilter(level));
+			bench("gzip", level, filter.get(), input);
+		}
+	} else {
+		printf("deflate/gzip: not supported\n");
+	}
+
+	if (ZstdFilter::isSupported()) {
+		for (int level: { 1, 3, 9, 19 }) {
+			std::unique_ptr<Filter> filter(new ZstdFilter(level));
+			bench("zstd", level, filter.get(), input);
+		}
+	} else {
+		printf("zstd: not supported\n");
+	}
+
+	return 0;
+}
@@ -0,0 +1,86 @@
+// timer-bench [rearms]
+//
+// Compares the cost of re-arming per-socket I/O timeouts, once using one
+// ev::timer per socket (as Socket does by default) and once using a TimerWheel,
+// at 10k, 100k and 1M concurrently armed timeouts.
+
+#include <xio/TimerWheel.h>
+#include <memory>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <ev++.h>
+
+using namespace xio;
+
+typedef std::chrono::high_resolution_clock Clock;
+
+static double nsPerOp(Clock::time_point start, size_t ops)
+{
+	auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+	return static_cast<double>(ns) / ops;
+}
+
+static void onTimeout(ev::timer&, int) {}
+
+static double benchEvTimer(struct ev_loop* loop, size_t count, size_t rearms)
+{
+	std::unique_ptr<ev::timer[]> timers(new ev::timer[count]);
+
+	for (size_t i = 0; i < count; ++i) {
+		timers[i].set(loop);
+		timers[i].set<&onTimeout>();
+		timers[i].start(30.0 + (i % 1000) / 100.0, 0);
+	}
+
+	auto start = Clock::now();
+	for (size_t i = 0; i < rearms; ++i) {
+		ev::timer& timer = timers[(i * 7919) % count];
+		timer.stop();
+		timer.start(30.0 + (i % 1000) / 100.0, 0);
+	}
+	double result = nsPerOp(start, rearms);
+
+	for (size_t i = 0; i < count; ++i)
+		timers[i].stop();
+
+	return result;
+}
+
+static double benchTimerWheel(struct ev_loop* loop, size_t count, size_t rearms)
+{
+	TimerWheel wheel(loop);
+	std::unique_ptr<TimerWheel::Timer[]> timers(new TimerWheel::Timer[count]);
+
+	for (size_t i = 0; i < count; ++i)
+		wheel.start(&timers[i], TimeSpan(30.0 + (i % 1000) / 100.0));
+
+	auto start = Clock::now();
+	for (size_t i = 0; i < rearms; ++i)
+		wheel.start(&timers[(i * 7919) % count], TimeSpan(30.0 + (i % 1000) / 100.0));
+	double result = nsPerOp(start, rearms);
+
+	for (size_t i = 0; i < count; ++i)
+		timers[i].stop();
+
+	return result;
+}
+
+int main(int argc, const char* argv[])
+{
+	size_t rearms = argc > 1 ? strtoul(argv[1], nullptr, 10) : 10000000;
+	struct ev_loop* loop = ev_loop_new(0);
+
+	printf("%10s %16s %16s\n", "timers", "ev::timer ns/op", "TimerWheel ns/op");
+
+	for (size_t count: { 10000, 100000, 1000000 }) {
+		double ev = benchEvTimer(loop, count, rearms);
+		double wheel = benchTimerWheel(loop, count, rearms);
+
+		printf("%10zu %16.1f %16.1f\n", count, ev, wheel);
+	}
+
+	ev_loop_destroy(loop);
+
+	return 0;
+}
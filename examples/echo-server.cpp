@@ -1,9 +1,10 @@
-// echo-server [-u path] [-b ipaddr] [-p port]
+// echo-server [-u path] [-b ipaddr] [-p port] [-t threads]
 
 #include <xio/InetServer.h>
 #include <xio/IPAddress.h>
 #include <xio/BufferStream.h>
 #include <xio/Socket.h>
+#include <xio/WorkerGroup.h>
 
 #include <memory>
 #include <stdio.h>
@@ -16,10 +17,12 @@ using namespace xio;
 
 class Server {
 public:
-	explicit Server(ev::loop_ref loop) :
+	Server(ev::loop_ref loop, size_t threads) :
 		loop_(loop),
 		listener_(),
-		sigint_(loop_)
+		workers_(threads ? new WorkerGroup(threads) : nullptr),
+		sigint_(loop_),
+		quit_(loop_)
 	{}
 
 	~Server();
@@ -30,10 +33,13 @@ public:
 private:
 	void accept(Socket* cli, ServerSocket* srv);
 	void sig(ev::sig&, int);
+	void quit(ev::async&, int);
 
 	ev::loop_ref loop_;
 	std::shared_ptr<ServerSocket> listener_;
+	std::unique_ptr<WorkerGroup> workers_;
 	ev::sig sigint_;
+	ev::async quit_;
 };
 
 class Client {
@@ -60,6 +66,7 @@ bool Server::setup()
 {
 	auto inet = std::make_shared<InetServer>(loop_);
 	inet->callback = std::bind(&Server::accept, this, std::placeholders::_1, std::placeholders::_2);
+	inet->setReusePort(workers_ != nullptr);
 
 	if (!inet->open(IPAddress("0.0.0.0"), 3000, O_NONBLOCK | O_CLOEXEC)) {
 		fprintf(stderr, "Failed to setup server socket. %s\n", strerror(errno));
@@ -71,7 +78,22 @@ bool Server::setup()
 
 	sigint_.set<Server, &Server::sig>(this);
 	sigint_.start(SIGINT);
-	loop_.unref();
+
+	if (workers_) {
+		// serve all connections from the worker threads; the main loop is kept
+		// alive by the signal watcher and waits for the quit notification.
+		quit_.set<Server, &Server::quit>(this);
+		quit_.start();
+
+		if (!workers_->listen(listener_.get())) {
+			fprintf(stderr, "Failed to clone server socket into workers.\n");
+			return false;
+		}
+		workers_->start();
+		printf("Serving with %zu worker threads\n", workers_->size());
+	} else {
+		loop_.unref();
+	}
 
 	return true;
 }
@@ -84,7 +106,21 @@ void Server::sig(ev::sig& sig, int revents)
 
 void Server::stop()
 {
-	listener_->stop();
+	if (workers_) {
+		// might be invoked from within any worker thread
+		quit_.send();
+	} else {
+		listener_->stop();
+	}
+}
+
+void Server::quit(ev::async&, int)
+{
+	workers_->stop();
+	workers_->join();
+
+	quit_.stop();
+	sigint_.stop();
 }
 
 void Server::accept(Socket* socket, ServerSocket* /*local*/)
@@ -171,8 +207,14 @@ Client::~Client()
 
 int main(int argc, const char* argv[])
 {
+	size_t threads = 0;
+
+	for (int i = 1; i + 1 < argc; ++i)
+		if (strcmp(argv[i], "-t") == 0)
+			threads = atoi(argv[++i]);
+
 	ev::loop_ref loop(ev::default_loop(0));
-	Server srv(loop);
+	Server srv(loop, threads);
 
 	if (!srv.setup())
 		return 1;
@@ -1,24 +1,47 @@
+#include <xio/Filter.h>
 #include <xio/Stream.h>
-#include <xio/File.h>
-#include <xio/FileStream.h>
+#include <xio/BufferStream.h>
 #include <xio/FilterStream.h>
+#include <xio/DeflateFilter.h>
+#include <xio/CaseFilter.h>
 #include <memory>
+#include <string.h>
+#include <unistd.h>
 
 using namespace xio;
 
+static bool drain(Stream* output)
+{
+	while (!output->empty())
+		if (output->read(STDOUT_FILENO, output->size()) < 0)
+			return false;
+
+	return true;
+}
+
+// usage: filter [gzip|upper|lower] < INPUT
 int main(int argc, char* argv[])
 {
-	File fin("/dev/stdin");
-	File fout("/dev/stdout");
-	auto in = fin.open(O_RDONLY);
-	auto out = fout.open(O_WRONLY);
-	char buf[1024];
-	ssize_t n;
+	const char* mode = argc > 1 ? argv[1] : "gzip";
+
+	// stdin may just as well be a pipe or a terminal, so it is read via plain read()s
+	// and filtered into a memory buffer, which gets written out to stdout.
+	FilterStream out(std::unique_ptr<Stream>(new BufferStream()));
 
-//	in = std::unique_ptr<FilterStream>(new FilterStream(std::move(in)));
+	if (strcmp(mode, "upper") == 0)
+		out.filters.push_back(std::unique_ptr<Filter>(new UpperCaseFilter()));
+	else if (strcmp(mode, "lower") == 0)
+		out.filters.push_back(std::unique_ptr<Filter>(new LowerCaseFilter()));
+	else
+		out.filters.push_back(std::unique_ptr<Filter>(new GzipFilter()));
+
+	ssize_t n;
+	while ((n = out.write(STDIN_FILENO, 4096)) > 0)
+		if (!drain(out.parent()))
+			return 1;
 
-	while ((n = in->read(buf, sizeof(buf))) > 0)
-		out->write(buf, n);
+	if (n < 0 || !out.finish() || !drain(out.parent()))
+		return 1;
 
 	return 0;
 }
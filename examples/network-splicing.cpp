@@ -1,123 +1,119 @@
+// network-splicing [listen-port [backend-ip backend-port [bind-ip]]]
+//
+// TCP proxy, forwarding each accepted client to the backend without
+// copying any payload into userspace.
+
 #include <xio/InetServer.h>
+#include <xio/IPAddress.h>
 #include <xio/Socket.h>
-#include <xio/ChunkedStream.h>
-#include <xio/BufferStream.h>
-#include <xio/Pipe.h>
-#include <xio/Buffer.h>
-#include <xio/File.h>
+#include <xio/SpliceProxy.h>
+#include <xio/PipePool.h>
 #include <ev++.h>
-#include <pthread.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
 
 using namespace xio;
 
 const char* bindaddr = "0.0.0.0";
-const char* ipaddr = "127.0.0.1";
 int port = 8089;
-
-void* client_run(void*)
+const char* backendaddr = "127.0.0.1";
+int backendPort = 8080;
+
+class Proxy {
+public:
+	explicit Proxy(ev::loop_ref loop) :
+		loop_(loop),
+		listener_(loop),
+		pipePool_(),
+		sigint_(loop)
+	{}
+
+	bool setup();
+
+private:
+	void accept(Socket* client, ServerSocket* server);
+	void closed(SpliceProxy* proxy);
+	void sig(ev::sig&, int);
+
+	ev::loop_ref loop_;
+	InetServer listener_;
+	PipePool pipePool_;
+	ev::sig sigint_;
+};
+
+bool Proxy::setup()
 {
-	ev::loop_ref loop = ev::dynamic_loop();
-	File file("/etc/issue");
-	auto fs = file.open(O_RDONLY);
-
-	Buffer buf;
-	buf.printf("POST / HTTP/1.1\r\n");
-	buf.printf("Content-Length: %zu\r\n", fs->size());
-	buf.printf("\r\n");
-
-	Socket client(loop);
-	if (client.open(IPAddress(ipaddr), port)) {
-		client.write(buf.data(), buf.size());
-		client.write(fs.get(),  fs->size());
-	} else {
-		perror("client: open");
+	listener_.callback = std::bind(&Proxy::accept, this, std::placeholders::_1, std::placeholders::_2);
+
+	if (!listener_.open(IPAddress(bindaddr), port, O_NONBLOCK | O_CLOEXEC)) {
+		fprintf(stderr, "Failed to setup server socket. %s\n", strerror(errno));
+		return false;
 	}
+	printf("Proxying %s:%d to %s:%d\n", bindaddr, port, backendaddr, backendPort);
+
+	sigint_.set<Proxy, &Proxy::sig>(this);
+	sigint_.start(SIGINT);
+	loop_.unref();
 
-	return NULL;
+	return true;
 }
 
-/**
- * Receive data from one client, connect a backend, and transfers client's data
- * directly to the backend server <b>without</b> userspace copying.
- */
-void* proxy_run(void* p)
+void Proxy::accept(Socket* client, ServerSocket*)
 {
-	Socket* client = (Socket*) p;
-	ev::loop_ref loop = ev::dynamic_loop();
-
-	Socket backend(loop);
-	if (!backend.open(IPAddress(ipaddr), port))
-		perror("proxy: open");
-
-	Pipe pipe;
-	for (;;) {
-		if (client->read(&pipe, 1024) > 0) {
-			backend.write(&pipe, pipe.size());
-		} else {
-			break;
-		}
+	Socket* backend = new Socket(loop_);
+	if (backend->open(IPAddress(backendaddr), backendPort, O_NONBLOCK | O_CLOEXEC) == Socket::Closed) {
+		perror("backend connect");
+		delete backend;
+		delete client;
+		return;
 	}
 
-	delete client;
-	return NULL;
+	SpliceProxy* proxy = new SpliceProxy(client, backend, &pipePool_);
+	proxy->onClose = std::bind(&Proxy::closed, this, std::placeholders::_1);
+	proxy->start(TimeSpan::fromSeconds(30));
+}
+
+void Proxy::closed(SpliceProxy* proxy)
+{
+	printf("connection closed (%s): %zu bytes up, %zu bytes down\n",
+		proxy->error() ? strerror(proxy->error()) : "ok",
+		proxy->bytesUpstream(), proxy->bytesDownstream());
+
+	delete proxy;
+}
+
+void Proxy::sig(ev::sig&, int)
+{
+	printf("Stop signalled.\n");
+	loop_.ref();
+	sigint_.stop();
+	listener_.stop();
 }
 
 int main(int argc, const char* argv[])
 {
-	if (argc == 4) {
+	if (argc > 1)
 		port = atoi(argv[1]);
-		ipaddr = argv[2];
-		bindaddr = argv[3];
+
+	if (argc > 3) {
+		backendaddr = argv[2];
+		backendPort = atoi(argv[3]);
 	}
 
-	ev::loop_ref loop = ev::default_loop(0);
+	if (argc > 4)
+		bindaddr = argv[4];
 
-	InetServer server(loop);
-	server.open(IPAddress(bindaddr), port);
-	if (!server.isOpen()) {
-		perror("server.open()");
-		return 1;
-	}
+	ev::loop_ref loop = ev::default_loop(0);
 
-	pthread_t client_thread;
-	int rv = pthread_create(&client_thread, NULL, client_run, NULL);
-	if (rv < 0) {
-		perror("pthread_create");
+	Proxy proxy(loop);
+	if (!proxy.setup())
 		return 1;
-	}
-
-	pthread_t proxy_thread;
-	for (int i = 0; i < 2; ++i) {
-		Socket* cs = server.acceptOne();
-		if (!cs) {
-			perror("accept");
-			return 1;
-		}
-
-		if (i == 0) {
-			// first client gets proxied
-			pthread_create(&proxy_thread, NULL, proxy_run, cs);
-		} else {
-			// second client gets dumped to terminal (partly reading into buf, remaining data via pipe)
-			Buffer buf;
-			cs->read(buf, 39);
-			write(STDOUT_FILENO, buf.data(), buf.size());
-
-			Pipe pipe;
-			for (;;) {
-				if (cs->read(&pipe, 1024) > 0) {
-					pipe.read(STDOUT_FILENO, pipe.size());
-				} else {
-					break;
-				}
-			}
-			// TODO: cs->read(chunkedBuffer, Stream::MOVE);
-			delete cs;
-		}
-	}
 
-	pthread_join(client_thread, NULL);
-	pthread_join(proxy_thread, NULL);
+	loop.run();
 
 	return 0;
 }
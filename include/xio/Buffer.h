@@ -8,14 +8,17 @@
  */
 
 #include <xio/Api.h>
+#include <xio/StringUtil.h>
 #include <cstddef>
 #include <climits>
 #include <cstring>
 #include <cstdlib>
+#include <cmath>
 #include <cassert>
 #include <string>
 #include <stdexcept>
 #include <cstdarg>
+#include <cerrno>
 
 namespace xio {
 
@@ -28,6 +31,8 @@ class BufferRef;
 class BufferSlice;
 class FixedBuffer;
 class Buffer;
+class BufferAllocator;
+template<size_t N> class InlineBuffer;
 
 // {{{ BufferTraits
 template<typename T> struct BufferTraits;
@@ -204,6 +209,10 @@ public:
 	double toDouble() const;
 	float toFloat() const;
 
+	bool toInteger(long long* result) const;
+	bool toUnsigned(unsigned long long* result) const;
+	bool toDouble(double* result) const;
+
 	void dump(const char *description = nullptr) const;
 	static void dump(const void *bytes, std::size_t length, const char *description);
 };
@@ -281,6 +290,7 @@ public:
 	void push_back(unsigned value);
 	void push_back(unsigned long value);
 	void push_back(unsigned long long value);
+	void push_back(double value);
 	void push_back(const BufferRef& value);
 	void push_back(const BufferRef& value, size_t offset, size_t length);
 	void push_back(const std::string& value);
@@ -329,6 +339,45 @@ inline FixedBuffer::FixedBuffer(char* data, size_t capacity, size_t size) :
 {
 }
 // }}}
+// {{{ BufferAllocator
+/**
+ * \brief Memory allocation policy for managed buffers.
+ *
+ * Implements how a \p Buffer grows as well as where its storage is taken from.
+ * Storage is always released to the allocator that it has been allocated from,
+ * along with its capacity.
+ *
+ * \see Buffer::setCapacity()
+ */
+class XIO_API BufferAllocator
+{
+public:
+	virtual ~BufferAllocator() {}
+
+	/** Computes the capacity to grow a non-empty buffer to.
+	 *
+	 * @param capacity the current capacity
+	 * @param required the minimum capacity required
+	 */
+	virtual size_t grow(size_t capacity, size_t required) const = 0;
+
+	virtual char* allocate(size_t capacity) = 0;
+	virtual char* reallocate(char* data, size_t capacity, size_t newCapacity) = 0;
+	virtual void deallocate(char* data, size_t capacity) = 0;
+
+	/** Retrieves the allocator to release the given storage to, once it is moved out of its buffer.
+	 *
+	 * @return the allocator, or nullptr if the storage cannot leave its buffer and must be copied instead.
+	 */
+	virtual BufferAllocator* transfer(const char* data) { return this; }
+
+	static BufferAllocator* system();
+	static BufferAllocator* slab();
+
+	static BufferAllocator* defaultAllocator();
+	static void setDefaultAllocator(BufferAllocator* allocator);
+};
+// }}}
 // {{{ Buffer
 /**
  * \brief defines a memory buffer construction and access API.
@@ -342,8 +391,12 @@ class XIO_API Buffer :
 public:
 	enum { CHUNK_SIZE = 4096 };
 
+protected:
+	BufferAllocator* allocator_;
+
 public:
 	Buffer();
+	explicit Buffer(BufferAllocator* allocator);
 	explicit Buffer(size_t capacity);
 	explicit Buffer(const char* value);
 	explicit Buffer(const BufferRef& v);
@@ -368,10 +421,71 @@ public:
 
 	bool setCapacity(size_t value);
 
+	BufferAllocator* allocator() const { return allocator_; }
+
+	void swap(Buffer& v);
+
 	operator bool () const;
 	bool operator!() const;
 
 //	static Buffer fromCopy(const value_type *data, size_t count);
+
+private:
+	friend class SharedBuffer;
+
+	BufferAllocator* transferable() const;
+};
+// }}}
+// {{{ InlineBuffer<N>
+/**
+ * \brief Allocator serving capacities of up to a fixed size from storage embedded into the buffer.
+ *
+ * Larger capacities spill over into the backend allocator, and never move back.
+ */
+class XIO_API InlineBufferAllocator : public BufferAllocator
+{
+public:
+	InlineBufferAllocator(char* storage, size_t capacity, BufferAllocator* backend);
+
+	size_t grow(size_t capacity, size_t required) const;
+	char* allocate(size_t capacity);
+	char* reallocate(char* data, size_t capacity, size_t newCapacity);
+	void deallocate(char* data, size_t capacity);
+	BufferAllocator* transfer(const char* data);
+
+private:
+	char* storage_;
+	size_t capacity_;
+	BufferAllocator* backend_;
+};
+
+/**
+ * \brief Managed buffer keeping up to \p N bytes in place, without any heap allocation.
+ *
+ * Use it for short-lived small buffers, such as temporaries or header values.
+ * It transparently spills over to the heap when growing beyond \p N bytes.
+ *
+ * Its inline storage cannot be moved into another buffer, thus, moving out of
+ * an InlineBuffer that has not spilled over copies its contents.
+ */
+template<size_t N>
+class InlineBuffer :
+	public Buffer
+{
+public:
+	InlineBuffer();
+	explicit InlineBuffer(const BufferRef& v);
+	InlineBuffer(const InlineBuffer<N>& v);
+	~InlineBuffer();
+
+	InlineBuffer& operator=(const InlineBuffer<N>& v);
+	using Buffer::operator=;
+
+	bool isInline() const { return data_ == inline_; }
+
+private:
+	InlineBufferAllocator inlineAllocator_;
+	char inline_[N];
 };
 // }}}
 // {{{ BufferSlice
@@ -406,6 +520,7 @@ template<bool (*ensure)(void*, size_t)> XIO_API MutableBuffer<ensure>& operator<
 template<bool (*ensure)(void*, size_t)> XIO_API MutableBuffer<ensure>& operator<<(MutableBuffer<ensure>& b, unsigned v);
 template<bool (*ensure)(void*, size_t)> XIO_API MutableBuffer<ensure>& operator<<(MutableBuffer<ensure>& b, unsigned long v);
 template<bool (*ensure)(void*, size_t)> XIO_API MutableBuffer<ensure>& operator<<(MutableBuffer<ensure>& b, unsigned long long v);
+template<bool (*ensure)(void*, size_t)> XIO_API MutableBuffer<ensure>& operator<<(MutableBuffer<ensure>& b, double v);
 template<bool (*ensure)(void*, size_t)> XIO_API MutableBuffer<ensure>& operator<<(MutableBuffer<ensure>& b, const MutableBuffer<ensure>& v);
 template<bool (*ensure)(void*, size_t)> XIO_API MutableBuffer<ensure>& operator<<(MutableBuffer<ensure>& b, const BufferRef& v);
 template<bool (*ensure)(void*, size_t)> XIO_API MutableBuffer<ensure>& operator<<(MutableBuffer<ensure>& b, const std::string& v);
@@ -439,27 +554,23 @@ inline bool BufferBase<T>::contains(const BufferBase<T>& ref) const
 template<typename T>
 inline size_t BufferBase<T>::find(const value_type *value, size_t offset) const
 {
-	const char *i = cbegin() + offset;
-	const char *e = cend();
-	const int value_length = strlen(value);
+	if (offset > size())
+		return npos;
 
-	while (i != e) {
-		if (*i == *value) {
-			const char *p = i + 1;
-			const char *q = value + 1;
-			const char *qe = i + value_length;
+	if (const char* p = memfind(data() + offset, size() - offset, value, strlen(value)))
+		return p - data();
 
-			while (*p == *q && p != qe) {
-				++p;
-				++q;
-			}
+	return npos;
+}
 
-			if (p == qe) {
-				return i - data();
-			}
-		}
-		++i;
-	}
+template<typename T>
+inline size_t BufferBase<T>::find(const BufferRef& value, size_t offset) const
+{
+	if (offset > size())
+		return npos;
+
+	if (const char* p = memfind(data() + offset, size() - offset, value.data(), value.size()))
+		return p - data();
 
 	return npos;
 }
@@ -467,6 +578,9 @@ inline size_t BufferBase<T>::find(const value_type *value, size_t offset) const
 template<typename T>
 inline size_t BufferBase<T>::find(value_type value, size_t offset) const
 {
+	if (offset >= size())
+		return npos;
+
 	if (const char *p = (const char *)memchr((const void *)(data() + offset), value, size() - offset))
 		return p - data();
 
@@ -477,35 +591,30 @@ template<typename T>
 template<typename PodType, size_t N>
 inline size_t BufferBase<T>::find(PodType (&value)[N], size_t offset) const
 {
-	const char *i = data() + offset;
-	const char *e = i + size() - offset;
+	if (offset > size())
+		return npos;
 
-	while (i != e) {
-		if (*i == *value) {
-			const char *p = i + 1;
-			const char *q = value + 1;
-			const char *qe = i + N - 1;
+	if (const char* p = memfind(data() + offset, size() - offset, value, N - 1))
+		return p - data();
 
-			while (*p == *q && p != qe) {
-				++p;
-				++q;
-			}
+	return npos;
+}
 
-			if (p == qe) {
-				return i - data();
-			}
-		}
-		++i;
-	}
+template<typename T>
+inline size_t BufferBase<T>::rfind(const value_type *value) const
+{
+	if (const char* p = memrfind(data(), size(), value, strlen(value)))
+		return p - data();
 
 	return npos;
 }
 
 template<typename T>
-inline size_t BufferBase<T>::rfind(const value_type *value) const
+inline size_t BufferBase<T>::rfind(const BufferRef& value) const
 {
-	//! \todo implementation
-	assert(0 && "not implemented");
+	if (const char* p = memrfind(data(), size(), value.data(), value.size()))
+		return p - data();
+
 	return npos;
 }
 
@@ -541,32 +650,8 @@ template<typename T>
 template<typename PodType, size_t N>
 size_t BufferBase<T>::rfind(PodType (&value)[N]) const
 {
-	if (empty())
-		return npos;
-
-	if (size() < N - 1)
-		return npos;
-
-	const char *i = end();
-	const char *e = begin() + (N - 1);
-
-	while (i != e) {
-		if (*i == value[N - 1]) {
-			bool found = true;
-
-			for (int n = 0; n < N - 2; ++n) {
-				if (i[n] != value[n]) {
-					found = !found;
-					break;
-				}
-			}
-
-			if (found) {
-				return i - begin();
-			}
-		}
-		--i;
-	}
+	if (const char* p = memrfind(data(), size(), value, N - 1))
+		return p - data();
 
 	return npos;
 }
@@ -656,6 +741,68 @@ inline bool BufferBase<T>::ends(const value_type *value) const
 	return std::memcmp(data() + size() - valueLength, value, valueLength) == 0;
 }
 
+template<typename T>
+inline bool BufferBase<T>::ends(const std::string& value) const
+{
+	return value.size() <= size() && std::memcmp(data() + size() - value.size(), value.data(), value.size()) == 0;
+}
+
+template<typename T>
+inline bool BufferBase<T>::ibegins(const BufferRef& value) const
+{
+	return value.size() <= size() && memiequals(data(), value.data(), value.size());
+}
+
+template<typename T>
+inline bool BufferBase<T>::ibegins(const value_type *value) const
+{
+	if (!value)
+		return true;
+
+	size_t len = std::strlen(value);
+	return len <= size() && memiequals(data(), value, len);
+}
+
+template<typename T>
+inline bool BufferBase<T>::ibegins(const std::string& value) const
+{
+	return value.size() <= size() && memiequals(data(), value.data(), value.size());
+}
+
+template<typename T>
+inline bool BufferBase<T>::ibegins(value_type value) const
+{
+	return size() >= 1 && memiequals(data(), &value, 1);
+}
+
+template<typename T>
+inline bool BufferBase<T>::iends(const BufferRef& value) const
+{
+	return value.size() <= size() && memiequals(data() + size() - value.size(), value.data(), value.size());
+}
+
+template<typename T>
+inline bool BufferBase<T>::iends(const value_type *value) const
+{
+	if (!value)
+		return true;
+
+	size_t len = std::strlen(value);
+	return len <= size() && memiequals(data() + size() - len, value, len);
+}
+
+template<typename T>
+inline bool BufferBase<T>::iends(const std::string& value) const
+{
+	return value.size() <= size() && memiequals(data() + size() - value.size(), value.data(), value.size());
+}
+
+template<typename T>
+inline bool BufferBase<T>::iends(value_type value) const
+{
+	return size() >= 1 && memiequals(data() + size() - 1, &value, 1);
+}
+
 template<>
 inline BufferRef BufferBase<char*>::ref(size_t offset) const
 {
@@ -744,27 +891,20 @@ template<typename T>
 template<typename U>
 inline U BufferBase<T>::hex() const
 {
-	auto i = begin();
-	auto e = end();
+	U val = 0;
 
-	// empty string
-	if (i == e)
-		return 0;
+	for (auto i = cbegin(), e = cend(); i != e; ++i) {
+		unsigned char ch = *i;
+		unsigned digit;
 
-	U val = 0;
-	while (i != e) {
-		if (!std::isxdigit(*i))
+		if (static_cast<unsigned>(ch - '0') < 10u)
+			digit = ch - '0';
+		else if (static_cast<unsigned>((ch | 0x20) - 'a') < 6u)
+			digit = (ch | 0x20) - 'a' + 10;
+		else
 			break;
 
-		if (val)
-			val *= 16;
-
-		if (std::isdigit(*i))
-			val += *i++ - '0';
-		else if (*i >= 'a' && *i <= 'f')
-			val += 10 + *i++ - 'a';
-		else // 'A' .. 'F'
-			val += 10 + *i++ - 'A';
+		val = val * 16 + digit;
 	}
 
 	return val;
@@ -782,49 +922,96 @@ inline bool BufferBase<T>::toBool() const
 	return false;
 }
 
+/** Parses the leading (optionally signed) decimal integer, ignoring any trailing garbage.
+ *
+ * Values out of range are clamped, and 0 is returned if there is no number at all.
+ *
+ * \see toInteger()
+ */
 template<typename T>
 inline int BufferBase<T>::toInt() const
 {
 	auto i = cbegin();
 	auto e = cend();
 
-	// empty string
-	if (i == e)
-		return 0;
+	bool sign = false;
+	if (i != e && (*i == '-' || *i == '+'))
+		sign = *i++ == '-';
+
+	unsigned long long val = 0;
+	if (!parseDecimal(i, e, &val))
+		val = ~0ULL;
+
+	if (sign)
+		return val > 1ULL + INT_MAX ? INT_MIN : static_cast<int>(0LL - static_cast<long long>(val));
+
+	return val > static_cast<unsigned long long>(INT_MAX) ? INT_MAX : static_cast<int>(val);
+}
+
+/** Parses the whole buffer as an (optionally signed) decimal integer.
+ *
+ * \retval true success
+ * \retval false not a number, trailing garbage (errno = EINVAL), or out of range (errno = ERANGE).
+ */
+template<typename T>
+inline bool BufferBase<T>::toInteger(long long* result) const
+{
+	auto i = cbegin();
+	auto e = cend();
 
-	// parse sign
 	bool sign = false;
-	if (*i == '-') {
-		sign = true;
-		++i;
+	if (i != e && (*i == '-' || *i == '+'))
+		sign = *i++ == '-';
 
-		if (i == e) {
-			return 0;
-		}
-	} else if (*i == '+') {
-		++i;
+	unsigned long long val;
+	const char* end = parseDecimal(i, e, &val);
 
-		if (i == e)
-			return 0;
+	if (end == nullptr || val > (sign ? 1ULL + LLONG_MAX : static_cast<unsigned long long>(LLONG_MAX))) {
+		errno = ERANGE;
+		return false;
 	}
 
-	// parse digits
-	int val = 0;
-	while (i != e) {
-		if (*i < '0' || *i > '9')
-			break;
+	if (end == i || end != e) {
+		errno = EINVAL;
+		return false;
+	}
 
-		if (val)
-			val *= 10;
+	*result = sign ? static_cast<long long>(0ULL - val) : static_cast<long long>(val);
+	return true;
+}
+
+/** Parses the whole buffer as an unsigned decimal integer.
+ *
+ * \retval true success
+ * \retval false not a number, trailing garbage (errno = EINVAL), or out of range (errno = ERANGE).
+ */
+template<typename T>
+inline bool BufferBase<T>::toUnsigned(unsigned long long* result) const
+{
+	const char* end = parseDecimal(cbegin(), cend(), result);
 
-		val += *i++ - '0';
+	if (end == nullptr) {
+		errno = ERANGE;
+		return false;
 	}
 
-	// parsing succeed.
-	if (sign)
-		val = -val;
+	if (end == cbegin() || end != cend()) {
+		errno = EINVAL;
+		return false;
+	}
 
-	return val;
+	return true;
+}
+
+/** Parses the whole buffer as a floating point number, see parseDouble() for the accepted syntax.
+ *
+ * \retval true success
+ * \retval false not a number, trailing garbage (errno = EINVAL), or out of range (errno = ERANGE).
+ */
+template<typename T>
+inline bool BufferBase<T>::toDouble(double* result) const
+{
+	return parseDouble(cbegin(), cend(), result);
 }
 
 template<typename T>
@@ -906,7 +1093,7 @@ inline bool iequals(const BufferBase<T>& a, const BufferBase<T>& b)
 	if (a.size() != b.size())
 		return false;
 
-	return strncasecmp(a.data(), b.data(), a.size()) == 0;
+	return memiequals(a.data(), b.data(), a.size());
 }
 
 template<typename T, typename PodType, std::size_t N>
@@ -917,7 +1104,7 @@ bool iequals(const BufferBase<T>& a, PodType (&b)[N])
 	if (a.size() != bsize)
 		return false;
 
-	return strncasecmp(a.data(), b, bsize) == 0;
+	return memiequals(a.data(), b, bsize);
 }
 
 template<typename T>
@@ -926,7 +1113,7 @@ inline bool iequals(const BufferBase<T>& a, const std::string& b)
 	if (a.size() != b.size())
 		return false;
 
-	return strncasecmp(a.data(), b.data(), b.size()) == 0;
+	return memiequals(a.data(), b.data(), b.size());
 }
 
 inline bool iequals(const std::string& a, const std::string& b)
@@ -934,7 +1121,7 @@ inline bool iequals(const std::string& a, const std::string& b)
 	if (a.size() != b.size())
 		return false;
 
-	return strncasecmp(a.data(), b.data(), b.size()) == 0;
+	return memiequals(a.data(), b.data(), b.size());
 }
 
 // ------------------------------------------------------------------------
@@ -1064,49 +1251,50 @@ inline void MutableBuffer<ensure>::push_back(value_type value)
 template<bool (*ensure)(void*, size_t)>
 inline void MutableBuffer<ensure>::push_back(int value)
 {
-	char buf[32];
-	int n = std::snprintf(buf, sizeof(buf), "%d", value);
-	push_back(buf, n);
+	char buf[20];
+	push_back(buf, formatInteger(buf, static_cast<long long>(value)));
 }
 
 template<bool (*ensure)(void*, size_t)>
 inline void MutableBuffer<ensure>::push_back(long value)
 {
-	char buf[32];
-	int n = std::snprintf(buf, sizeof(buf), "%ld", value);
-	push_back(buf, n);
+	char buf[20];
+	push_back(buf, formatInteger(buf, static_cast<long long>(value)));
 }
 
 template<bool (*ensure)(void*, size_t)>
 inline void MutableBuffer<ensure>::push_back(long long value)
 {
-	char buf[32];
-	int n = std::snprintf(buf, sizeof(buf), "%lld", value);
-	push_back(buf, n);
+	char buf[20];
+	push_back(buf, formatInteger(buf, static_cast<long long>(value)));
 }
 
 template<bool (*ensure)(void*, size_t)>
 inline void MutableBuffer<ensure>::push_back(unsigned value)
 {
-	char buf[32];
-	int n = std::snprintf(buf, sizeof(buf), "%u", value);
-	push_back(buf, n);
+	char buf[20];
+	push_back(buf, formatInteger(buf, static_cast<unsigned long long>(value)));
 }
 
 template<bool (*ensure)(void*, size_t)>
 inline void MutableBuffer<ensure>::push_back(unsigned long value)
 {
-	char buf[32];
-	int n = std::snprintf(buf, sizeof(buf), "%lu", value);
-	push_back(buf, n);
+	char buf[20];
+	push_back(buf, formatInteger(buf, static_cast<unsigned long long>(value)));
 }
 
 template<bool (*ensure)(void*, size_t)>
 inline void MutableBuffer<ensure>::push_back(unsigned long long value)
+{
+	char buf[20];
+	push_back(buf, formatInteger(buf, static_cast<unsigned long long>(value)));
+}
+
+template<bool (*ensure)(void*, size_t)>
+inline void MutableBuffer<ensure>::push_back(double value)
 {
 	char buf[32];
-	int n = std::snprintf(buf, sizeof(buf), "%llu", value);
-	push_back(buf, n);
+	push_back(buf, formatDouble(buf, value));
 }
 
 template<bool (*ensure)(void*, size_t)>
@@ -1183,7 +1371,7 @@ inline MutableBuffer<ensure>& MutableBuffer<ensure>::vprintf(const char* fmt, va
 			? buflen + 1      // glibc >= 2.1
 			: capacity_ * 2;  // glibc <= 2.0
 
-		if (!setCapacity(capacity_ + buflen)) {
+		if (!reserve(capacity_ + buflen)) {
 			// increasing capacity failed
 			data_[capacity_ - 1] = '\0';
 			break; // alloc failure
@@ -1304,6 +1492,13 @@ inline MutableBuffer<ensure>& operator<<(MutableBuffer<ensure>& b, unsigned long
 	return b;
 }
 
+template<bool (*ensure)(void*, size_t)>
+inline MutableBuffer<ensure>& operator<<(MutableBuffer<ensure>& b, double v)
+{
+	b.push_back(v);
+	return b;
+}
+
 template<bool (*ensure)(void*, size_t)>
 inline MutableBuffer<ensure>& operator<<(MutableBuffer<ensure>& b, const MutableBuffer<ensure>& v)
 {
@@ -1341,13 +1536,20 @@ inline MutableBuffer<ensure>& operator<<(MutableBuffer<ensure>& b, const typenam
 // }}}
 // {{{ Buffer impl
 inline Buffer::Buffer() :
-	MutableBuffer<mutableEnsure>()
+	MutableBuffer<mutableEnsure>(),
+	allocator_(BufferAllocator::defaultAllocator())
 {
 }
 
-inline Buffer::Buffer(const BufferRef& v, size_t offset, size_t count) :
+inline Buffer::Buffer(BufferAllocator* allocator) :
+	MutableBuffer<mutableEnsure>(),
+	allocator_(allocator)
+{
+}
 
-	MutableBuffer<mutableEnsure>()
+inline Buffer::Buffer(const BufferRef& v, size_t offset, size_t count) :
+	MutableBuffer<mutableEnsure>(),
+	allocator_(BufferAllocator::defaultAllocator())
 {
 	assert(offset + count <= v.size());
 
@@ -1355,42 +1557,85 @@ inline Buffer::Buffer(const BufferRef& v, size_t offset, size_t count) :
 }
 
 inline Buffer::Buffer(size_t _capacity) :
-	MutableBuffer<mutableEnsure>()
+	MutableBuffer<mutableEnsure>(),
+	allocator_(BufferAllocator::defaultAllocator())
 {
 	reserve(_capacity);
 }
 
 inline Buffer::Buffer(const char* v) :
-	MutableBuffer<mutableEnsure>()
+	MutableBuffer<mutableEnsure>(),
+	allocator_(BufferAllocator::defaultAllocator())
 {
 	push_back(v);
 }
 
 inline Buffer::Buffer(const std::string& v) :
-	MutableBuffer<mutableEnsure>()
+	MutableBuffer<mutableEnsure>(),
+	allocator_(BufferAllocator::defaultAllocator())
 {
 	push_back(v.c_str(), v.size() + 1);
 	resize(v.size());
 }
 
 inline Buffer::Buffer(const Buffer& v) :
-	MutableBuffer<mutableEnsure>()
+	MutableBuffer<mutableEnsure>(),
+	allocator_(BufferAllocator::defaultAllocator())
 {
 	push_back(v.data(), v.size());
 }
 
+inline Buffer::Buffer(Buffer&& v) :
+	MutableBuffer<mutableEnsure>(),
+	allocator_(BufferAllocator::defaultAllocator())
+{
+	*this = std::move(v);
+}
+
 inline Buffer::~Buffer()
 {
 	reserve(0);
 }
 
+/** Retrieves the allocator owning this buffer's storage once moved out, or nullptr if it must be copied.
+ */
+inline BufferAllocator* Buffer::transferable() const
+{
+	return capacity_ ? allocator_->transfer(data_) : allocator_;
+}
+
+inline void Buffer::swap(Buffer& v)
+{
+	if (transferable() == allocator_ && v.transferable() == v.allocator_) {
+		MutableBuffer<mutableEnsure>::swap(v);
+		std::swap(allocator_, v.allocator_);
+	} else {
+		Buffer tmp(std::move(v));
+		v = std::move(*this);
+		*this = std::move(tmp);
+	}
+}
+
 inline Buffer& Buffer::operator=(Buffer&& v)
 {
+	if (&v == this)
+		return *this;
+
+	BufferAllocator* owner = v.transferable();
+	if (!owner) {
+		// storage is embedded into the other buffer, e.g. an InlineBuffer
+		clear();
+		push_back(v.data(), v.size());
+		v.clear();
+		return *this;
+	}
+
 	reserve(0); // special case, frees the buffer if available and managed
 
 	data_ = v.data_;
 	size_ = v.size_;
 	capacity_ = v.capacity_;
+	allocator_ = owner;
 
 	v.data_ = 0;
 	v.size_ = 0;
@@ -1399,6 +1644,16 @@ inline Buffer& Buffer::operator=(Buffer&& v)
 	return *this;
 }
 
+inline Buffer& Buffer::operator=(const Buffer& v)
+{
+	if (&v != this) {
+		clear();
+		push_back(v.data(), v.size());
+	}
+
+	return *this;
+}
+
 inline Buffer& Buffer::operator=(const BufferRef& v)
 {
 	clear();
@@ -1447,6 +1702,42 @@ inline const Buffer::value_type *Buffer::c_str() const
 	return data_;
 }
 
+// }}}
+// {{{ InlineBuffer<N> impl
+template<size_t N>
+inline InlineBuffer<N>::InlineBuffer() :
+	Buffer(&inlineAllocator_),
+	inlineAllocator_(inline_, N, BufferAllocator::defaultAllocator())
+{
+}
+
+template<size_t N>
+inline InlineBuffer<N>::InlineBuffer(const BufferRef& v) :
+	InlineBuffer()
+{
+	push_back(v);
+}
+
+template<size_t N>
+inline InlineBuffer<N>::InlineBuffer(const InlineBuffer<N>& v) :
+	InlineBuffer()
+{
+	push_back(v.data(), v.size());
+}
+
+template<size_t N>
+inline InlineBuffer<N>::~InlineBuffer()
+{
+	// release while our allocator is still alive
+	reserve(0);
+}
+
+template<size_t N>
+inline InlineBuffer<N>& InlineBuffer<N>::operator=(const InlineBuffer<N>& v)
+{
+	Buffer::operator=(v);
+	return *this;
+}
 // }}}
 // {{{ BufferSlice impl
 inline BufferSlice::BufferSlice() :
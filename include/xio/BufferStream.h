@@ -5,6 +5,8 @@
 
 namespace xio {
 
+class MemoryBudget;
+
 class XIO_API BufferStream : public Stream
 {
 private:
@@ -14,11 +16,13 @@ private:
 public:
 	BufferStream() : data_(), readOffset_(0) {}
 	explicit BufferStream(size_t cap);
+	explicit BufferStream(MemoryBudget* budget, size_t cap = 0);
 	~BufferStream();
 
 	void clear();
 	virtual size_t size() const;
 	size_t capacity() const { return data_.capacity(); }
+	bool reserve(size_t capacity) { return data_.reserve(capacity); }
 
 	void shift(size_t n);
 
@@ -47,6 +51,7 @@ public:
 
 private:
 	char* rwdata() { return (char*) data_.data(); }
+	size_t writable(size_t size);
 };
 
 } // namespace xio
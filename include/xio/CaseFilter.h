@@ -0,0 +1,40 @@
+#pragma once
+/* <xio/CaseFilter.h>
+ *
+ * This file is part of the x0 web server project and is released under LGPL-3.
+ * http://www.xzero.io/
+ *
+ * (c) 2009-2013 Christian Parpart <trapni@gmail.com>
+ */
+
+#include <xio/Api.h>
+#include <xio/Filter.h>
+
+namespace xio {
+
+//! \addtogroup io
+//@{
+
+/** Converts ASCII lowercase letters to uppercase, passing all other bytes through.
+ *
+ * \see memtoupper()
+ */
+class XIO_API UpperCaseFilter : public Filter
+{
+public:
+	virtual ssize_t process(const BufferRef& input, Buffer& output);
+};
+
+/** Converts ASCII uppercase letters to lowercase, passing all other bytes through.
+ *
+ * \see memtolower()
+ */
+class XIO_API LowerCaseFilter : public Filter
+{
+public:
+	virtual ssize_t process(const BufferRef& input, Buffer& output);
+};
+
+//@}
+
+} // namespace xio
@@ -0,0 +1,74 @@
+#pragma once
+/* <xio/ChunkedDecoder.h>
+ *
+ * This file is part of the x0 web server project and is released under LGPL-3.
+ * http://www.xzero.io/
+ *
+ * (c) 2009-2013 Christian Parpart <trapni@gmail.com>
+ */
+
+#include <xio/Api.h>
+#include <xio/Filter.h>
+
+namespace xio {
+
+//! \addtogroup io
+//@{
+
+/** Decodes a message body from the HTTP/1.1 chunked transfer coding (RFC 7230, section 4.1).
+ *
+ * The input may be split at arbitrary positions. Chunk extensions are validated
+ * and skipped, trailer fields are skipped. Malformed input fails with EBADMSG.
+ *
+ * Once the last chunk and trailer have been decoded, isFinished() returns true and any
+ * further input (e.g. the next pipelined request) is not consumed, see unconsumed().
+ *
+ * \see ChunkedEncoder
+ */
+class XIO_API ChunkedDecoder : public Filter
+{
+public:
+	ChunkedDecoder();
+
+	void reset();
+
+	bool isFinished() const { return state_ == END; }
+	size_t unconsumed() const { return unconsumed_; }
+
+	virtual ssize_t process(const BufferRef& input, Buffer& output);
+
+private:
+	enum State {
+		SIZE,           //!< chunk size, in hex digits
+		EXTENSION,      //!< optional whitespace, then chunk extensions or the end of the line
+		EXT_NAME_START, //!< after ';'
+		EXT_NAME,
+		EXT_AFTER_NAME, //!< optional whitespace, then '=' or what may follow an extension
+		EXT_VALUE_START,//!< after '='
+		EXT_VALUE,      //!< token value
+		EXT_QUOTED,     //!< quoted-string value
+		EXT_QUOTED_PAIR,//!< escaped character within a quoted-string
+		EXT_END,        //!< optional whitespace, then ';' or the end of the line
+		SIZE_LF,        //!< LF ending the chunk size line
+		DATA,
+		DATA_CR,
+		DATA_LF,
+		TRAILER_START,  //!< start of a trailer field, or of the final empty line
+		TRAILER,
+		END_LF,
+		END,
+		ERROR,
+	};
+
+	ssize_t fail();
+	bool extension(char ch);
+
+	State state_;
+	size_t size_;       //!< bytes of chunk data still expected
+	unsigned digits_;   //!< hex digits of the current chunk size
+	size_t unconsumed_;
+};
+
+//@}
+
+} // namespace xio
@@ -0,0 +1,52 @@
+#pragma once
+/* <xio/ChunkedEncoder.h>
+ *
+ * This file is part of the x0 web server project and is released under LGPL-3.
+ * http://www.xzero.io/
+ *
+ * (c) 2009-2013 Christian Parpart <trapni@gmail.com>
+ */
+
+#include <xio/Api.h>
+#include <xio/Filter.h>
+
+namespace xio {
+
+class ChunkedStream;
+class Pipe;
+
+//! \addtogroup io
+//@{
+
+/** Encodes a message body with the HTTP/1.1 chunked transfer coding (RFC 7230, section 4.1).
+ *
+ * As a Filter, every non-empty input becomes one chunk, and finish() emits the last chunk.
+ *
+ * When the body is assembled within a ChunkedStream, write() frames the payload by appending
+ * just the chunk header and trailing CRLF as small memory chunks around it. Payload held within
+ * a Pipe is moved by splicing, so spliced bodies can be chunk encoded without
+ * copying them through userspace.
+ *
+ * \see ChunkedDecoder
+ */
+class XIO_API ChunkedEncoder : public Filter
+{
+public:
+	ChunkedEncoder();
+
+	bool isFinished() const { return finished_; }
+
+	virtual ssize_t process(const BufferRef& input, Buffer& output);
+	virtual ssize_t finish(Buffer& output);
+
+	ssize_t write(ChunkedStream* output, const char* buf, size_t size);
+	ssize_t write(ChunkedStream* output, Pipe* payload, size_t size);
+	bool finish(ChunkedStream* output);
+
+private:
+	bool finished_;
+};
+
+//@}
+
+} // namespace xio
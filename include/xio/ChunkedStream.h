@@ -7,16 +7,30 @@
 #include <cstdint>
 #include <cstring>
 #include <utility>
-#include <deque>
 
 namespace xio {
 
+class PipePool;
+class MemoryBudget;
+
+/** Stream composed of a sequence of memory (BufferStream) and kernel (Pipe) chunks.
+ *
+ * Chunks are kept in an intrusive singly linked list, and drained chunk nodes are recycled
+ * for later writes. The byte count is maintained incrementally, so \p size() is O(1).
+ */
 class XIO_API ChunkedStream : public Stream
 {
 public:
 	ChunkedStream();
+	explicit ChunkedStream(PipePool* pipePool);
 	~ChunkedStream();
 
+	PipePool* pipePool() const { return pipePool_; }
+	void setPipePool(PipePool* pool) { pipePool_ = pool; }
+
+	MemoryBudget* budget() const { return budget_; }
+	void setBudget(MemoryBudget* budget);
+
 	virtual bool empty() const;
 	virtual size_t size() const;
 
@@ -39,26 +53,51 @@ public:
 
 	virtual void accept(StreamVisitor&);
 
-	StreamReader front() const { return !chunks_.empty() ? StreamReader(chunks_.front()) : StreamReader(nullptr); }
+	StreamReader front() const;
 	void pop_front();
 
 private:
-	Stream* buffer(size_t size);
-	Stream* pipe(size_t size);
+	struct Chunk;
+
+	Chunk* acquire();
+	Chunk* buffer(size_t size);
+	Chunk* pipe(size_t size);
+	void push_back(Chunk* chunk);
+	ssize_t appended(Chunk* chunk, ssize_t rv);
+	ssize_t writev(Socket* socket, size_t size, size_t* expected);
+	void release(Chunk* chunk);
+	void clearRecycled();
 
-	std::deque<Stream*> chunks_;
+	Chunk* head_;
+	Chunk* tail_;
+	size_t size_;			//!< number of bytes in all chunks but the head
+	Chunk* recycled_;		//!< drained chunk nodes, ready for reuse
+	size_t recycledCount_;
+	PipePool* pipePool_;
+	MemoryBudget* budget_;
 };
 
 // {{{ inlines
 inline ChunkedStream::ChunkedStream() :
-	chunks_()
+	head_(nullptr),
+	tail_(nullptr),
+	size_(0),
+	recycled_(nullptr),
+	recycledCount_(0),
+	pipePool_(nullptr),
+	budget_(nullptr)
 {
 }
 
-inline ChunkedStream::~ChunkedStream()
+inline ChunkedStream::ChunkedStream(PipePool* pipePool) :
+	head_(nullptr),
+	tail_(nullptr),
+	size_(0),
+	recycled_(nullptr),
+	recycledCount_(0),
+	pipePool_(pipePool),
+	budget_(nullptr)
 {
-	for (auto chunk: chunks_)
-		delete chunk;
 }
 // }}}
 
@@ -2,6 +2,7 @@
 
 #include <xio/Api.h>
 #include <xio/TimeSpan.h>
+#include <xio/Buffer.h>
 #include <string>
 #include <ctime>
 #include <ev++.h>
@@ -11,13 +12,21 @@
 
 /** date/time object that understands unix timestamps
  *  as well as HTTP conform dates as used in Date/Last-Modified and other headers.
+ *
+ * HTTP dates are formatted and parsed in the fixed RFC 1123 format
+ * (e.g. "Sun, 06 Nov 1994 08:49:37 GMT") without going through strftime() / strptime(),
+ * and thus independent of the process' locale and timezone.
  */
 class XIO_API DateTime
 {
+public:
+	enum { HTTP_DATE_SIZE = 29 }; //!< length of an RFC 1123 date
+
 private:
 	ev::tstamp value_;
 
-	static time_t mktime(const char *v);
+	mutable std::time_t httpTime_; //!< the second http_ has been formatted for
+	mutable char http_[HTTP_DATE_SIZE];
 
 public:
 	DateTime();
@@ -34,6 +43,11 @@ public:
 
 	bool valid() const;
 
+	xio::BufferRef httpDate() const;
+
+	static size_t formatHttpDate(char* buf, std::time_t value);
+	static bool parseHttpDate(const char* buf, size_t size, std::time_t* result);
+
 	static int compare(const DateTime& a, const DateTime& b);
 };
 
@@ -49,17 +63,6 @@ XIO_API DateTime operator+(const DateTime& a, const TimeSpan& b);
 XIO_API DateTime operator-(const DateTime& a, const TimeSpan& b);
 
 // {{{ impl
-inline time_t DateTime::mktime(const char *v)
-{
-	struct tm tm;
-	tm.tm_isdst = 0;
-
-	if (strptime(v, "%a, %d %b %Y %H:%M:%S GMT", &tm))
-		return ::mktime(&tm) - timezone;
-
-	return 0;
-}
-
 inline ev::tstamp DateTime::value() const
 {
 	return value_;
@@ -0,0 +1,94 @@
+#pragma once
+/* <xio/DeflateFilter.h>
+ *
+ * This file is part of the x0 web server project and is released under LGPL-3.
+ * http://www.xzero.io/
+ *
+ * (c) 2009-2013 Christian Parpart <trapni@gmail.com>
+ */
+
+#include <xio/Api.h>
+#include <xio/Filter.h>
+
+struct z_stream_s;
+
+namespace xio {
+
+//! \addtogroup io
+//@{
+
+/** Streaming zlib compressor, producing the \c deflate HTTP content-coding (RFC 1950).
+ *
+ * The compressor state is kept across process() calls, so input may arrive in
+ * arbitrary pieces. Compressed data is held back until the compressor emits a block,
+ * call flush() to force out everything so far, or finish() to end the stream.
+ *
+ * After finish() the filter is reset and ready to compress the next stream,
+ * reusing its (rather large) compressor state.
+ *
+ * When built without zlib, all operations fail with ENOSYS.
+ *
+ * \see GzipFilter, InflateFilter
+ */
+class XIO_API DeflateFilter : public Filter
+{
+public:
+	explicit DeflateFilter(int level = 6);
+	~DeflateFilter();
+
+	DeflateFilter(const DeflateFilter&) = delete;
+	DeflateFilter& operator=(const DeflateFilter&) = delete;
+
+	static bool isSupported();
+
+	int level() const { return level_; }
+
+	virtual ssize_t process(const BufferRef& input, Buffer& output);
+	virtual ssize_t flush(Buffer& output);
+	virtual ssize_t finish(Buffer& output);
+
+protected:
+	DeflateFilter(int level, int windowBits);
+
+private:
+	ssize_t deflate(const BufferRef& input, Buffer& output, int mode);
+
+	int level_;
+	struct z_stream_s* z_;
+};
+
+/** Streaming gzip compressor, producing the \c gzip HTTP content-coding (RFC 1952).
+ */
+class XIO_API GzipFilter : public DeflateFilter
+{
+public:
+	explicit GzipFilter(int level = 6);
+};
+
+/** Streaming zlib decompressor, accepting both, \c deflate and \c gzip encoded input.
+ *
+ * Fails with EINVAL on corrupt input, and finish() fails with EINVAL on truncated input,
+ * i.e. when the input ended in the middle of a compressed stream. After the end of
+ * a compressed stream the filter is reset, ready to decompress the next one.
+ *
+ * When built without zlib, all operations fail with ENOSYS.
+ */
+class XIO_API InflateFilter : public Filter
+{
+public:
+	InflateFilter();
+	~InflateFilter();
+
+	InflateFilter(const InflateFilter&) = delete;
+	InflateFilter& operator=(const InflateFilter&) = delete;
+
+	virtual ssize_t process(const BufferRef& input, Buffer& output);
+	virtual ssize_t finish(Buffer& output);
+
+private:
+	struct z_stream_s* z_;
+};
+
+//@}
+
+} // namespace xio
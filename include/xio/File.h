@@ -7,11 +7,12 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <memory>
+#include <list>
 #include <ev++.h>
 
 namespace xio {
 
-class FileService;
+class FileMgr;
 class Stream;
 
 class XIO_API File
@@ -45,9 +46,21 @@ public:
 
 	std::unique_ptr<FileStream> open(int flags);
 
+	const char* data();
+	bool isMapped() const { return data_ != nullptr; }
+	bool isCached() const { return fd_ >= 0; }
+
+	const DateTime& cachedAt() const { return cachedAt_; }
+
 	const struct stat* operator->() const { return &stat_; }
 
 private:
+	friend class FileMgr;
+
+	File(const std::string& path, const struct stat& st, int error);
+
+	void releaseHandle();
+
 	std::string path_;
 	struct stat stat_;
 	int errno_;
@@ -55,6 +68,12 @@ private:
 	int inotify_;
 	DateTime cachedAt_;
 
+	// file descriptor cache, managed by FileMgr
+	FileMgr* mgr_;
+	int fd_;
+	void* data_;
+	std::list<File*>::iterator lru_;
+
 	mutable std::string etag_;
 	mutable std::string mtime_;
 	mutable std::string mimetype_;
@@ -12,7 +12,10 @@
 #include <xio/Api.h>
 #include <xio/sysconfig.h>
 #include <string>
+#include <functional>
 #include <sstream>
+#include <list>
+#include <memory>
 #include <unordered_map>
 
 #include <ev++.h>
@@ -24,6 +27,11 @@
 
 namespace xio {
 
+class File;
+class ThreadPool;
+class LoopExecutor;
+typedef std::shared_ptr<File> FilePtr;
+
 //! \addtogroup io
 //@{
 
@@ -33,9 +41,15 @@ namespace xio {
  * caches the result for further use and also invalidates in realtime the file-info items
  * in case their underlying inode has been updated.
  *
+ * Optionally, up to \p Config::maxOpenFiles file descriptors of recently opened files
+ * are kept open (see File::open()), and small ones are additionally memory mapped (see File::data()).
+ * Least recently used descriptors are closed first, unless their file is still referenced elsewhere.
+ *
+ * Cache misses may be resolved on a ThreadPool via \p queryAsync(), so a cold stat() does not block the loop.
+ *
  * \note this class is not thread-safe
  */
-class X0_API FileMgr
+class XIO_API FileMgr
 {
 public:
 	struct Config // {{{
@@ -49,13 +63,18 @@ public:
 
 		int cacheTTL_;									//!< time in seconds to keep File-object in-cache.
 
+		std::size_t maxOpenFiles;						//!< maximum number of file descriptors to keep open, 0 disables fd caching.
+		std::size_t mmapMaxSize;						//!< maximum size of files to keep memory mapped, 0 disables memory mapping.
+
 		Config() :
 			etagConsiderMtime(true),
 			etagConsiderSize(true),
 			etagConsiderInode(false),
 			mimetypes(),
 			defaultMimetype("text/plain"),
-			cacheTTL_(10)
+			cacheTTL_(10),
+			maxOpenFiles(0),
+			mmapMaxSize(32 * 1024)
 		{}
 
 		void loadMimetypes(const std::string& filename);
@@ -67,11 +86,12 @@ private:
 #if defined(HAVE_SYS_INOTIFY_H)
 	int handle_;									//!< inotify handle
 	ev::io inotify_;
-	std::unordered_map<int, FilePtr> inotifies_;
+	std::unordered_map<int, File*> inotifies_;		//!< inotify watch descriptor to File mapping
 #endif
 
 	const Config *config_;
 	std::unordered_map<std::string, FilePtr> cache_;		//!< cache, storing path->File pairs
+	std::list<File*> lru_;							//!< files with an open fd, most recently used first
 
 public:
 	FileMgr(struct ::ev_loop *loop, const Config *config);
@@ -82,14 +102,26 @@ public:
 
 	FilePtr query(const std::string& filename);
 	FilePtr operator()(const std::string& filename);
+	bool queryAsync(const std::string& filename, ThreadPool* pool, LoopExecutor* executor,
+		std::function<void(FilePtr)> done);
 
 	std::size_t size() const;
 	bool empty() const;
+	void clear();
+
+	std::size_t openFiles() const;
 
 private:
 	friend class File;
 
 	inline bool isValid(const File *finfo) const;
+	static std::string normalize(const std::string& filename);
+	FilePtr lookup(const std::string& filename);
+	FilePtr insert(const std::string& filename, FilePtr fi);
+	void invalidate(std::unordered_map<std::string, FilePtr>::iterator i);
+	bool acquire(File* file);
+	void detach(File* file);
+	void evict();
 
 	std::string get_mimetype(const std::string& ext) const;
 	std::string make_etag(const File& fi) const;
@@ -120,6 +152,11 @@ inline bool FileMgr::empty() const
 	return cache_.empty();
 }
 
+inline std::size_t FileMgr::openFiles() const
+{
+	return lru_.size();
+}
+
 inline std::string FileMgr::make_etag(const File& fi) const
 {
 	int count = 0;
@@ -2,20 +2,42 @@
 
 #include <xio/Api.h>
 #include <xio/Stream.h>
+#include <functional>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
 
 namespace xio {
 
+class ThreadPool;
+class LoopExecutor;
+
+/** Stream over a window of a regular file.
+ *
+ * The stream covers the \p size() bytes starting at \p offset().
+ * Reading consumes from the front of that window, writing appends to its end.
+ *
+ * All I/O is done with explicit file offsets (pread, pwrite, sendfile and splice),
+ * never touching the file descriptor's own position, so multiple streams may
+ * share one (not owned) file descriptor concurrently, e.g. to serve range requests.
+ *
+ * Reads that may hit a cold page cache can be offloaded to a ThreadPool via
+ * \p readAsync(), so they do not stall the event loop.
+ */
 class XIO_API FileStream : public Stream
 {
 public:
-	explicit FileStream(int fd);
+	explicit FileStream(int fd, bool owned = true);
+	FileStream(int fd, off_t offset, size_t length, bool owned = true);
 	virtual ~FileStream();
 
 	virtual size_t size() const;
 
+	off_t offset() const { return offset_; }
+	void setRange(off_t offset, size_t length);
+
+	bool isOwned() const { return owned_; }
+
 	// TODO this is going to integrate legacy Source/Sink API
 //	virtual ssize_t read(Stream* sink);
 
@@ -33,10 +55,39 @@ public:
 
 	virtual void accept(StreamVisitor&);
 
+	bool readAsync(Buffer& result, off_t offset, size_t size,
+		ThreadPool* pool, LoopExecutor* executor, std::function<void(ssize_t)> done);
+	void prefetch(off_t offset, size_t size);
+
 	int handle() const { return fd_; }
 
 protected:
+	ssize_t consumed(ssize_t rv);
+	ssize_t appended(ssize_t rv);
+
 	int fd_;
+	off_t offset_;
+	size_t length_;
+	bool owned_;
 };
 
+// {{{ inlines
+inline ssize_t FileStream::consumed(ssize_t rv)
+{
+	if (rv > 0) {
+		offset_ += rv;
+		length_ -= rv;
+	}
+	return rv;
+}
+
+inline ssize_t FileStream::appended(ssize_t rv)
+{
+	if (rv > 0)
+		length_ += rv;
+
+	return rv;
+}
+// }}}
+
 } // namespace xio
@@ -21,6 +21,9 @@ namespace xio {
  * the received data to the sink. this data may or may not be
  * transformed befor passing to the sink.
  *
+ * Input may arrive in arbitrarily small pieces. Stateful filters (e.g. compressors)
+ * are free to hold back data within process() until they are told to flush() or finish().
+ *
  * \see FilterStream
  */
 class XIO_API Filter
@@ -35,6 +38,24 @@ public:
 	 * @param output output buffer to append the processed data into.
 	 */
 	virtual ssize_t process(const BufferRef& input, Buffer& output) = 0;
+
+	/**
+	 * Emits everything held back so far, without ending the stream.
+	 *
+	 * @param output output buffer to append the pending data into.
+	 * @return number of bytes appended, or -1 on failure.
+	 */
+	virtual ssize_t flush(Buffer& /*output*/) { return 0; }
+
+	/**
+	 * Ends the stream, emitting any pending data and trailer.
+	 *
+	 * No more input is passed to process() afterwards.
+	 *
+	 * @param output output buffer to append the remaining data into.
+	 * @return number of bytes appended, or -1 on failure.
+	 */
+	virtual ssize_t finish(Buffer& output) { return flush(output); }
 };
 
 //@}
@@ -13,14 +13,34 @@ namespace xio {
 
 class Filter;
 
+/** Stream that passes its data through a chain of filters.
+ *
+ * Reading pulls raw data from the parent stream and returns it filtered.
+ * The filters are finished once the parent signals end of stream (by reading 0 bytes).
+ *
+ * Writing filters the given data and passes it on into the parent stream.
+ * Filters may hold back data, so call flush() or finish() to push it through.
+ *
+ * Each stage reuses its own intermediate buffer and hands a view of it to the next stage,
+ * so a chain of filters does not allocate once its buffers have grown to the working size.
+ *
+ * \note a filter stream is either read from or written to, never both.
+ */
 class XIO_API FilterStream : public Stream
 {
 private:
+	enum Flush {
+		NONE,   //!< filters may hold back data
+		SYNC,   //!< filters emit everything they hold back
+		FINISH, //!< filters end their output
+	};
+
 	std::unique_ptr<Stream> parent_;
 	Buffer inputBuffer_;
-	size_t inputPos_;
 	Buffer outputBuffer_;
 	size_t outputPos_;
+	std::deque<Buffer> stages_;
+	bool finished_;
 
 public:
 	std::deque<std::unique_ptr<Filter>> filters;
@@ -30,6 +50,12 @@ public:
 	FilterStream(Stream* parent, std::unique_ptr<Filter> filter);
 	~FilterStream();
 
+	Stream* parent() const { return parent_.get(); }
+
+	bool finished() const { return finished_; }
+	bool flush();
+	bool finish();
+
 public: // Stream API
 	virtual bool empty() const;
 	virtual size_t size() const;
@@ -52,8 +78,12 @@ public: // Stream API
 	virtual void accept(StreamVisitor&);
 
 private:
+	size_t pending() const { return outputBuffer_.size() - outputPos_; }
 	ssize_t pull(size_t size);
-	ssize_t process(const BufferRef& input, Buffer& output);
+	ssize_t push();
+	void consume(size_t n);
+	ssize_t process(const BufferRef& input, Buffer& output, Flush mode);
+	ssize_t filter(const BufferRef& input, Flush mode);
 };
 
 } // namespace xio
@@ -0,0 +1,140 @@
+#pragma once
+/* <xio/HttpParser.h>
+ *
+ * This file is part of the x0 web server project and is released under LGPL-3.
+ * http://www.xzero.io/
+ *
+ * (c) 2009-2013 Christian Parpart <trapni@gmail.com>
+ */
+
+#include <xio/Api.h>
+#include <xio/Buffer.h>
+#include <sys/types.h>
+#include <stdint.h>
+
+namespace xio {
+
+//! \addtogroup base
+//@{
+
+/** Incremental, zero-copy HTTP/1.x request / response head parser.
+ *
+ * Parses the request line (or status line) and the header fields up to and
+ * including the empty line that ends the message head. Message bodies are
+ * left to the caller (e.g. Content-Length or chunked transfer coding).
+ *
+ * Input may arrive in arbitrary fragments. Each call to parse() resumes exactly where
+ * the previous one stopped, so no byte is scanned twice. Tokens are recorded as
+ * offsets into the input, and only turned into BufferRef views on access, so the caller's
+ * read buffer may be reallocated in between two parse() calls.
+ *
+ * The parser does not allocate: at most MAX_HEADERS header fields are accepted.
+ *
+ * \code
+ * Buffer buf;                                   // connection's read buffer
+ * HttpParser parser(HttpParser::REQUEST);
+ * socket->read(buf, 4096);
+ * ssize_t n = parser.parse(buf.ref());          // 0: need more data
+ * if (n > 0) {
+ *     handle(parser.method(), parser.uri(), parser.header("Host"));
+ *     // message body (if any) begins at buf.ref(n)
+ * }
+ * \endcode
+ */
+class XIO_API HttpParser
+{
+public:
+	enum Mode {
+		REQUEST,  //!< parses a request line, e.g. "GET / HTTP/1.1"
+		RESPONSE, //!< parses a status line, e.g. "HTTP/1.1 200 OK"
+	};
+
+	enum { MAX_HEADERS = 64 };
+
+	explicit HttpParser(Mode mode = REQUEST);
+
+	Mode mode() const { return mode_; }
+
+	void reset();
+	void reset(Mode mode);
+
+	ssize_t parse(const BufferRef& data);
+
+	bool isComplete() const { return state_ == COMPLETE; }
+	bool isError() const { return state_ == ERROR; }
+	size_t parsed() const { return offset_; }
+
+	// request line
+	BufferRef method() const { return token(method_); }
+	BufferRef uri() const { return token(uri_); }
+
+	// status line
+	int status() const { return status_; }
+	BufferRef reason() const { return token(reason_); }
+
+	int versionMajor() const { return versionMajor_; }
+	int versionMinor() const { return versionMinor_; }
+
+	// header fields
+	size_t headerCount() const { return headerCount_; }
+	BufferRef headerName(size_t i) const { return token(headers_[i].name); }
+	BufferRef headerValue(size_t i) const { return token(headers_[i].value); }
+	BufferRef header(const BufferRef& name) const;
+
+private:
+	enum State {
+		START,
+		METHOD,
+		URI,
+		VERSION,
+		STATUS_SP,
+		STATUS,
+		STATUS_END,
+		REASON,
+		LINE_END,
+		LINE_LF,
+		HEADER_START,
+		HEADER_NAME,
+		HEADER_OWS,
+		HEADER_VALUE,
+		HEAD_END_LF,
+		COMPLETE,
+		ERROR,
+	};
+
+	//! offset and length of a token within the input
+	struct Token {
+		uint32_t offset;
+		uint32_t length;
+	};
+
+	struct Header {
+		Token name;
+		Token value;
+	};
+
+	BufferRef token(const Token& t) const { return BufferRef(base_ + t.offset, t.length); }
+	Token endToken(const char* end) const;
+	ssize_t fail(int error);
+
+	Mode mode_;
+	State state_;
+	const char* base_;
+	size_t offset_;
+	size_t tokenStart_;
+	unsigned versionPos_;
+
+	Token method_;
+	Token uri_;
+	Token reason_;
+	int status_;
+	int versionMajor_;
+	int versionMinor_;
+
+	size_t headerCount_;
+	Header headers_[MAX_HEADERS];
+};
+
+//@}
+
+} // namespace xio
@@ -0,0 +1,114 @@
+#pragma once
+/* <xio/IoUring.h>
+ *
+ * This file is part of the x0 web server project and is released under LGPL-3.
+ * http://www.xzero.io/
+ *
+ * (c) 2009-2013 Christian Parpart <trapni@gmail.com>
+ */
+
+#include <xio/Api.h>
+#include <functional>
+#include <vector>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <stdint.h>
+#include <ev++.h>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+namespace xio {
+
+//! \addtogroup io
+//@{
+
+/** Asynchronous I/O via the Linux io_uring interface, driven by an ev_loop.
+ *
+ * Requests queued during one loop iteration are submitted together with a
+ * single io_uring_enter() right before the loop blocks again. Completions are
+ * signalled through an eventfd watched by the loop, and dispatched to the
+ * request's completion callback with either the syscall's result, or -errno.
+ *
+ * Whether the running kernel supports io_uring is only known at runtime,
+ * so always check \p isOpen() and fall back to the synchronous Stream API if not.
+ *
+ * \note this class is not thread-safe, use one ring per event loop.
+ */
+class XIO_API IoUring
+{
+public:
+	class Request;
+	typedef std::function<void(ssize_t result)> Completion;
+
+	explicit IoUring(struct ev_loop* loop, unsigned entries = 256);
+	~IoUring();
+
+	IoUring(const IoUring&) = delete;
+	IoUring& operator=(const IoUring&) = delete;
+
+	static bool isSupported();
+
+	bool isOpen() const { return fd_ >= 0; }
+	int error() const { return errno_; }
+
+	struct ev_loop* loop() const { return loop_; }
+
+	size_t pending() const { return pending_; }
+	size_t inflight() const { return inflight_; }
+
+	Request* read(int fd, void* buf, size_t size, off_t offset, Completion cb);
+	Request* write(int fd, const void* buf, size_t size, off_t offset, Completion cb);
+	Request* readv(int fd, const struct iovec* iov, int iovcnt, off_t offset, Completion cb);
+	Request* writev(int fd, const struct iovec* iov, int iovcnt, off_t offset, Completion cb);
+	Request* splice(int fdIn, off_t offIn, int fdOut, off_t offOut, size_t size, unsigned flags, Completion cb);
+	Request* poll(int fd, int events, Completion cb);
+
+	void link();
+	void cancel(Request* request);
+
+	bool submit();
+
+private:
+	struct io_uring_sqe* acquireSqe();
+	Request* prepare(struct io_uring_sqe* sqe, Completion&& cb);
+	void release(Request* request);
+	void onPrepare(ev::prepare&, int);
+	void onCompletion(ev::io&, int);
+
+	struct ev_loop* loop_;
+	int fd_;
+	int eventFd_;
+	int errno_;
+
+	// submission queue
+	void* sqRing_;
+	size_t sqRingSize_;
+	unsigned* sqHead_;
+	unsigned* sqTail_;
+	unsigned* sqMask_;
+	unsigned* sqArray_;
+	unsigned sqEntries_;
+	struct io_uring_sqe* sqes_;
+	struct io_uring_sqe* lastSqe_;
+
+	// completion queue
+	void* cqRing_;
+	size_t cqRingSize_;
+	unsigned* cqHead_;
+	unsigned* cqTail_;
+	unsigned* cqMask_;
+	struct io_uring_cqe* cqes_;
+
+	size_t pending_;
+	size_t inflight_;
+	std::vector<Request*> requests_;
+	std::vector<Request*> freeList_;
+
+	ev::prepare prepare_;
+	ev::io completion_;
+};
+
+//@}
+
+} // namespace xio
@@ -0,0 +1,90 @@
+#pragma once
+/* <xio/LoopExecutor.h>
+ *
+ * This file is part of the x0 web server project and is released under LGPL-3.
+ * http://www.xzero.io/
+ *
+ * (c) 2009-2013 Christian Parpart <trapni@gmail.com>
+ */
+
+#include <xio/Api.h>
+#include <functional>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <ev++.h>
+
+namespace xio {
+
+//! \addtogroup io
+//@{
+
+/** Executes tasks posted from any thread within the thread running the given event loop.
+ *
+ * Tasks are passed through a bounded, lock-free multi-producer/single-consumer queue.
+ * Producers wake up the loop through a single ev::async, which is only sent once until
+ * the loop started draining the queue again, so bursts of posts cost one wakeup.
+ *
+ * At most \p budget() tasks are run per loop iteration, so that a flood of
+ * tasks cannot starve the I/O handled by the same loop.
+ *
+ * The executor keeps its loop alive, just like any other active watcher.
+ */
+class XIO_API LoopExecutor
+{
+public:
+	typedef std::function<void()> Task;
+
+	explicit LoopExecutor(struct ev_loop* loop, size_t capacity = 4096, size_t budget = 256);
+	~LoopExecutor();
+
+	LoopExecutor(const LoopExecutor&) = delete;
+	LoopExecutor& operator=(const LoopExecutor&) = delete;
+
+	struct ev_loop* loop() const { return loop_; }
+
+	size_t capacity() const { return mask_ + 1; }
+	size_t size() const;
+
+	size_t budget() const { return budget_; }
+	void setBudget(size_t value) { budget_ = value; }
+
+	void attach();
+	bool isInLoopThread() const;
+
+	bool tryPost(Task task);
+	void post(Task task);
+	void dispatch(Task task);
+
+	size_t drain(size_t limit);
+
+private:
+	struct Cell {
+		std::atomic<size_t> sequence;
+		Task task;
+	};
+
+	bool enqueue(Task& task);
+	void notify();
+	void onWakeup(ev::async&, int);
+
+	struct ev_loop* loop_;
+	std::unique_ptr<Cell[]> cells_;
+	size_t mask_;
+	size_t budget_;
+
+	// producers' and consumer's cursors are padded onto separate cache lines
+	// (no alignas(), as we are heap allocated without aligned new).
+	std::atomic<size_t> enqueuePos_;
+	char enqueuePadding_[64 - sizeof(std::atomic<size_t>)];
+	std::atomic<size_t> dequeuePos_;
+	char dequeuePadding_[64 - sizeof(std::atomic<size_t>)];
+	std::atomic<bool> notified_;
+	std::atomic<std::thread::id> owner_;
+
+	ev::async wakeup_;
+};
+
+//@}
+
+} // namespace xio
@@ -0,0 +1,81 @@
+#pragma once
+/* <xio/MemoryBudget.h>
+ *
+ * This file is part of the x0 web server project and is released under LGPL-3.
+ * http://www.xzero.io/
+ *
+ * (c) 2009-2013 Christian Parpart <trapni@gmail.com>
+ */
+
+#include <xio/Api.h>
+#include <xio/Buffer.h>
+#include <atomic>
+
+namespace xio {
+
+//! \addtogroup base
+//@{
+
+/**
+ * \brief Upper bound on the number of bytes held by a set of buffers.
+ *
+ * Budgets may be nested, e.g. one per connection with a process wide parent,
+ * every charge is then also charged to (and limited by) the parent.
+ *
+ * Buffers allocated from \p allocator() charge their capacity to this budget.
+ * BufferStream and ChunkedStream writes then fail with EAGAIN when the budget
+ * is exhausted, rather than growing without bound, e.g. when writing to slow readers.
+ * A budget must outlive all buffers allocated from it.
+ *
+ * All operations are thread-safe.
+ */
+class XIO_API MemoryBudget
+{
+public:
+	explicit MemoryBudget(size_t limit = 0, MemoryBudget* parent = nullptr);
+
+	MemoryBudget(const MemoryBudget&) = delete;
+	MemoryBudget& operator=(const MemoryBudget&) = delete;
+
+	MemoryBudget* parent() const { return parent_; }
+
+	size_t limit() const { return limit_.load(std::memory_order_relaxed); }
+	void setLimit(size_t value) { limit_.store(value, std::memory_order_relaxed); }
+
+	// stats
+	size_t used() const { return used_.load(std::memory_order_relaxed); }
+	size_t peak() const { return peak_.load(std::memory_order_relaxed); }
+	size_t rejected() const { return rejected_.load(std::memory_order_relaxed); }
+	size_t available() const;
+
+	bool charge(size_t n);
+	void release(size_t n);
+
+	BufferAllocator* allocator() { return &allocator_; }
+
+private:
+	class Allocator : public BufferAllocator {
+	public:
+		Allocator(MemoryBudget* budget, BufferAllocator* backend);
+
+		size_t grow(size_t capacity, size_t required) const;
+		char* allocate(size_t capacity);
+		char* reallocate(char* data, size_t capacity, size_t newCapacity);
+		void deallocate(char* data, size_t capacity);
+
+	private:
+		MemoryBudget* budget_;
+		BufferAllocator* backend_;
+	};
+
+	MemoryBudget* parent_;
+	std::atomic<size_t> limit_;
+	std::atomic<size_t> used_;
+	std::atomic<size_t> peak_;
+	std::atomic<size_t> rejected_;
+	Allocator allocator_;
+};
+
+//@}
+
+} // namespace xio
@@ -30,6 +30,7 @@ private:
 	int readFd() const;
 
 	friend class Socket;
+	friend class FileStream;
 
 public:
 	explicit Pipe(int flags = 0);
@@ -40,6 +41,9 @@ public:
 	virtual size_t size() const;
 	bool isEmpty() const;
 
+	size_t capacity() const;
+	bool setCapacity(size_t value);
+
 	void clear();
 
 	// write to pipe
@@ -0,0 +1,59 @@
+#pragma once
+/* <xio/PipePool.h>
+ *
+ * This file is part of the x0 web server project and is released under LGPL-3.
+ * http://www.xzero.io/
+ *
+ * (c) 2009-2013 Christian Parpart <trapni@gmail.com>
+ */
+
+#include <xio/Api.h>
+#include <sys/types.h>
+#include <vector>
+
+namespace xio {
+
+class Pipe;
+
+//! \addtogroup io
+//@{
+
+/** Recycles drained pipes to save the pipe2()/close() syscalls of creating them on demand.
+ *
+ * Pipes handed out by this pool are non-blocking and close-on-exec.
+ * Pipes released back while still holding data, or while the pool already
+ * holds \p highWaterMark() idle pipes, are destroyed instead.
+ *
+ * \note this class is not thread-safe, you should use one pool per event loop.
+ */
+class XIO_API PipePool
+{
+public:
+	explicit PipePool(size_t highWaterMark = 64, size_t pipeSize = 0);
+	~PipePool();
+
+	PipePool(const PipePool&) = delete;
+	PipePool& operator=(const PipePool&) = delete;
+
+	Pipe* acquire();
+	void release(Pipe* pipe);
+
+	size_t size() const { return pipes_.size(); }
+	bool empty() const { return pipes_.empty(); }
+	void clear();
+
+	size_t highWaterMark() const { return highWaterMark_; }
+	void setHighWaterMark(size_t value);
+
+	size_t pipeSize() const { return pipeSize_; }
+	void setPipeSize(size_t value);
+
+private:
+	std::vector<Pipe*> pipes_;
+	size_t highWaterMark_;
+	size_t pipeSize_;
+};
+
+//@}
+
+} // namespace xio
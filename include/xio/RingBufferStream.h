@@ -0,0 +1,108 @@
+#pragma once
+/* <xio/RingBufferStream.h>
+ *
+ * This file is part of the x0 web server project and is released under LGPL-3.
+ * http://www.xzero.io/
+ *
+ * (c) 2009-2013 Christian Parpart <trapni@gmail.com>
+ */
+
+#include <xio/Stream.h>
+#include <sys/uio.h>
+
+namespace xio {
+
+//! \addtogroup io
+//@{
+
+/** Fixed-capacity FIFO stream on a circular buffer.
+ *
+ * Unlike BufferStream, the memory footprint never grows, no matter how much data
+ * has been streamed through, and consumed space is reused without moving any data.
+ * Writes into a full stream fail with EAGAIN.
+ *
+ * The buffered data (and the free space) consists of up to two contiguous regions,
+ * see \p readRegions() and \p writeRegions(), which are transferred with a single readv()/writev().
+ *
+ * A mirrored stream maps its pages twice, back to back, so that all buffered data
+ * (and all free space) is always contiguous in memory, see \p data().
+ */
+class XIO_API RingBufferStream : public Stream
+{
+public:
+	explicit RingBufferStream(size_t capacity, bool mirrored = false);
+	~RingBufferStream();
+
+	RingBufferStream(const RingBufferStream&) = delete;
+	RingBufferStream& operator=(const RingBufferStream&) = delete;
+
+	bool isMirrored() const { return mirrored_; }
+	size_t capacity() const { return capacity_; }
+	virtual size_t size() const;
+	size_t available() const { return capacity_ - size_; }
+	bool full() const { return size_ == capacity_; }
+	void clear();
+
+	int readRegions(struct iovec* iov, size_t limit = static_cast<size_t>(-1)) const;
+	int writeRegions(struct iovec* iov, size_t limit = static_cast<size_t>(-1));
+	void consume(size_t n);
+	void commit(size_t n);
+
+	const char* data() const { return buffer_ + head_; }
+
+	// write to ring
+	virtual ssize_t write(const char* buf, size_t size);
+	virtual ssize_t write(Socket* socket, size_t size, Mode mode = Stream::COPY);
+	virtual ssize_t write(Pipe* pipe, size_t size, Mode mode = Stream::COPY);
+	virtual ssize_t write(int fd, size_t size);
+
+	// read from ring
+	virtual ssize_t read(Buffer& result, size_t size);
+	virtual ssize_t read(char* buf, size_t size);
+	virtual ssize_t read(Socket* socket, size_t size);
+	virtual ssize_t read(Pipe* pipe, size_t size);
+	virtual ssize_t read(int fd, size_t size);
+	virtual int read();
+
+	virtual void accept(StreamVisitor&);
+
+private:
+	bool map();
+	size_t tail() const;
+	ssize_t committed(ssize_t rv);
+	ssize_t consumed(ssize_t rv);
+
+	char* buffer_;
+	size_t capacity_;
+	size_t head_;
+	size_t size_;
+	bool mirrored_;
+};
+
+//@}
+
+// {{{ inlines
+inline size_t RingBufferStream::tail() const
+{
+	size_t i = head_ + size_;
+	return i < capacity_ ? i : i - capacity_;
+}
+
+inline ssize_t RingBufferStream::committed(ssize_t rv)
+{
+	if (rv > 0)
+		commit(rv);
+
+	return rv;
+}
+
+inline ssize_t RingBufferStream::consumed(ssize_t rv)
+{
+	if (rv > 0)
+		consume(rv);
+
+	return rv;
+}
+// }}}
+
+} // namespace xio
@@ -0,0 +1,158 @@
+#pragma once
+/* <xio/SharedBuffer.h>
+ *
+ * This file is part of the x0 web server project and is released under LGPL-3.
+ * http://www.xzero.io/
+ *
+ * (c) 2009-2013 Christian Parpart <trapni@gmail.com>
+ */
+
+#include <xio/Api.h>
+#include <xio/Buffer.h>
+#include <atomic>
+
+namespace xio {
+
+//! \addtogroup base
+//@{
+
+/**
+ * \brief Immutable, reference counted view into a shared memory segment.
+ *
+ * Unlike BufferSlice, a SharedBuffer pins the segment it refers to, thus,
+ * it may outlive the buffer it was created from and may be passed to other
+ * threads. The reference counting is atomic.
+ *
+ * Slicing never copies, it just creates yet another view into the same segment.
+ */
+class XIO_API SharedBuffer :
+	public BufferRef
+{
+public:
+	SharedBuffer();
+	explicit SharedBuffer(Buffer&& buffer);
+	explicit SharedBuffer(const BufferRef& data);
+	SharedBuffer(const SharedBuffer& v);
+	SharedBuffer(SharedBuffer&& v);
+	~SharedBuffer();
+
+	SharedBuffer& operator=(const SharedBuffer& v);
+	SharedBuffer& operator=(SharedBuffer&& v);
+
+	SharedBuffer slice(size_t offset = 0) const;
+	SharedBuffer slice(size_t offset, size_t count) const;
+
+	size_t useCount() const;
+
+private:
+	struct Segment {
+		std::atomic<size_t> refs;
+		char* data;
+		size_t capacity;
+		BufferAllocator* allocator;
+	};
+
+	SharedBuffer(Segment* segment, const char* data, size_t size);
+
+	void ref();
+	void unref();
+
+	Segment* segment_;
+};
+
+//@}
+
+// {{{ inlines
+inline SharedBuffer::SharedBuffer() :
+	BufferRef(),
+	segment_(nullptr)
+{
+}
+
+inline SharedBuffer::SharedBuffer(const SharedBuffer& v) :
+	BufferRef(v),
+	segment_(v.segment_)
+{
+	ref();
+}
+
+inline SharedBuffer::SharedBuffer(SharedBuffer&& v) :
+	BufferRef(v),
+	segment_(v.segment_)
+{
+	v.segment_ = nullptr;
+	v.data_ = nullptr;
+	v.size_ = 0;
+}
+
+inline SharedBuffer::SharedBuffer(Segment* segment, const char* data, size_t size) :
+	BufferRef(data, size),
+	segment_(segment)
+{
+	ref();
+}
+
+inline SharedBuffer::~SharedBuffer()
+{
+	unref();
+}
+
+inline SharedBuffer& SharedBuffer::operator=(const SharedBuffer& v)
+{
+	if (&v != this) {
+		unref();
+		data_ = v.data_;
+		size_ = v.size_;
+		segment_ = v.segment_;
+		ref();
+	}
+
+	return *this;
+}
+
+inline SharedBuffer& SharedBuffer::operator=(SharedBuffer&& v)
+{
+	if (&v != this) {
+		unref();
+		data_ = v.data_;
+		size_ = v.size_;
+		segment_ = v.segment_;
+
+		v.segment_ = nullptr;
+		v.data_ = nullptr;
+		v.size_ = 0;
+	}
+
+	return *this;
+}
+
+inline SharedBuffer SharedBuffer::slice(size_t offset) const
+{
+	assert(offset <= size());
+	return SharedBuffer(segment_, data() + offset, size() - offset);
+}
+
+inline SharedBuffer SharedBuffer::slice(size_t offset, size_t count) const
+{
+	assert(offset <= size());
+	assert(count == npos || offset + count <= size());
+
+	return count != npos
+		? SharedBuffer(segment_, data() + offset, count)
+		: SharedBuffer(segment_, data() + offset, size() - offset);
+}
+
+inline size_t SharedBuffer::useCount() const
+{
+	return segment_ ? segment_->refs.load(std::memory_order_relaxed) : 0;
+}
+
+inline void SharedBuffer::ref()
+{
+	if (segment_) {
+		segment_->refs.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+// }}}
+
+} // namespace xio
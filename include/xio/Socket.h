@@ -3,9 +3,13 @@
 #include <xio/Stream.h>
 #include <xio/TimeSpan.h>
 #include <xio/DateTime.h>
+#include <xio/TimerWheel.h>
 #include <xio/Buffer.h>
+#include <xio/SharedBuffer.h>
 #include <functional>
+#include <deque>
 #include <unistd.h>
+#include <sys/uio.h>
 #include <ev++.h>
 
 namespace xio {
@@ -37,6 +41,7 @@ public:
 	virtual ~Socket();
 
 	void close();
+	int shutdown(int how);
 	State open(const IPAddress& ip, int port, int flags = 0);
 	bool open(const SocketSpec& spec, int flags = 0);
 	static Socket* open(struct ev_loop* loop, const SocketSpec& spec, int flags = 0);
@@ -44,6 +49,11 @@ public:
 	bool tcpCork() const;
 	void setTcpCork(bool enable);
 
+	bool zeroCopy() const { return zeroCopy_; }
+	bool setZeroCopy(bool enable);
+	size_t zeroCopyPending() const { return zeroCopyPending_.size(); }
+	size_t reapZeroCopy();
+
 	TimeSpan lingering() const;
 	void setLingering(TimeSpan timeout);
 
@@ -54,6 +64,12 @@ public:
 	void restart();
 	void stop();
 
+	TimerWheel* timerWheel() const { return timerWheel_; }
+	void setTimerWheel(TimerWheel* wheel);
+
+	struct ev_loop* loop() const { return io_.loop; }
+	void setLoop(struct ev_loop* loop);
+
 	State state() const { return state_; }
 
 	// {{{ stream impl
@@ -76,6 +92,12 @@ public:
 	virtual void accept(StreamVisitor&);
 	// }}}
 
+	ssize_t write(const SharedBuffer& data, Mode mode = Stream::COPY);
+	ssize_t writev(const struct iovec* iov, int iovcnt);
+
+	//! minimum payload size to send via MSG_ZEROCOPY, as page pinning and completion handling outweigh the copy of smaller payloads
+	static const size_t ZeroCopyThreshold = 16 * 1024;
+
 	int handle() const { return fd_; }
 
 private:
@@ -83,6 +105,9 @@ private:
 	void onConnectComplete();
 	void io(ev::io&, int);
 	void timeout(ev::timer&, int);
+	void timeout(TimerWheel::Timer&);
+	void startTimer(TimeSpan timeout);
+	void stopTimer();
 	void callback(int mode);
 
 private:
@@ -91,7 +116,19 @@ private:
 	ev::io io_;
 	TimeSpan timeout_;
 	ev::timer timer_;
+	TimerWheel* timerWheel_;
+	TimerWheel::Timer wheelTimer_;
 	std::function<void(int)> handler_;
+
+	// MSG_ZEROCOPY sends, whose buffers the kernel has not released yet
+	struct ZeroCopySend {
+		uint32_t id;
+		SharedBuffer data;
+	};
+
+	bool zeroCopy_;
+	uint32_t zeroCopyNextId_;
+	std::deque<ZeroCopySend> zeroCopyPending_;
 };
 
 } // namespace xio
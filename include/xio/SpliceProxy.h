@@ -0,0 +1,99 @@
+#pragma once
+/* <xio/SpliceProxy.h>
+ *
+ * This file is part of the x0 web server project and is released under LGPL-3.
+ * http://www.xzero.io/
+ *
+ * (c) 2009-2013 Christian Parpart <trapni@gmail.com>
+ */
+
+#include <xio/Api.h>
+#include <xio/TimeSpan.h>
+#include <functional>
+#include <sys/types.h>
+
+namespace xio {
+
+class Socket;
+class Pipe;
+class PipePool;
+
+//! \addtogroup io
+//@{
+
+/** Bidirectionally forwards data between two sockets without userspace copies.
+ *
+ * Each direction is pumped from its source socket into a kernel pipe and from there
+ * into its sink socket, both via splice(), driven by the event loop of the sockets.
+ *
+ * A direction stops reading from its source as long as its pipe cannot be
+ * flushed into the sink (backpressure), and shuts down the sink's writing side
+ * once the source reached EOF and the pipe is drained (half-close).
+ *
+ * The proxy is finished once both directions are shut down, or on the first
+ * error or idle timeout, at which point \p onClose() is invoked. It is safe
+ * to delete the proxy from within that callback.
+ */
+class XIO_API SpliceProxy
+{
+public:
+	SpliceProxy(Socket* client, Socket* backend, PipePool* pipePool = nullptr);
+	~SpliceProxy();
+
+	SpliceProxy(const SpliceProxy&) = delete;
+	SpliceProxy& operator=(const SpliceProxy&) = delete;
+
+	Socket* client() const { return upstream_.source; }
+	Socket* backend() const { return upstream_.sink; }
+
+	size_t chunkSize() const { return chunkSize_; }
+	void setChunkSize(size_t value) { chunkSize_ = value; }
+
+	void start(TimeSpan idleTimeout = TimeSpan::Zero);
+	void close();
+
+	bool isActive() const { return active_; }
+	int error() const { return error_; }
+
+	//! number of bytes forwarded from the client to the backend
+	size_t bytesUpstream() const { return upstream_.bytes; }
+
+	//! number of bytes forwarded from the backend to the client
+	size_t bytesDownstream() const { return downstream_.bytes; }
+
+	std::function<void(SpliceProxy*)> onClose;
+
+private:
+	struct Direction {
+		Socket* source;
+		Socket* sink;
+		Pipe* pipe;
+		size_t bytes;
+		bool eof;
+		bool done;
+		bool wantRead;
+		bool wantWrite;
+	};
+
+	void startForwarding();
+	void onClientEvent(int revents);
+	void onBackendEvent(int revents);
+	bool pump(Direction& d);
+	void update();
+	void watch(Socket* socket, int mode, int& current);
+	void finish(int error);
+
+	Direction upstream_;
+	Direction downstream_;
+	PipePool* pipePool_;
+	size_t chunkSize_;
+	TimeSpan idleTimeout_;
+	int clientMode_;
+	int backendMode_;
+	int error_;
+	bool active_;
+};
+
+//@}
+
+} // namespace xio
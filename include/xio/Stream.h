@@ -19,6 +19,7 @@ public:
 	enum Mode {
 		COPY, //!< writes by copying all input data into this chunk
 		MOVE, //!< transfers data into chunk by attempting to move kernel buffers, but falls back to copy if not supported.
+		ZEROCOPY, //!< lets the kernel send straight from the (pinned) source buffer, but falls back to copy if not supported.
 	};
 
 	virtual ~Stream() {}
@@ -6,8 +6,10 @@ namespace xio {
 
 class Pipe;
 class BufferStream;
+class RingBufferStream;
 class ChunkedStream;
 class FileStream;
+class FilterStream;
 class Socket;
 
 class XIO_API StreamVisitor
@@ -15,8 +17,10 @@ class XIO_API StreamVisitor
 public:
 	virtual void visit(Pipe&) = 0;
 	virtual void visit(BufferStream&) = 0;
+	virtual void visit(RingBufferStream&) = 0;
 	virtual void visit(ChunkedStream&) = 0;
 	virtual void visit(FileStream&) = 0;
+	virtual void visit(FilterStream&) = 0;
 	virtual void visit(Socket&) = 0;
 };
 
@@ -0,0 +1,104 @@
+#pragma once
+/* <xio/StringUtil.h>
+ *
+ * This file is part of the x0 web server project and is released under LGPL-3.
+ * http://www.xzero.io/
+ *
+ * (c) 2009-2013 Christian Parpart <trapni@gmail.com>
+ */
+
+#include <xio/Api.h>
+#include <cstddef>
+
+namespace xio {
+
+//! \addtogroup base
+//@{
+
+/** Finds the first occurrence of \p needle within \p haystack.
+ *
+ * Uses SSE2 or AVX2 kernels (selected at runtime) filtering candidate
+ * positions by the needle's first and last byte, falling back to
+ * a scalar implementation on other platforms.
+ *
+ * @return pointer to the first match or \c nullptr if not found.
+ */
+XIO_API const char* memfind(const char* haystack, size_t haystackLength,
+		const char* needle, size_t needleLength);
+
+/** Finds the last occurrence of \p needle within \p haystack.
+ *
+ * @return pointer to the last match or \c nullptr if not found.
+ * @see memfind()
+ */
+XIO_API const char* memrfind(const char* haystack, size_t haystackLength,
+		const char* needle, size_t needleLength);
+
+/** Compares \p n bytes of \p a and \p b, ignoring ASCII case.
+ *
+ * Unlike strncasecmp() this is locale independent and does not stop at NUL bytes.
+ * Uses SSE2 or AVX2 kernels (selected at runtime) for longer inputs,
+ * and compares eight bytes at once (SWAR) otherwise.
+ */
+XIO_API bool memiequals(const char* a, const char* b, size_t n);
+
+/** Copies \p n bytes from \p src to \p dst, converting ASCII lowercase letters to uppercase.
+ *
+ * \p dst may be equal to \p src for in-place conversion, any other overlap is undefined.
+ * @see memiequals()
+ */
+XIO_API void memtoupper(char* dst, const char* src, size_t n);
+
+/** Copies \p n bytes from \p src to \p dst, converting ASCII uppercase letters to lowercase.
+ *
+ * \p dst may be equal to \p src for in-place conversion, any other overlap is undefined.
+ * @see memiequals()
+ */
+XIO_API void memtolower(char* dst, const char* src, size_t n);
+
+/** Writes the decimal representation of \p value into \p buf, which must provide room for 20 bytes.
+ *
+ * @return number of bytes written (not NUL-terminated).
+ */
+XIO_API size_t formatInteger(char* buf, unsigned long long value);
+
+/** Writes the decimal representation of \p value into \p buf, which must provide room for 20 bytes.
+ *
+ * @return number of bytes written (not NUL-terminated).
+ */
+XIO_API size_t formatInteger(char* buf, long long value);
+
+/** Writes the shortest representation of \p value that parses back to the very same value
+ * into \p buf, which must provide room for 32 bytes.
+ *
+ * The digits are computed with the Ryu algorithm, independent of the locale,
+ * and laid out like printf("%.17g") would.
+ *
+ * @return number of bytes written (not NUL-terminated).
+ */
+XIO_API size_t formatDouble(char* buf, double value);
+
+/** Parses the decimal digits at the beginning of the range [\p i, \p e).
+ *
+ * Runs of eight digits are validated and converted at once (SWAR).
+ *
+ * @param result receives the parsed value.
+ * @return pointer past the last digit parsed, \p i if there is no digit at all,
+ *         or \c nullptr if the value does not fit into an unsigned long long.
+ */
+XIO_API const char* parseDecimal(const char* i, const char* e, unsigned long long* result);
+
+/** Parses the whole range [\p i, \p e) as a decimal floating point number.
+ *
+ * Only plain decimal syntax is accepted, i.e. an optional sign, digits with an optional
+ * fraction, and an optional exponent; neither surrounding whitespace, nor hexadecimal,
+ * nor "nan" or "inf". The decimal point is always '.', independent of the locale.
+ *
+ * @retval true success, underflows into subnormals or zero included.
+ * @retval false invalid syntax (errno = EINVAL) or out of range (errno = ERANGE).
+ */
+XIO_API bool parseDouble(const char* i, const char* e, double* result);
+
+//@}
+
+} // namespace xio
@@ -0,0 +1,64 @@
+#pragma once
+/* <xio/ThreadPool.h>
+ *
+ * This file is part of the x0 web server project and is released under LGPL-3.
+ * http://www.xzero.io/
+ *
+ * (c) 2009-2013 Christian Parpart <trapni@gmail.com>
+ */
+
+#include <xio/Api.h>
+#include <functional>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <sys/types.h>
+
+namespace xio {
+
+class LoopExecutor;
+
+//! \addtogroup io
+//@{
+
+/** Bounded pool of threads for offloading blocking work, such as cold disk reads,
+ * off the event loop.
+ *
+ * Results are passed back to the issuing event loop's thread via its LoopExecutor.
+ */
+class XIO_API ThreadPool
+{
+public:
+	typedef std::function<void()> Task;
+
+	explicit ThreadPool(size_t threads = 4, size_t maxQueued = 1024);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	size_t size() const { return threads_.size(); }
+	size_t maxQueued() const { return maxQueued_; }
+	size_t queued() const;
+
+	bool post(Task task);
+	bool post(LoopExecutor* executor, std::function<ssize_t()> work, std::function<void(ssize_t)> done);
+
+	void stop();
+
+private:
+	void run();
+
+	size_t maxQueued_;
+	bool stopped_;
+	mutable std::mutex lock_;
+	std::condition_variable cond_;
+	std::deque<Task> tasks_;
+	std::vector<std::thread> threads_;
+};
+
+//@}
+
+} // namespace xio
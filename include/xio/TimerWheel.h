@@ -0,0 +1,139 @@
+#pragma once
+/* <xio/TimerWheel.h>
+ *
+ * This file is part of the x0 web server project and is released under LGPL-3.
+ * http://www.xzero.io/
+ *
+ * (c) 2009-2013 Christian Parpart <trapni@gmail.com>
+ */
+
+#include <xio/Api.h>
+#include <xio/TimeSpan.h>
+#include <cstdint>
+#include <vector>
+#include <ev++.h>
+
+namespace xio {
+
+//! \addtogroup io
+//@{
+
+/** Hashed timer wheel for large amounts of coarse-grained timeouts.
+ *
+ * Starting, re-arming and stopping a timer are O(1) list operations,
+ * whereas each ev::timer costs a heap operation inside libev.
+ * Expired timers are collected by a single ev::timer ticking at the
+ * wheel's resolution, thus, timers may fire up to one resolution late.
+ *
+ * The ticking timer is only active as long as the wheel holds active timers.
+ *
+ * \note this class is not thread-safe, use one wheel per event loop.
+ */
+class XIO_API TimerWheel
+{
+public:
+	class Timer;
+
+	explicit TimerWheel(struct ev_loop* loop, TimeSpan resolution = TimeSpan::fromMilliseconds(10), size_t slots = 4096);
+	~TimerWheel();
+
+	TimerWheel(const TimerWheel&) = delete;
+	TimerWheel& operator=(const TimerWheel&) = delete;
+
+	struct ev_loop* loop() const { return loop_; }
+	TimeSpan resolution() const { return resolution_; }
+	size_t size() const { return size_; }
+
+	void start(Timer* timer, TimeSpan timeout);
+	void stop(Timer* timer);
+
+private:
+	uint64_t currentTick() const;
+	void link(Timer* timer, uint64_t expiry);
+	void unlink(Timer* timer);
+	void onTick(ev::timer&, int);
+
+	struct ev_loop* loop_;
+	TimeSpan resolution_;
+	std::vector<Timer*> slots_;
+	Timer* expired_; //!< timers about to fire within the current tick
+	size_t size_;
+	uint64_t lastTick_;
+	ev::timer ticker_;
+};
+
+/** Timer entry, to be started on a TimerWheel.
+ *
+ * The entry is an intrusive list node, thus no memory is allocated
+ * when (re-)starting it.
+ */
+class XIO_API TimerWheel::Timer
+{
+public:
+	Timer();
+	~Timer();
+
+	Timer(const Timer&) = delete;
+	Timer& operator=(const Timer&) = delete;
+
+	bool isActive() const { return wheel_ != nullptr; }
+	void stop();
+
+	template<typename K, void (K::*cb)(Timer&)>
+	void set(K* object);
+
+private:
+	friend class TimerWheel;
+
+	template<typename K, void (K::*cb)(Timer&)>
+	static void callback_thunk(Timer& timer);
+
+	TimerWheel* wheel_;
+	Timer* prev_;
+	Timer* next_;
+	uint64_t expiry_;
+
+	void (*callback_)(Timer&);
+	void* callbackData_;
+};
+
+//@}
+
+// {{{ inlines
+inline TimerWheel::Timer::Timer() :
+	wheel_(nullptr),
+	prev_(nullptr),
+	next_(nullptr),
+	expiry_(0),
+	callback_(nullptr),
+	callbackData_(nullptr)
+{
+}
+
+inline TimerWheel::Timer::~Timer()
+{
+	stop();
+}
+
+inline void TimerWheel::Timer::stop()
+{
+	if (wheel_) {
+		wheel_->stop(this);
+	}
+}
+
+template<typename K, void (K::*cb)(TimerWheel::Timer&)>
+inline void TimerWheel::Timer::set(K* object)
+{
+	callback_ = &callback_thunk<K, cb>;
+	callbackData_ = object;
+}
+
+template<typename K, void (K::*cb)(TimerWheel::Timer&)>
+void TimerWheel::Timer::callback_thunk(Timer& timer)
+{
+	(static_cast<K*>(timer.callbackData_)->*cb)(timer);
+}
+// }}}
+
+} // namespace xio
@@ -0,0 +1,102 @@
+#pragma once
+/* <xio/WorkerGroup.h>
+ *
+ * This file is part of the x0 web server project and is released under LGPL-3.
+ * http://www.xzero.io/
+ *
+ * (c) 2009-2013 Christian Parpart <trapni@gmail.com>
+ */
+
+#include <xio/Api.h>
+#include <xio/LoopExecutor.h>
+#include <functional>
+#include <memory>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <ev++.h>
+
+namespace xio {
+
+class ServerSocket;
+
+//! \addtogroup io
+//@{
+
+/** Runs one event loop per thread (usually one per CPU core).
+ *
+ * Listeners passed to listen() are cloned into every worker's loop, so accepting
+ * and all I/O on accepted client sockets is spread across all workers.
+ *
+ * \see ServerSocket::clone()
+ */
+class XIO_API WorkerGroup
+{
+public:
+	class Worker;
+
+	explicit WorkerGroup(size_t count = 0, bool pinned = true);
+	~WorkerGroup();
+
+	WorkerGroup(const WorkerGroup&) = delete;
+	WorkerGroup& operator=(const WorkerGroup&) = delete;
+
+	size_t size() const { return workers_.size(); }
+	Worker* worker(size_t index) const { return workers_[index].get(); }
+	struct ev_loop* loop(size_t index) const;
+
+	bool isPinned() const { return pinned_; }
+	bool isRunning() const { return running_; }
+
+	bool listen(ServerSocket* listener);
+
+	void start();
+	void stop();
+	void join();
+
+	void post(std::function<void()> task);
+	void post(size_t index, std::function<void()> task);
+
+private:
+	std::vector<std::unique_ptr<Worker>> workers_;
+	bool pinned_;
+	bool running_;
+	std::atomic<size_t> nextWorker_;
+};
+
+/** A single thread running its own event loop within a WorkerGroup.
+ */
+class XIO_API WorkerGroup::Worker
+{
+public:
+	Worker(WorkerGroup* group, size_t id, int cpu);
+	~Worker();
+
+	size_t id() const { return id_; }
+	int cpu() const { return cpu_; }
+	struct ev_loop* loop() const { return loop_; }
+	LoopExecutor* executor() const { return executor_.get(); }
+
+	void post(std::function<void()> task);
+
+	void start();
+	void stop();
+	void join();
+
+private:
+	friend class WorkerGroup;
+
+	void run();
+
+	WorkerGroup* group_;
+	size_t id_;
+	int cpu_;
+	struct ev_loop* loop_;
+	std::unique_ptr<LoopExecutor> executor_;
+	std::vector<std::unique_ptr<ServerSocket>> listeners_;
+	std::thread thread_;
+};
+
+//@}
+
+} // namespace xio
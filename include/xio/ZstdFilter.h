@@ -0,0 +1,54 @@
+#pragma once
+/* <xio/ZstdFilter.h>
+ *
+ * This file is part of the x0 web server project and is released under LGPL-3.
+ * http://www.xzero.io/
+ *
+ * (c) 2009-2013 Christian Parpart <trapni@gmail.com>
+ */
+
+#include <xio/Api.h>
+#include <xio/Filter.h>
+
+struct ZSTD_CCtx_s;
+
+namespace xio {
+
+//! \addtogroup io
+//@{
+
+/** Streaming Zstandard compressor, producing the \c zstd HTTP content-coding (RFC 8878).
+ *
+ * Works like DeflateFilter: the compression context is kept across process() calls,
+ * flush() ends the current block and finish() ends the frame, resetting the
+ * context for the next one.
+ *
+ * zstd support is optional, check isSupported(), otherwise all operations fail with ENOSYS.
+ */
+class XIO_API ZstdFilter : public Filter
+{
+public:
+	explicit ZstdFilter(int level = 3);
+	~ZstdFilter();
+
+	ZstdFilter(const ZstdFilter&) = delete;
+	ZstdFilter& operator=(const ZstdFilter&) = delete;
+
+	static bool isSupported();
+
+	int level() const { return level_; }
+
+	virtual ssize_t process(const BufferRef& input, Buffer& output);
+	virtual ssize_t flush(Buffer& output);
+	virtual ssize_t finish(Buffer& output);
+
+private:
+	ssize_t compress(const BufferRef& input, Buffer& output, int mode);
+
+	int level_;
+	struct ZSTD_CCtx_s* ctx_;
+};
+
+//@}
+
+} // namespace xio
@@ -1 +1,27 @@
 #pragma once
+
+#cmakedefine HAVE_FCNTL_H 1
+#cmakedefine HAVE_NETDB_H 1
+
+#cmakedefine HAVE_SYS_SENDFILE_H 1
+#cmakedefine HAVE_SENDFILE 1
+#cmakedefine HAVE_POSIX_FADVISE 1
+#cmakedefine HAVE_READAHEAD 1
+
+#cmakedefine HAVE_SYS_RESOURCE_H 1
+#cmakedefine HAVE_SYS_MMAN_H 1
+#cmakedefine HAVE_MEMFD_CREATE 1
+#cmakedefine HAVE_SYS_LIMITS_H 1
+#cmakedefine HAVE_SYS_INOTIFY_H 1
+#cmakedefine HAVE_INOTIFY_INIT1 1
+#cmakedefine HAVE_LINUX_IO_URING_H 1
+
+#cmakedefine HAVE_ZLIB_H 1
+#cmakedefine HAVE_LIBZ 1
+#cmakedefine HAVE_ZSTD_H 1
+#cmakedefine HAVE_LIBZSTD 1
+
+#cmakedefine HAVE_FORK 1
+#cmakedefine HAVE_CHROOT 1
+#cmakedefine HAVE_PATHCONF 1
+#cmakedefine HAVE_ACCEPT4 1
@@ -7,15 +7,267 @@
  */
 
 #include <xio/Buffer.h>
+#include <algorithm>
+#include <climits>
 #include <cstdio>
 
 namespace xio {
 
+// {{{ SystemBufferAllocator
+/* Plain realloc() based allocation, growing linearly in steps of \p Buffer::CHUNK_SIZE.
+ */
+class SystemBufferAllocator : public BufferAllocator {
+public:
+	size_t grow(size_t capacity, size_t required) const
+	{
+		// pad up to CHUNK_SIZE
+		required = required - 1;
+		return required + Buffer::CHUNK_SIZE - (required % Buffer::CHUNK_SIZE);
+	}
+
+	char* allocate(size_t capacity)
+	{
+		return static_cast<char*>(std::malloc(capacity));
+	}
+
+	char* reallocate(char* data, size_t capacity, size_t newCapacity)
+	{
+		return static_cast<char*>(std::realloc(data, newCapacity));
+	}
+
+	void deallocate(char* data, size_t capacity)
+	{
+		std::free(data);
+	}
+};
+// }}}
+// {{{ SlabBufferAllocator
+/* Size-class based allocation with per-thread caches of released blocks.
+ *
+ * Capacities up to MAX_SIZE are served from power-of-two size classes,
+ * thus, growing within a size class never moves the data, and released
+ * blocks are kept in a per-thread free list for reuse.
+ * Blocks are plain heap blocks, so it is safe to release them on any thread.
+ * Larger capacities are directly passed to realloc().
+ *
+ * Buffers grow geometrically (doubling) rather than linearly.
+ */
+class SlabBufferAllocator : public BufferAllocator {
+public:
+	enum {
+		MIN_SHIFT = 5,                 // 32 bytes
+		MAX_SHIFT = 16,                // 64 KB
+		MAX_SIZE = 1 << MAX_SHIFT,
+		CLASS_COUNT = MAX_SHIFT - MIN_SHIFT + 1,
+		CACHE_BYTES = 256 * 1024,      // per size class and thread
+		PAGE_SIZE = 4096,
+	};
+
+	size_t grow(size_t capacity, size_t required) const
+	{
+		size_t value = std::max(required, capacity * 2);
+
+		if (value <= MAX_SIZE)
+			return classSize(sizeClass(value));
+
+		// grow by 1.5 beyond the largest size class, page aligned
+		value = std::max(required, capacity + capacity / 2) - 1;
+		return value + PAGE_SIZE - (value % PAGE_SIZE);
+	}
+
+	char* allocate(size_t capacity)
+	{
+		if (capacity > MAX_SIZE)
+			return static_cast<char*>(std::malloc(capacity));
+
+		return cache().pop(sizeClass(capacity));
+	}
+
+	char* reallocate(char* data, size_t capacity, size_t newCapacity)
+	{
+		if (capacity > MAX_SIZE && newCapacity > MAX_SIZE)
+			return static_cast<char*>(std::realloc(data, newCapacity));
+
+		if (capacity <= MAX_SIZE && newCapacity <= MAX_SIZE && sizeClass(capacity) == sizeClass(newCapacity))
+			return data;
+
+		char* result = allocate(newCapacity);
+		if (!result)
+			return nullptr;
+
+		std::memcpy(result, data, std::min(capacity, newCapacity));
+		deallocate(data, capacity);
+		return result;
+	}
+
+	void deallocate(char* data, size_t capacity)
+	{
+		if (capacity > MAX_SIZE)
+			std::free(data);
+		else
+			cache().push(sizeClass(capacity), data);
+	}
+
+private:
+	static unsigned sizeClass(size_t capacity)
+	{
+		if (capacity <= (1 << MIN_SHIFT))
+			return 0;
+
+		// ceil(log2(capacity)) - MIN_SHIFT
+		return (sizeof(unsigned long) * CHAR_BIT - __builtin_clzl(capacity - 1)) - MIN_SHIFT;
+	}
+
+	static size_t classSize(unsigned sc)
+	{
+		return static_cast<size_t>(1) << (sc + MIN_SHIFT);
+	}
+
+	struct Block {
+		Block* next;
+	};
+
+	struct Cache {
+		Block* blocks[CLASS_COUNT];
+		size_t count[CLASS_COUNT];
+
+		Cache()
+		{
+			for (unsigned sc = 0; sc < CLASS_COUNT; ++sc) {
+				blocks[sc] = nullptr;
+				count[sc] = 0;
+			}
+		}
+
+		~Cache()
+		{
+			for (unsigned sc = 0; sc < CLASS_COUNT; ++sc) {
+				while (Block* b = blocks[sc]) {
+					blocks[sc] = b->next;
+					std::free(b);
+				}
+			}
+		}
+
+		char* pop(unsigned sc)
+		{
+			if (Block* b = blocks[sc]) {
+				blocks[sc] = b->next;
+				--count[sc];
+				return reinterpret_cast<char*>(b);
+			}
+
+			return static_cast<char*>(std::malloc(classSize(sc)));
+		}
+
+		void push(unsigned sc, char* data)
+		{
+			if (count[sc] * classSize(sc) >= CACHE_BYTES) {
+				std::free(data);
+				return;
+			}
+
+			Block* b = reinterpret_cast<Block*>(data);
+			b->next = blocks[sc];
+			blocks[sc] = b;
+			++count[sc];
+		}
+	};
+
+	static Cache& cache()
+	{
+		static thread_local Cache cache_;
+		return cache_;
+	}
+};
+// }}}
+// {{{ InlineBufferAllocator
+InlineBufferAllocator::InlineBufferAllocator(char* storage, size_t capacity, BufferAllocator* backend) :
+	storage_(storage),
+	capacity_(capacity),
+	backend_(backend)
+{
+}
+
+size_t InlineBufferAllocator::grow(size_t capacity, size_t required) const
+{
+	return required <= capacity_ ? capacity_ : backend_->grow(capacity, required);
+}
+
+char* InlineBufferAllocator::allocate(size_t capacity)
+{
+	return capacity <= capacity_ ? storage_ : backend_->allocate(capacity);
+}
+
+char* InlineBufferAllocator::reallocate(char* data, size_t capacity, size_t newCapacity)
+{
+	if (data != storage_)
+		return backend_->reallocate(data, capacity, newCapacity);
+
+	if (newCapacity <= capacity_)
+		return storage_;
+
+	// spill over to the heap
+	char* result = backend_->allocate(newCapacity);
+	if (result)
+		memcpy(result, storage_, std::min(capacity, newCapacity));
+
+	return result;
+}
+
+void InlineBufferAllocator::deallocate(char* data, size_t capacity)
+{
+	if (data != storage_) {
+		backend_->deallocate(data, capacity);
+	}
+}
+
+BufferAllocator* InlineBufferAllocator::transfer(const char* data)
+{
+	return data != storage_ ? backend_ : nullptr;
+}
+// }}}
+// {{{ BufferAllocator
+static BufferAllocator* defaultAllocator_ = nullptr;
+
+/** Retrieves the allocator growing linearly via realloc().
+ */
+BufferAllocator* BufferAllocator::system()
+{
+	static SystemBufferAllocator allocator;
+	return &allocator;
+}
+
+/** Retrieves the allocator serving from per-thread size-class caches, growing geometrically.
+ */
+BufferAllocator* BufferAllocator::slab()
+{
+	static SlabBufferAllocator allocator;
+	return &allocator;
+}
+
+/** Retrieves the allocator newly constructed buffers use.
+ */
+BufferAllocator* BufferAllocator::defaultAllocator()
+{
+	return defaultAllocator_ ? defaultAllocator_ : slab();
+}
+
+/** Sets the allocator newly constructed buffers use.
+ *
+ * Buffers keep the allocator they have been constructed with.
+ */
+void BufferAllocator::setDefaultAllocator(BufferAllocator* allocator)
+{
+	defaultAllocator_ = allocator;
+}
+// }}}
+
 /*! changes the capacity of the underlying buffer, possibly reallocating into more or less bytes reserved.
  *
  * This method either increases or decreases the reserved memory.
- * If it increases the size, and it is not the first capacity change, it will be aligned 
- * to \p CHUNK_SIZE bytes, otherwise the exact size will be reserved.
+ * If it increases the size, and it is not the first capacity change, the new capacity
+ * is determined by the buffer's allocator growth policy, otherwise the exact size will be reserved.
  * If the requested size is lower than the current capacity, then the underlying storage
  * will be redused to exactly this size and the actually used buffer size is cut down
  * to the available capacity if it would exceed the capacity otherwise.
@@ -26,20 +278,24 @@ namespace xio {
  *
  * \retval true the requested capacity is available. go ahead.
  * \retval false could not change capacity. take caution!
+ *
+ * \see BufferAllocator
  */
 bool Buffer::setCapacity(std::size_t value)
 {
-	if (value == 0 && capacity_) {
-		free(data_);
-		capacity_ = 0;
+	if (value == 0) {
+		if (capacity_) {
+			allocator_->deallocate(data_, capacity_);
+			data_ = nullptr;
+			capacity_ = 0;
+			size_ = 0;
+		}
 		return true;
 	}
 
 	if (value > capacity_) {
 		if (capacity_) {
-			// pad up to CHUNK_SIZE, only if continuous regrowth)
-			value = value - 1;
-			value = value + CHUNK_SIZE - (value % CHUNK_SIZE);
+			value = allocator_->grow(capacity_, value);
 		}
 	} else if (value < capacity_) {
 		// possibly adjust the actual used size
@@ -49,15 +305,15 @@ bool Buffer::setCapacity(std::size_t value)
 		// nothing changed
 		return true;
 
-	if (char* rp = static_cast<value_type *>(std::realloc(data_, value))) {
+	char* rp = capacity_
+		? allocator_->reallocate(data_, capacity_, value)
+		: allocator_->allocate(value);
+
+	if (rp) {
 		// setting capacity succeed.
 		data_ = rp;
 		capacity_ = value;
 		return true;
-	} else if (value == 0) {
-		// freeing all Memory succeed.
-		capacity_ = value;
-		return true;
 	} else {
 		// setting capacity failed, do not change anything.
 		return false;
@@ -1,11 +1,11 @@
 #include <xio/BufferStream.h>
 #include <xio/StreamVisitor.h>
+#include <xio/MemoryBudget.h>
 #include <xio/Pipe.h>
+#include <xio/Socket.h>
 #include <algorithm>
 #include <cstring>
 
-// TODO socket functions
-
 namespace xio {
 
 BufferStream::BufferStream(size_t cap) :
@@ -14,10 +14,31 @@ BufferStream::BufferStream(size_t cap) :
 {
 }
 
+/*! initializes a stream whose memory is charged to the given budget.
+ *
+ * Writes fail with EAGAIN once the budget is exhausted.
+ *
+ * \param budget the budget to charge, must outlive this stream.
+ * \param cap initial capacity to reserve, the stream's capacity stays 0 if that exceeds the budget.
+ */
+BufferStream::BufferStream(MemoryBudget* budget, size_t cap) :
+	data_(budget->allocator()),
+	readOffset_(0)
+{
+	if (cap)
+		data_.reserve(cap);
+}
+
 BufferStream::~BufferStream()
 {
 }
 
+void BufferStream::clear()
+{
+	readOffset_ = 0;
+	data_.clear();
+}
+
 size_t BufferStream::size() const
 {
 	return writeOffset() - readOffset_;
@@ -33,23 +54,47 @@ void BufferStream::shift(size_t n)
 	}
 }
 
+/*! ensures space for up to \p size more bytes.
+ *
+ * \return number of bytes that can be appended, which is less than \p size if growing failed
+ *         (errno set to EAGAIN for an exhausted budget, or ENOMEM).
+ */
+size_t BufferStream::writable(size_t size)
+{
+	data_.reserve(data_.size() + size);
+	return std::min(capacity() - writeOffset(), size);
+}
+
 ssize_t BufferStream::write(const char* buf, size_t size)
 {
-	size_t n = data_.size();
+	size_t n = writable(size);
+	if (n < size)
+		return -1;
+
 	data_.push_back(buf, size);
-	return data_.size() - n;
+	return size;
 }
 
 ssize_t BufferStream::write(Socket* socket, size_t size, Mode /*mode*/)
 {
-	return 0; // TODO
+	ssize_t n = writable(size);
+	if (n == 0 && size != 0)
+		return -1;
+
+	n = socket->read(rwdata() + writeOffset(), n);
+
+	if (n > 0)
+		data_.resize(data_.size() + n);
+
+	return n;
 }
 
 ssize_t BufferStream::write(Pipe* pipe, size_t size, Mode /*mode*/)
 {
-	data_.reserve(data_.size() + size);
+	ssize_t n = writable(size);
+	if (n == 0 && size != 0)
+		return -1;
 
-	ssize_t n = std::min(capacity() - writeOffset(), size);
 	n = pipe->read(rwdata() + writeOffset(), n);
 
 	if (n > 0)
@@ -60,9 +105,10 @@ ssize_t BufferStream::write(Pipe* pipe, size_t size, Mode /*mode*/)
 
 ssize_t BufferStream::write(int fd, size_t size)
 {
-	data_.reserve(data_.size() + size);
+	ssize_t n = writable(size);
+	if (n == 0 && size != 0)
+		return -1;
 
-	ssize_t n = std::min(capacity() - writeOffset(), size);
 	n = ::read(fd, rwdata() + writeOffset(), n);
 
 	if (n > 0)
@@ -92,14 +138,19 @@ ssize_t BufferStream::read(char* buf, size_t size)
 
 ssize_t BufferStream::read(Socket* socket, size_t size)
 {
-	return 0; // TODO
+	ssize_t n = socket->write(data() + readOffset(), std::min(this->size(), size));
+	if (n > 0) {
+		shift(n);
+	}
+
+	return n;
 }
 
 ssize_t BufferStream::read(Pipe* pipe, size_t size)
 {
-	ssize_t n = pipe->write(data(), std::min(this->size(), size));
+	ssize_t n = pipe->write(data() + readOffset(), std::min(this->size(), size));
 	if (n > 0) {
-		readOffset_ += n;
+		shift(n);
 	}
 
 	return n;
@@ -107,9 +158,9 @@ ssize_t BufferStream::read(Pipe* pipe, size_t size)
 
 ssize_t BufferStream::read(int fd, size_t size)
 {
-	ssize_t n = ::write(fd, data(), std::min(this->size(), size));
+	ssize_t n = ::write(fd, data() + readOffset(), std::min(this->size(), size));
 	if (n > 0) {
-		readOffset_ += n;
+		shift(n);
 	}
 
 	return n;
@@ -0,0 +1,41 @@
+/* <xio/CaseFilter.cpp>
+ *
+ * This file is part of the x0 web server project and is released under LGPL-3.
+ * http://www.xzero.io/
+ *
+ * (c) 2009-2013 Christian Parpart <trapni@gmail.com>
+ */
+
+#include <xio/CaseFilter.h>
+#include <xio/StringUtil.h>
+#include <errno.h>
+
+namespace xio {
+
+ssize_t UpperCaseFilter::process(const BufferRef& input, Buffer& output)
+{
+	if (!output.reserve(output.size() + input.size())) {
+		errno = ENOMEM;
+		return -1;
+	}
+
+	memtoupper(output.data() + output.size(), input.data(), input.size());
+	output.resize(output.size() + input.size());
+
+	return input.size();
+}
+
+ssize_t LowerCaseFilter::process(const BufferRef& input, Buffer& output)
+{
+	if (!output.reserve(output.size() + input.size())) {
+		errno = ENOMEM;
+		return -1;
+	}
+
+	memtolower(output.data() + output.size(), input.data(), input.size());
+	output.resize(output.size() + input.size());
+
+	return input.size();
+}
+
+} // namespace xio
@@ -0,0 +1,298 @@
+/* <xio/ChunkedDecoder.cpp>
+ *
+ * This file is part of the x0 web server project and is released under LGPL-3.
+ * http://www.xzero.io/
+ *
+ * (c) 2009-2013 Christian Parpart <trapni@gmail.com>
+ */
+
+#include <xio/ChunkedDecoder.h>
+#include <xio/Buffer.h>
+#include <algorithm>
+#include <cstring>
+#include <errno.h>
+
+namespace xio {
+
+//! more hex digits could overflow the chunk size
+static const unsigned MAX_SIZE_DIGITS = 2 * sizeof(size_t) - 1;
+
+//! tchar as of RFC 7230, section 3.2.6
+static inline bool isToken(char c)
+{
+	return (c >= '0' && c <= '9') || ((c | 0x20) >= 'a' && (c | 0x20) <= 'z')
+		|| (c != 0 && std::strchr("!#$%&'*+-.^_`|~", c) != nullptr);
+}
+
+//! BWS as of RFC 7230, section 3.2.3
+static inline bool isSpace(char c)
+{
+	return c == ' ' || c == '\t';
+}
+
+static inline int hexValue(char c)
+{
+	if (c >= '0' && c <= '9')
+		return c - '0';
+
+	c |= 0x20;
+	if (c >= 'a' && c <= 'f')
+		return c - 'a' + 10;
+
+	return -1;
+}
+
+ChunkedDecoder::ChunkedDecoder() :
+	state_(SIZE),
+	size_(0),
+	digits_(0),
+	unconsumed_(0)
+{
+}
+
+/*! prepares the decoder for the next message body.
+ */
+void ChunkedDecoder::reset()
+{
+	state_ = SIZE;
+	size_ = 0;
+	digits_ = 0;
+	unconsumed_ = 0;
+}
+
+ssize_t ChunkedDecoder::fail()
+{
+	state_ = ERROR;
+	errno = EBADMSG;
+	return -1;
+}
+
+/*! advances through the chunk extensions of a chunk size line (RFC 7230, section 4.1.1).
+ *
+ * \code
+ * chunk-ext     = *( BWS ";" BWS chunk-ext-name [ BWS "=" BWS chunk-ext-val ] )
+ * chunk-ext-val = token / quoted-string
+ * \endcode
+ *
+ * \retval true the character has been accepted.
+ * \retval false the character is not valid at this point.
+ */
+bool ChunkedDecoder::extension(char ch)
+{
+	const unsigned char uch = static_cast<unsigned char>(ch);
+
+	switch (state_) {
+		case EXT_NAME_START:
+			if (isSpace(ch))
+				return true;
+
+			if (!isToken(ch))
+				return false;
+
+			state_ = EXT_NAME;
+			return true;
+		case EXT_NAME:
+			if (isToken(ch))
+				return true;
+
+			state_ = EXT_AFTER_NAME;
+			return extension(ch);
+		case EXT_AFTER_NAME:
+			if (isSpace(ch))
+				return true;
+
+			if (ch == '=') {
+				state_ = EXT_VALUE_START;
+				return true;
+			}
+
+			state_ = EXT_END;
+			return extension(ch);
+		case EXT_VALUE_START:
+			if (isSpace(ch))
+				return true;
+
+			if (ch == '"') {
+				state_ = EXT_QUOTED;
+				return true;
+			}
+
+			if (!isToken(ch))
+				return false;
+
+			state_ = EXT_VALUE;
+			return true;
+		case EXT_VALUE:
+			if (isToken(ch))
+				return true;
+
+			state_ = EXT_END;
+			return extension(ch);
+		case EXT_QUOTED:
+			// qdtext: HTAB, SP, VCHAR except '"' and '\', obs-text
+			if (ch == '"')
+				state_ = EXT_END;
+			else if (ch == '\\')
+				state_ = EXT_QUOTED_PAIR;
+			else if (uch < 0x20 ? ch != '\t' : uch == 0x7F)
+				return false;
+
+			return true;
+		case EXT_QUOTED_PAIR:
+			if (uch < 0x20 ? ch != '\t' : uch == 0x7F)
+				return false;
+
+			state_ = EXT_QUOTED;
+			return true;
+		case EXTENSION:
+		case EXT_END:
+			if (isSpace(ch))
+				return true;
+
+			if (ch == ';') {
+				state_ = EXT_NAME_START;
+				return true;
+			}
+
+			if (ch == '\r') {
+				state_ = SIZE_LF;
+				return true;
+			}
+
+			if (ch == '\n') {
+				state_ = size_ ? DATA : TRAILER_START;
+				return true;
+			}
+
+			return false;
+		case SIZE_LF:
+			if (ch != '\n')
+				return false;
+
+			state_ = size_ ? DATA : TRAILER_START;
+			return true;
+		default:
+			return false;
+	}
+}
+
+/*! decodes the given piece of the message body.
+ *
+ * \return number of payload bytes appended to \p output, or -1 with errno set to EBADMSG.
+ */
+ssize_t ChunkedDecoder::process(const BufferRef& input, Buffer& output)
+{
+	if (state_ == ERROR)
+		return fail();
+
+	const char* i = input.data();
+	const char* e = i + input.size();
+	const size_t before = output.size();
+
+	while (i != e && state_ != END) {
+		switch (state_) {
+			case SIZE: {
+				int value = hexValue(*i);
+				if (value >= 0) {
+					if (digits_ == MAX_SIZE_DIGITS)
+						return fail();
+
+					size_ = size_ * 16 + value;
+					++digits_;
+					++i;
+					break;
+				}
+
+				if (digits_ == 0)
+					return fail();
+
+				state_ = EXTENSION;
+				break;
+			}
+			case EXTENSION:
+			case EXT_NAME_START:
+			case EXT_NAME:
+			case EXT_AFTER_NAME:
+			case EXT_VALUE_START:
+			case EXT_VALUE:
+			case EXT_QUOTED:
+			case EXT_QUOTED_PAIR:
+			case EXT_END:
+			case SIZE_LF:
+				if (!extension(*i))
+					return fail();
+
+				++i;
+				break;
+			case DATA: {
+				size_t n = std::min(size_, static_cast<size_t>(e - i));
+				output.push_back(i, n);
+				i += n;
+				size_ -= n;
+
+				if (size_ == 0)
+					state_ = DATA_CR;
+				break;
+			}
+			case DATA_CR:
+				if (*i == '\r') {
+					state_ = DATA_LF;
+				} else if (*i == '\n') {
+					digits_ = 0;
+					state_ = SIZE;
+				} else {
+					return fail();
+				}
+
+				++i;
+				break;
+			case DATA_LF:
+				if (*i != '\n')
+					return fail();
+
+				++i;
+				digits_ = 0;
+				state_ = SIZE;
+				break;
+			case TRAILER_START:
+				if (*i == '\r') {
+					state_ = END_LF;
+				} else if (*i == '\n') {
+					state_ = END;
+				} else {
+					state_ = TRAILER;
+					break;
+				}
+
+				++i;
+				break;
+			case TRAILER: {
+				auto lf = static_cast<const char*>(memchr(i, '\n', e - i));
+				if (!lf) {
+					i = e;
+					break;
+				}
+
+				i = lf + 1;
+				state_ = TRAILER_START;
+				break;
+			}
+			case END_LF:
+				if (*i != '\n')
+					return fail();
+
+				++i;
+				state_ = END;
+				break;
+			case END:
+			case ERROR:
+				break;
+		}
+	}
+
+	unconsumed_ = e - i;
+
+	return output.size() - before;
+}
+
+} // namespace xio
@@ -0,0 +1,157 @@
+/* <xio/ChunkedEncoder.cpp>
+ *
+ * This file is part of the x0 web server project and is released under LGPL-3.
+ * http://www.xzero.io/
+ *
+ * (c) 2009-2013 Christian Parpart <trapni@gmail.com>
+ */
+
+#include <xio/ChunkedEncoder.h>
+#include <xio/ChunkedStream.h>
+#include <xio/Buffer.h>
+#include <xio/Pipe.h>
+#include <algorithm>
+#include <errno.h>
+
+namespace xio {
+
+//! room for the hex digits of any size_t plus CRLF
+static const size_t MAX_HEADER_SIZE = 2 * sizeof(size_t) + 2;
+
+static const char lastChunk[] = "0\r\n\r\n";
+
+/*! writes the chunk header (size in hex digits, followed by CRLF) for \p size bytes into \p buf.
+ *
+ * \return number of bytes written.
+ */
+static size_t formatHeader(char* buf, size_t size)
+{
+	static const char digits[] = "0123456789abcdef";
+	char tmp[2 * sizeof(size_t)];
+	size_t n = 0;
+
+	do {
+		tmp[n++] = digits[size & 0xF];
+		size >>= 4;
+	} while (size);
+
+	for (size_t i = 0; i < n; ++i)
+		buf[i] = tmp[n - i - 1];
+
+	buf[n++] = '\r';
+	buf[n++] = '\n';
+
+	return n;
+}
+
+ChunkedEncoder::ChunkedEncoder() :
+	finished_(false)
+{
+}
+
+/*! frames \p input as one chunk.
+ *
+ * Empty input is skipped, as an empty chunk would end the body.
+ */
+ssize_t ChunkedEncoder::process(const BufferRef& input, Buffer& output)
+{
+	if (input.empty())
+		return 0;
+
+	if (!output.reserve(output.size() + MAX_HEADER_SIZE + input.size() + 2)) {
+		errno = ENOMEM;
+		return -1;
+	}
+
+	const size_t before = output.size();
+	char header[MAX_HEADER_SIZE];
+
+	output.push_back(header, formatHeader(header, input.size()));
+	output.push_back(input);
+	output.push_back("\r\n", 2);
+
+	return output.size() - before;
+}
+
+/*! emits the last chunk, with an empty trailer.
+ */
+ssize_t ChunkedEncoder::finish(Buffer& output)
+{
+	finished_ = true;
+	output.push_back(lastChunk);
+
+	return sizeof(lastChunk) - 1;
+}
+
+/*! appends \p buf as one chunk to \p output.
+ *
+ * \return \p size, or -1 if \p output did not accept the data (e.g. EAGAIN for an exhausted memory budget),
+ *         in which case \p output is left with a partial chunk and must not be sent any further.
+ */
+ssize_t ChunkedEncoder::write(ChunkedStream* output, const char* buf, size_t size)
+{
+	if (size == 0)
+		return 0;
+
+	char header[MAX_HEADER_SIZE];
+
+	if (output->write(header, formatHeader(header, size)) < 0)
+		return -1;
+
+	if (output->write(buf, size) != static_cast<ssize_t>(size))
+		return -1;
+
+	if (output->write("\r\n", 2) < 0)
+		return -1;
+
+	return size;
+}
+
+/*! moves up to \p size bytes out of \p payload, appending them as one chunk to \p output.
+ *
+ * The payload is spliced into a pipe chunk of \p output. Only if that pipe is full,
+ * the remainder is copied into a memory chunk instead.
+ *
+ * \return number of payload bytes taken (bounded by the bytes available in \p payload),
+ *         or -1 on failure, in which case \p output is left with a partial chunk and
+ *         must not be sent any further.
+ */
+ssize_t ChunkedEncoder::write(ChunkedStream* output, Pipe* payload, size_t size)
+{
+	size = std::min(size, payload->size());
+	if (size == 0)
+		return 0;
+
+	char header[MAX_HEADER_SIZE];
+
+	if (output->write(header, formatHeader(header, size)) < 0)
+		return -1;
+
+	for (size_t moved = 0; moved < size; ) {
+		ssize_t rv = output->write(payload, size - moved, Stream::MOVE);
+
+		if (rv <= 0)
+			rv = output->write(payload, size - moved, Stream::COPY);
+
+		if (rv <= 0)
+			return -1;
+
+		moved += rv;
+	}
+
+	if (output->write("\r\n", 2) < 0)
+		return -1;
+
+	return size;
+}
+
+/*! appends the last chunk, with an empty trailer, to \p output.
+ */
+bool ChunkedEncoder::finish(ChunkedStream* output)
+{
+	finished_ = true;
+
+	return output->write(lastChunk, sizeof(lastChunk) - 1) == sizeof(lastChunk) - 1;
+}
+
+} // namespace xio
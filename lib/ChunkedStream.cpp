@@ -1,53 +1,132 @@
 #include <xio/ChunkedStream.h>
 #include <xio/Pipe.h>
+#include <xio/PipePool.h>
 #include <xio/BufferStream.h>
+#include <xio/MemoryBudget.h>
 #include <xio/StreamVisitor.h>
+#include <xio/Socket.h>
 
+#include <sys/uio.h>
+#include <climits>
 #include <fcntl.h>
 
+#if !defined(IOV_MAX)
+#	define IOV_MAX 1024
+#endif
+
 namespace xio {
 
-bool ChunkedStream::empty() const
+/* Upper bounds on the drained chunk nodes kept for reuse, and on the capacity
+ * of recycled memory chunks, so a single large response does not pin its memory.
+ */
+enum {
+	MAX_RECYCLED_CHUNKS = 16,
+	MAX_RECYCLED_CAPACITY = 64 * 1024,
+};
+
+struct ChunkedStream::Chunk {
+	enum Kind { MEMORY, PIPE };
+
+	Kind kind;
+	Chunk* next;
+	MemoryBudget* budget;	// budget the memory chunk's buffer charges
+	Pipe* pipe;				// set for PIPE chunks
+	BufferStream buffer;	// used by MEMORY chunks
+
+	Chunk() : kind(MEMORY), next(nullptr), budget(nullptr), pipe(nullptr), buffer() {}
+	explicit Chunk(MemoryBudget* b) : kind(MEMORY), next(nullptr), budget(b), pipe(nullptr), buffer(b) {}
+
+	Stream* stream() { return kind == MEMORY ? static_cast<Stream*>(&buffer) : pipe; }
+	size_t size() const { return kind == MEMORY ? buffer.size() : pipe->size(); }
+};
+
+ChunkedStream::~ChunkedStream()
 {
-	if (chunks_.empty())
-		return true;
+	while (head_)
+		pop_front();
+
+	clearRecycled();
+}
 
-	return chunks_.front()->size() == 0;
+/*! charges all memory chunks allocated from now on to the given budget, or to none.
+ */
+void ChunkedStream::setBudget(MemoryBudget* budget)
+{
+	// recycled nodes are bound to the previous budget
+	clearRecycled();
+	budget_ = budget;
+}
+
+void ChunkedStream::clearRecycled()
+{
+	while (recycled_) {
+		Chunk* c = recycled_;
+		recycled_ = c->next;
+		delete c;
+	}
+	recycledCount_ = 0;
+}
+
+
+bool ChunkedStream::empty() const
+{
+	return size() == 0;
 }
 
 size_t ChunkedStream::size() const
 {
-	size_t result = 0;
+	return head_ ? size_ + head_->size() : 0;
+}
 
-	for (auto chunk: chunks_)
-		result += chunk->size();
+StreamReader ChunkedStream::front() const
+{
+	// reading through the head chunk directly is fine, as its size is not part of size_
+	return StreamReader(head_ ? head_->stream() : nullptr);
+}
 
-	return result;
+/*! accounts bytes written into the given chunk.
+ */
+inline ssize_t ChunkedStream::appended(Chunk* chunk, ssize_t rv)
+{
+	if (rv > 0 && chunk != head_)
+		size_ += rv;
+
+	return rv;
 }
 
 ssize_t ChunkedStream::write(const char* buf, size_t size)
 {
 	if (auto chunk = buffer(size))
-		return chunk->write(buf, size);
+		return appended(chunk, chunk->buffer.write(buf, size));
 
 	return -1;
 }
 
 ssize_t ChunkedStream::write(Socket* socket, size_t size, Mode mode)
 {
-	return 0; // TODO
+	if (mode == Stream::MOVE) {
+		if (auto chunk = pipe(size)) {
+			return appended(chunk, chunk->pipe->write(socket, size, mode));
+		}
+	}
+
+	if (auto chunk = buffer(size)) {
+		return appended(chunk, chunk->buffer.write(socket, size, mode));
+	}
+
+	return -1;
 }
 
 ssize_t ChunkedStream::write(Pipe* pp, size_t size, Mode mode)
 {
 	if (mode == Stream::MOVE) {
 		if (auto chunk = pipe(size)) {
-			return chunk->write(pp, size, mode);
+			return appended(chunk, chunk->pipe->write(pp, size, mode));
 		}
 	}
 
 	if (auto chunk = buffer(size)) {
-		return chunk->write(pp, size);
+		return appended(chunk, chunk->buffer.write(pp, size, mode));
 	}
 
 	return -1;
@@ -56,7 +135,7 @@ ssize_t ChunkedStream::write(Pipe* pp, size_t size, Mode mode)
 ssize_t ChunkedStream::write(int fd, size_t size)
 {
 	if (auto chunk = pipe(size))
-		return chunk->write(fd, size);
+		return appended(chunk, chunk->pipe->write(fd, size));
 
 	return -1;
 }
@@ -75,8 +154,8 @@ ssize_t ChunkedStream::read(char* buf, size_t size)
 {
 	ssize_t result = 0;
 	while (!empty() && size > 0) {
-		auto chunk = chunks_.front();
-		auto n = chunk->read(buf, size);
+		auto chunk = head_->stream();
+		auto n = chunk->read(buf + result, size);
 
 		if (n < 0)
 			return result ? result : -1;
@@ -87,23 +166,111 @@ ssize_t ChunkedStream::read(char* buf, size_t size)
 		}
 
 		if (chunk->size() == 0) {
-			chunks_.pop_front();
-			delete chunk;
+			pop_front();
 		}
 	}
 	return result;
 }
 
+/**
+ * Flushes up to \p size bytes into the given socket.
+ *
+ * Consecutive memory chunks are gathered into a single writev() call,
+ * whereas pipe chunks are spliced into the socket.
+ * Stops early as soon as the socket does not accept all bytes passed.
+ */
 ssize_t ChunkedStream::read(Socket* socket, size_t size)
 {
-	return 0; // TODO
+	ssize_t result = 0;
+	while (!empty() && size > 0) {
+		auto chunk = head_;
+		ssize_t n;
+		size_t expected;
+
+		// e.g. left behind by a write that failed with EAGAIN
+		if (chunk->size() == 0) {
+			pop_front();
+			continue;
+		}
+
+		if (chunk->kind == Chunk::MEMORY) {
+			n = writev(socket, size, &expected);
+		} else {
+			expected = std::min(chunk->size(), size);
+			n = chunk->pipe->read(socket, expected);
+
+			if (n > 0 && chunk->size() == 0) {
+				pop_front();
+			}
+		}
+
+		if (n < 0)
+			return result ? result : -1;
+
+		result += n;
+		size -= n;
+
+		if (n == 0 || static_cast<size_t>(n) < expected)
+			break;
+	}
+	return result;
+}
+
+/**
+ * Writes the leading memory chunks in one go via writev() into the socket.
+ *
+ * @param socket the socket to write to
+ * @param size maximum number of bytes to write
+ * @param expected receives the number of bytes that have been passed to writev().
+ *
+ * @return number of bytes written or -1 on error.
+ */
+ssize_t ChunkedStream::writev(Socket* socket, size_t size, size_t* expected)
+{
+	struct iovec iov[IOV_MAX];
+	int iovcnt = 0;
+	size_t total = 0;
+
+	for (Chunk* i = head_; i != nullptr && i->kind == Chunk::MEMORY && iovcnt < IOV_MAX && total < size; i = i->next) {
+		size_t len = std::min(i->buffer.size(), size - total);
+		if (len == 0)
+			continue;
+
+		iov[iovcnt].iov_base = const_cast<char*>(i->buffer.data() + i->buffer.readOffset());
+		iov[iovcnt].iov_len = len;
+		total += len;
+		++iovcnt;
+	}
+
+	*expected = total;
+
+	ssize_t rv = socket->writev(iov, iovcnt);
+	if (rv <= 0)
+		return rv;
+
+	// consume what has been written, possibly ending within a chunk
+	size_t n = rv;
+	while (n > 0) {
+		BufferStream& chunk = head_->buffer;
+		size_t len = chunk.size();
+
+		if (n < len) {
+			chunk.shift(n);
+			break;
+		}
+
+		n -= len;
+		pop_front();
+	}
+
+	return rv;
 }
 
 ssize_t ChunkedStream::read(Pipe* pp, size_t size)
 {
 	ssize_t result = 0;
 	while (!empty() && size > 0) {
-		auto chunk = chunks_.front();
+		auto chunk = head_->stream();
 		auto n = chunk->read(pp, size);
 
 		if (n < 0)
@@ -115,8 +282,7 @@ ssize_t ChunkedStream::read(Pipe* pp, size_t size)
 		}
 
 		if (chunk->size() == 0) {
-			chunks_.pop_front();
-			delete chunk;
+			pop_front();
 		}
 	}
 	return result;
@@ -126,7 +292,7 @@ ssize_t ChunkedStream::read(int fd, size_t size)
 {
 	size_t result = 0;
 	while (!empty() && size > 0) {
-		auto chunk = chunks_.front();
+		auto chunk = head_->stream();
 		ssize_t n = chunk->read(fd, size);
 
 		if (n < 0)
@@ -138,8 +304,7 @@ ssize_t ChunkedStream::read(int fd, size_t size)
 		}
 
 		if (chunk->size() == 0) {
-			chunks_.pop_front();
-			delete chunk;
+			pop_front();
 		}
 	}
 
@@ -148,8 +313,8 @@ ssize_t ChunkedStream::read(int fd, size_t size)
 
 int ChunkedStream::read()
 {
-	if (!empty()) {
-		auto chunk = chunks_.front();
+	while (!empty()) {
+		auto chunk = head_->stream();
 		auto ch = chunk->read();
 		if (chunk->size() == 0)
 			pop_front();
@@ -163,43 +328,105 @@ int ChunkedStream::read()
 
 void ChunkedStream::pop_front()
 {
-	delete chunks_.front();
-	chunks_.pop_front();
+	Chunk* chunk = head_;
+
+	head_ = chunk->next;
+	if (head_)
+		size_ -= head_->size(); // the new head accounts for itself
+	else
+		tail_ = nullptr;
+
+	release(chunk);
 }
 
-Stream* ChunkedStream::buffer(size_t size)
+void ChunkedStream::push_back(Chunk* chunk)
 {
-	if (!chunks_.empty()) {
-		if (auto tail = dynamic_cast<BufferStream*>(chunks_.back())) {
-			if (tail->size() < tail->capacity()) {
-				return tail;
-			}
-		}
+	chunk->next = nullptr;
+
+	if (tail_) {
+		tail_->next = chunk;
+		size_ += chunk->size();
+	} else {
+		head_ = chunk;
 	}
 
-	if (auto c = new BufferStream(size)) {
-		chunks_.push_back(c);
-		return c;
+	tail_ = chunk;
+}
+
+/**
+ * Passes the pipe of the given chunk back to the pipe pool (if any), and recycles the chunk node.
+ */
+void ChunkedStream::release(Chunk* chunk)
+{
+	if (chunk->kind == Chunk::PIPE) {
+		if (pipePool_)
+			pipePool_->release(chunk->pipe);
+		else
+			delete chunk->pipe;
+
+		chunk->pipe = nullptr;
+		chunk->kind = Chunk::MEMORY;
 	}
 
-	return nullptr;
+	chunk->buffer.clear();
+
+	// memory charged to a budget is always given back right away
+	if (recycledCount_ < MAX_RECYCLED_CHUNKS
+			&& chunk->budget == budget_
+			&& chunk->buffer.capacity() <= (budget_ ? 0 : MAX_RECYCLED_CAPACITY)) {
+		chunk->next = recycled_;
+		recycled_ = chunk;
+		++recycledCount_;
+	} else {
+		delete chunk;
+	}
 }
 
-Stream* ChunkedStream::pipe(size_t size)
+ChunkedStream::Chunk* ChunkedStream::acquire()
 {
-	if (!chunks_.empty()) {
-		if (auto tail = dynamic_cast<Pipe*>(chunks_.back())) {
-			// TODO ensure size' capacity availability
-			return tail;
-		}
+	if (Chunk* chunk = recycled_) {
+		recycled_ = chunk->next;
+		--recycledCount_;
+		return chunk;
+	}
+
+	return budget_ ? new Chunk(budget_) : new Chunk();
+}
+
+ChunkedStream::Chunk* ChunkedStream::buffer(size_t size)
+{
+	if (tail_ && tail_->kind == Chunk::MEMORY && tail_->buffer.size() < tail_->buffer.capacity())
+		return tail_;
+
+	Chunk* chunk = acquire();
+
+	if (size > chunk->buffer.capacity() && !chunk->buffer.reserve(size)) {
+		// budget exhausted (errno is set to EAGAIN), or out of memory
+		release(chunk);
+		return nullptr;
 	}
 
-	if (auto c = new Pipe(O_NONBLOCK | O_CLOEXEC)) {
-		chunks_.push_back(c);
-		return c;
+	push_back(chunk);
+	return chunk;
+}
+
+ChunkedStream::Chunk* ChunkedStream::pipe(size_t size)
+{
+	if (tail_ && tail_->kind == Chunk::PIPE) {
+		// TODO ensure size' capacity availability
+		return tail_;
 	}
 
-	return nullptr;
+	Pipe* pp = pipePool_ ? pipePool_->acquire() : new Pipe(O_NONBLOCK | O_CLOEXEC);
+	if (!pp)
+		return nullptr;
+
+	Chunk* chunk = acquire();
+	chunk->kind = Chunk::PIPE;
+	chunk->pipe = pp;
+
+	push_back(chunk);
+	return chunk;
 }
 
 void ChunkedStream::accept(StreamVisitor& visitor)
@@ -1,20 +1,191 @@
 #include <xio/DateTime.h>
+#include <limits>
+
+// {{{ civil calendar
+// Conversion between days since the epoch and proleptic Gregorian dates,
+// valid for any date, see http://howardhinnant.github.io/date_algorithms.html
+
+static long long daysFromCivil(int y, unsigned m, unsigned d)
+{
+	y -= m <= 2;
+	const long long era = (y >= 0 ? y : y - 399) / 400;
+	const unsigned yoe = static_cast<unsigned>(y - era * 400);             // [0, 399]
+	const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1; // [0, 365]
+	const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;           // [0, 146096]
+	return era * 146097 + static_cast<long long>(doe) - 719468;
+}
+
+static void civilFromDays(long long z, int* y, unsigned* m, unsigned* d)
+{
+	z += 719468;
+	const long long era = (z >= 0 ? z : z - 146096) / 146097;
+	const unsigned doe = static_cast<unsigned>(z - era * 146097);                // [0, 146096]
+	const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;  // [0, 399]
+	const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);                // [0, 365]
+	const unsigned mp = (5 * doy + 2) / 153;                                     // [0, 11]
+	*d = doy - (153 * mp + 2) / 5 + 1;
+	*m = mp < 10 ? mp + 3 : mp - 9;
+	*y = static_cast<int>(yoe + era * 400) + (*m <= 2);
+}
+// }}}
+// {{{ formatting helpers
+// 1970-01-01 was a Thursday
+static const char weekdays[] = "ThuFriSatSunMonTueWed";
+static const char months[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+
+static inline void format2(char* buf, unsigned value)
+{
+	buf[0] = '0' + value / 10;
+	buf[1] = '0' + value % 10;
+}
+
+//! writes "HH:MM:SS" for the given second of the day
+static inline void formatTime(char* buf, unsigned secs)
+{
+	format2(buf, secs / 3600);
+	buf[2] = ':';
+	format2(buf + 3, secs / 60 % 60);
+	buf[5] = ':';
+	format2(buf + 6, secs % 60);
+}
+
+static inline bool parse2(const char* buf, unsigned* value)
+{
+	if (buf[0] < '0' || buf[0] > '9' || buf[1] < '0' || buf[1] > '9')
+		return false;
+
+	*value = (buf[0] - '0') * 10 + (buf[1] - '0');
+	return true;
+}
+// }}}
 
 DateTime::DateTime() :
-	value_(std::time(0))
+	value_(std::time(0)),
+	httpTime_(std::numeric_limits<std::time_t>::min())
 {
 }
 
 DateTime::DateTime(const std::string& v) :
-	value_(mktime(v.c_str()))
+	value_(0),
+	httpTime_(std::numeric_limits<std::time_t>::min())
 {
+	std::time_t t;
+	if (parseHttpDate(v.data(), v.size(), &t))
+		value_ = t;
 }
 
 DateTime::DateTime(ev::tstamp v) :
-	value_(v)
+	value_(v),
+	httpTime_(std::numeric_limits<std::time_t>::min())
 {
 }
 
 DateTime::~DateTime()
 {
 }
+
+/*! this date formatted as RFC 1123 date, e.g. for the Date response header.
+ *
+ * The string is cached and only rewritten once the second changes, and only its time of day
+ * as long as the day stays the same. Keep one DateTime per event loop, updated once per
+ * loop iteration, and every response within the same second shares the same string.
+ *
+ * \return reference to HTTP_DATE_SIZE bytes, valid until this date changes or is destroyed.
+ */
+xio::BufferRef DateTime::httpDate() const
+{
+	const std::time_t t = unixtime();
+
+	if (t != httpTime_) {
+		if (t >= 0 && httpTime_ >= 0 && t / 86400 == httpTime_ / 86400)
+			formatTime(http_ + 17, t % 86400);
+		else
+			formatHttpDate(http_, t);
+
+		httpTime_ = t;
+	}
+
+	return xio::BufferRef(http_, HTTP_DATE_SIZE);
+}
+
+/*! writes \p value as RFC 1123 date (e.g. "Sun, 06 Nov 1994 08:49:37 GMT") into \p buf.
+ *
+ * \param buf target buffer, which must provide room for HTTP_DATE_SIZE bytes.
+ * \param value unix timestamp, with years beyond 9999 not being representable.
+ *
+ * \return number of bytes written (HTTP_DATE_SIZE, not NUL-terminated).
+ */
+size_t DateTime::formatHttpDate(char* buf, std::time_t value)
+{
+	long long days = value / 86400;
+	long long secs = value % 86400;
+
+	if (secs < 0) {
+		secs += 86400;
+		--days;
+	}
+
+	int y;
+	unsigned m, d;
+	civilFromDays(days, &y, &m, &d);
+
+	const char* weekday = weekdays + 3 * (((days % 7) + 7) % 7);
+	const char* month = months + 3 * (m - 1);
+
+	buf[0] = weekday[0];
+	buf[1] = weekday[1];
+	buf[2] = weekday[2];
+	buf[3] = ',';
+	buf[4] = ' ';
+	format2(buf + 5, d);
+	buf[7] = ' ';
+	buf[8] = month[0];
+	buf[9] = month[1];
+	buf[10] = month[2];
+	buf[11] = ' ';
+	format2(buf + 12, y / 100 % 100);
+	format2(buf + 14, y % 100);
+	buf[16] = ' ';
+	formatTime(buf + 17, secs);
+	buf[25] = ' ';
+	buf[26] = 'G';
+	buf[27] = 'M';
+	buf[28] = 'T';
+
+	return HTTP_DATE_SIZE;
+}
+
+/*! parses an RFC 1123 date, e.g. "Sun, 06 Nov 1994 08:49:37 GMT".
+ *
+ * Only this fixed-length format (the IMF-fixdate of RFC 7231) is accepted,
+ * the day name is not cross-checked against the date.
+ *
+ * \return true on success, with the unix timestamp stored in \p result.
+ */
+bool DateTime::parseHttpDate(const char* buf, size_t size, std::time_t* result)
+{
+	if (size != HTTP_DATE_SIZE
+			|| buf[3] != ',' || buf[4] != ' ' || buf[7] != ' ' || buf[11] != ' ' || buf[16] != ' '
+			|| buf[19] != ':' || buf[22] != ':'
+			|| buf[25] != ' ' || buf[26] != 'G' || buf[27] != 'M' || buf[28] != 'T')
+		return false;
+
+	unsigned day, century, year, hour, minute, second;
+
+	if (!parse2(buf + 5, &day) || !parse2(buf + 12, &century) || !parse2(buf + 14, &year)
+			|| !parse2(buf + 17, &hour) || !parse2(buf + 20, &minute) || !parse2(buf + 23, &second))
+		return false;
+
+	unsigned month = 0;
+	while (month < 12 && !(buf[8] == months[3 * month] && buf[9] == months[3 * month + 1] && buf[10] == months[3 * month + 2]))
+		++month;
+
+	// leap seconds (60) are accepted, and just roll over into the next minute
+	if (month == 12 || day < 1 || day > 31 || hour > 23 || minute > 59 || second > 60)
+		return false;
+
+	long long days = daysFromCivil(century * 100 + year, month + 1, day);
+	*result = days * 86400 + hour * 3600 + minute * 60 + second;
+
+	return true;
+}
@@ -0,0 +1,252 @@
+/* <xio/DeflateFilter.cpp>
+ *
+ * This file is part of the x0 web server project and is released under LGPL-3.
+ * http://www.xzero.io/
+ *
+ * (c) 2009-2013 Christian Parpart <trapni@gmail.com>
+ */
+
+#include <xio/DeflateFilter.h>
+#include <xio/sysconfig.h>
+#include <algorithm>
+#include <string.h>
+#include <errno.h>
+
+#if defined(HAVE_ZLIB_H) && defined(HAVE_LIBZ)
+#	include <zlib.h>
+#endif
+
+namespace xio {
+
+#if defined(HAVE_ZLIB_H) && defined(HAVE_LIBZ) // {{{ zlib implementation
+/*! ensures some free space at the end of \p output.
+ *
+ * \param hint number of bytes to grow by, if growing is needed at all.
+ * \return number of bytes available at the end of \p output, 0 if out of memory.
+ */
+static size_t makeRoom(Buffer& output, size_t hint)
+{
+	if (output.capacity() - output.size() < 256
+			&& !output.reserve(output.size() + std::max(hint, static_cast<size_t>(4096))))
+		return 0;
+
+	return output.capacity() - output.size();
+}
+
+// {{{ DeflateFilter
+DeflateFilter::DeflateFilter(int level) :
+	DeflateFilter(level, MAX_WBITS)
+{
+}
+
+/*! \param windowBits zlib window size, plus 16 to produce a gzip instead of a zlib wrapper.
+ */
+DeflateFilter::DeflateFilter(int level, int windowBits) :
+	level_(level),
+	z_(new z_stream)
+{
+	memset(z_, 0, sizeof(*z_));
+
+	if (deflateInit2(z_, level, Z_DEFLATED, windowBits, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+		delete z_;
+		z_ = nullptr;
+	}
+}
+
+DeflateFilter::~DeflateFilter()
+{
+	if (z_) {
+		deflateEnd(z_);
+		delete z_;
+	}
+}
+
+bool DeflateFilter::isSupported()
+{
+	return true;
+}
+
+ssize_t DeflateFilter::process(const BufferRef& input, Buffer& output)
+{
+	return deflate(input, output, Z_NO_FLUSH);
+}
+
+ssize_t DeflateFilter::flush(Buffer& output)
+{
+	return deflate(BufferRef(), output, Z_SYNC_FLUSH);
+}
+
+ssize_t DeflateFilter::finish(Buffer& output)
+{
+	ssize_t n = deflate(BufferRef(), output, Z_FINISH);
+
+	deflateReset(z_);
+
+	return n;
+}
+
+/*! feeds \p input to the compressor and appends whatever it emits to \p output.
+ *
+ * \param mode zlib flush mode: Z_NO_FLUSH, Z_SYNC_FLUSH, or Z_FINISH.
+ * \return number of bytes appended, or -1 on failure.
+ */
+ssize_t DeflateFilter::deflate(const BufferRef& input, Buffer& output, int mode)
+{
+	if (!z_) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	const size_t before = output.size();
+
+	z_->next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+	z_->avail_in = input.size();
+
+	for (;;) {
+		size_t avail = makeRoom(output, z_->avail_in / 2 + 256);
+		if (!avail) {
+			errno = ENOMEM;
+			return -1;
+		}
+
+		z_->next_out = reinterpret_cast<Bytef*>(output.data() + output.size());
+		z_->avail_out = avail;
+
+		int rv = ::deflate(z_, mode);
+
+		output.resize(output.size() + avail - z_->avail_out);
+
+		if (rv == Z_STREAM_END)
+			break;
+
+		if (rv != Z_OK && rv != Z_BUF_ERROR) {
+			errno = EINVAL;
+			return -1;
+		}
+
+		// all input taken and the compressor had nothing more to say
+		if (z_->avail_in == 0 && z_->avail_out != 0)
+			break;
+	}
+
+	return output.size() - before;
+}
+// }}}
+// {{{ GzipFilter
+GzipFilter::GzipFilter(int level) :
+	DeflateFilter(level, MAX_WBITS + 16)
+{
+}
+// }}}
+// {{{ InflateFilter
+InflateFilter::InflateFilter() :
+	z_(new z_stream)
+{
+	memset(z_, 0, sizeof(*z_));
+
+	// accept zlib and gzip wrappers alike
+	if (inflateInit2(z_, MAX_WBITS + 32) != Z_OK) {
+		delete z_;
+		z_ = nullptr;
+	}
+}
+
+InflateFilter::~InflateFilter()
+{
+	if (z_) {
+		inflateEnd(z_);
+		delete z_;
+	}
+}
+
+ssize_t InflateFilter::process(const BufferRef& input, Buffer& output)
+{
+	if (!z_) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	const size_t before = output.size();
+
+	z_->next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+	z_->avail_in = input.size();
+
+	for (;;) {
+		size_t avail = makeRoom(output, z_->avail_in * 3);
+		if (!avail) {
+			errno = ENOMEM;
+			return -1;
+		}
+
+		z_->next_out = reinterpret_cast<Bytef*>(output.data() + output.size());
+		z_->avail_out = avail;
+
+		int rv = ::inflate(z_, Z_NO_FLUSH);
+
+		output.resize(output.size() + avail - z_->avail_out);
+
+		if (rv == Z_STREAM_END) {
+			// ready for the next stream, in case of concatenated input
+			inflateReset(z_);
+
+			if (z_->avail_in == 0)
+				break;
+
+			continue;
+		}
+
+		if (rv != Z_OK && rv != Z_BUF_ERROR) {
+			errno = EINVAL;
+			return -1;
+		}
+
+		// all input taken and no more output pending
+		if (z_->avail_in == 0 && z_->avail_out != 0)
+			break;
+	}
+
+	return output.size() - before;
+}
+
+/*! fails if the input ended within a compressed stream.
+ *
+ * Everything decompressed so far has already been emitted by process(),
+ * and the filter is reset either way.
+ */
+ssize_t InflateFilter::finish(Buffer& /*output*/)
+{
+	if (!z_) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	// total_in is reset at the end of each stream, see process()
+	bool truncated = z_->total_in != 0;
+
+	inflateReset(z_);
+
+	if (truncated) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	return 0;
+}
+// }}}
+#else // }}} {{{ stubs for builds without zlib
+DeflateFilter::DeflateFilter(int level) : level_(level), z_(nullptr) {}
+DeflateFilter::DeflateFilter(int level, int) : level_(level), z_(nullptr) {}
+DeflateFilter::~DeflateFilter() {}
+bool DeflateFilter::isSupported() { return false; }
+ssize_t DeflateFilter::process(const BufferRef&, Buffer&) { errno = ENOSYS; return -1; }
+ssize_t DeflateFilter::flush(Buffer&) { errno = ENOSYS; return -1; }
+ssize_t DeflateFilter::finish(Buffer&) { errno = ENOSYS; return -1; }
+ssize_t DeflateFilter::deflate(const BufferRef&, Buffer&, int) { errno = ENOSYS; return -1; }
+GzipFilter::GzipFilter(int level) : DeflateFilter(level, 0) {}
+InflateFilter::InflateFilter() : z_(nullptr) {}
+InflateFilter::~InflateFilter() {}
+ssize_t InflateFilter::process(const BufferRef&, Buffer&) { errno = ENOSYS; return -1; }
+ssize_t InflateFilter::finish(Buffer&) { errno = ENOSYS; return -1; }
+#endif // }}}
+
+} // namespace xio
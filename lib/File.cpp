@@ -1,6 +1,8 @@
 #include <xio/File.h>
+#include <xio/FileMgr.h>
 #include <xio/FileStream.h>
 #include <sys/inotify.h>
+#include <sys/mman.h>
 #include <ev++.h>
 
 namespace xio {
@@ -73,6 +75,30 @@ File::File(const std::string& path) :
 	errno_(),
 	inotify_(-1),
 	cachedAt_(),
+	mgr_(nullptr),
+	fd_(-1),
+	data_(nullptr),
+	lru_(),
+	etag_(),
+	mtime_(),
+	mimetype_()
+{
+	if (::stat(path_.c_str(), &stat_) < 0)
+		errno_ = errno;
+}
+
+/*! initializes the file from an already retrieved stat() result, see FileMgr::queryAsync().
+ */
+File::File(const std::string& path, const struct stat& st, int error) :
+	path_(path),
+	stat_(st),
+	errno_(error),
+	inotify_(-1),
+	cachedAt_(),
+	mgr_(nullptr),
+	fd_(-1),
+	data_(nullptr),
+	lru_(),
 	etag_(),
 	mtime_(),
 	mimetype_()
@@ -81,10 +107,30 @@ File::File(const std::string& path) :
 
 File::~File()
 {
+	if (mgr_)
+		mgr_->detach(this);
+
 	if (inotify_ != -1) {
 		inotifier.remove(inotify_);
 		inotify_ = -1;
 	}
+
+	releaseHandle();
+}
+
+/*! closes the cached file descriptor and memory mapping, if any.
+ */
+void File::releaseHandle()
+{
+	if (data_) {
+		::munmap(data_, size());
+		data_ = nullptr;
+	}
+
+	if (fd_ >= 0) {
+		::close(fd_);
+		fd_ = -1;
+	}
 }
 
 const char* File::filename() const
@@ -97,11 +143,36 @@ const std::string& File::etag() const
 	return etag_;
 }
 
+/*! the file's modification time, formatted as RFC 1123 date for the Last-Modified header.
+ *
+ * Formatted once, on first use.
+ */
 const std::string& File::lastModified() const
 {
+	if (mtime_.empty() && exists()) {
+		char buf[DateTime::HTTP_DATE_SIZE];
+		mtime_.assign(buf, DateTime::formatHttpDate(buf, stat_.st_mtime));
+	}
+
 	return mtime_;
 }
 
+/*! retrieves the read-only memory mapped file contents of \p size() bytes.
+ *
+ * Only small files managed by a FileMgr are mapped, see FileMgr::Config::mmapMaxSize.
+ * The mapping is released as soon as the file got modified (or dropped from the manager),
+ * so do not keep the returned pointer beyond the current event loop iteration.
+ *
+ * \return pointer to the file contents or nullptr if not mapped.
+ */
+const char* File::data()
+{
+	if (mgr_)
+		mgr_->acquire(this);
+
+	return static_cast<const char*>(data_);
+}
+
 const std::string& File::mimetype() const
 {
 	return mimetype_;
@@ -125,8 +196,21 @@ void File::clearCache()
 	}
 }
 
+/*! opens a stream over the whole file.
+ *
+ * Read-only streams on files managed by a FileMgr duplicate the manager's cached
+ * file descriptor instead of opening the path again. The stream owns its descriptor either way,
+ * so it stays valid when the cached one gets evicted or invalidated.
+ */
 std::unique_ptr<FileStream> File::open(int flags)
 {
+	if (mgr_ && (flags & O_ACCMODE) == O_RDONLY && mgr_->acquire(this)) {
+		int fd = ::fcntl(fd_, F_DUPFD_CLOEXEC, 0);
+		if (fd >= 0) {
+			return std::unique_ptr<FileStream>(new FileStream(fd, 0, size()));
+		}
+	}
+
 	int fd = ::open(path_.c_str(), flags);
 	if (fd < 0)
 		return std::unique_ptr<FileStream>();
@@ -1,4 +1,4 @@
-/* <x0/FileInfoService.cpp>
+/* <xio/FileMgr.cpp>
  *
  * This file is part of the x0 web server project and is released under LGPL-3.
  * http://www.xzero.io/
@@ -6,43 +6,39 @@
  * (c) 2009-2013 Christian Parpart <trapni@gmail.com>
  */
 
-#include <x0/io/FileInfoService.h>
-#include <x0/Tokenizer.h>
-#include <x0/strutils.h>
-#include <x0/sysconfig.h>
+#include <xio/FileMgr.h>
+#include <xio/File.h>
+#include <xio/ThreadPool.h>
+#include <xio/LoopExecutor.h>
+#include <xio/sysconfig.h>
+#include <fstream>
+#include <sys/mman.h>
+#include <string.h>
+#include <errno.h>
 
-namespace x0 {
+namespace xio {
 
-#if 0 // !defined(XZERO_NDEBUG)
-#	define TRACE(msg...) printf("FileInfoService: " msg)
+#if 0 // !defined(XIO_NDEBUG)
+#	define TRACE(msg...) printf("FileMgr: " msg)
 #else
 #	define TRACE(msg...) /*!*/
 #endif
 
-#if defined(HAVE_SYS_INOTIFY_H)
-#	undef HAVE_SYS_INOTIFY_H
-#endif
-
-FileInfoService::FileInfoService(struct ::ev_loop *loop, const Config *config) :
+FileMgr::FileMgr(struct ::ev_loop *loop, const Config *config) :
 	loop_(loop),
-#if 1 // defined(HAVE_SYS_INOTIFY_H)
+#if defined(HAVE_SYS_INOTIFY_H)
 	handle_(-1),
 	inotify_(loop_),
 	inotifies_(),
 #endif
 	config_(config),
-	cache_()
+	cache_(),
+	lru_()
 {
 #if defined(HAVE_SYS_INOTIFY_H)
-	handle_ = inotify_init();
+	handle_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
 	if (handle_ != -1) {
-		if (fcntl(handle_, F_SETFL, fcntl(handle_, F_GETFL) | O_NONBLOCK) < 0)
-			fprintf(stderr, "Error setting nonblock/cloexec flags on inotify handle\n");
-
-		if (fcntl(handle_, F_SETFD, fcntl(handle_, F_GETFD) | FD_CLOEXEC) < 0)
-			fprintf(stderr, "Error setting cloexec flags on inotify handle\n");
-
-		inotify_.set<FileInfoService, &FileInfoService::onFileChanged>(this);
+		inotify_.set<FileMgr, &FileMgr::onFileChanged>(this);
 		inotify_.start(handle_, ev::READ);
 	} else {
 		fprintf(stderr, "Error initializing inotify: %s\n", strerror(errno));
@@ -50,81 +46,236 @@ FileInfoService::FileInfoService(struct ::ev_loop *loop, const Config *config) :
 #endif
 }
 
-FileInfoService::~FileInfoService()
+FileMgr::~FileMgr()
 {
+	clear();
+
 #if defined(HAVE_SYS_INOTIFY_H)
 	if (handle_ != -1) {
+		inotify_.stop();
 		::close(handle_);
 	}
 #endif
 }
 
-inline bool FileInfoService::isValid(const FileInfo *fi) const
+inline bool FileMgr::isValid(const File *fi) const
 {
-	return fi->inotifyId_ > 0
-		|| fi->cachedAt() + config_->cacheTTL_ > ev_now(loop_);
+	return fi->inotify_ != -1
+		|| fi->cachedAt().value() + config_->cacheTTL_ > ev_now(loop_);
 }
 
-FileInfoPtr FileInfoService::query(const std::string& _filename)
+/*! drops all cached entries.
+ *
+ * Files still referenced elsewhere lose their cached file descriptor and mapping, too.
+ */
+void FileMgr::clear()
 {
-	std::string filename(_filename[_filename.size() - 1] == '/'
-			? _filename.substr(0, _filename.size() - 1)
-			: _filename);
+	for (auto& i: cache_)
+		detach(i.second.get());
+
+	cache_.clear();
+}
 
+std::string FileMgr::normalize(const std::string& filename)
+{
+	return !filename.empty() && filename[filename.size() - 1] == '/'
+		? filename.substr(0, filename.size() - 1)
+		: filename;
+}
+
+/*! retrieves the still valid cache entry for the given (normalized) filename, if any.
+ */
+FilePtr FileMgr::lookup(const std::string& filename)
+{
 	auto i = cache_.find(filename);
-	if (i != cache_.end()) {
-		FileInfoPtr fi = i->second;
-		if (isValid(fi.get())) {
-			TRACE("query.cached(%s) len:%ld\n", filename.c_str(), fi->size());
-			return fi;
-		}
+	if (i == cache_.end())
+		return FilePtr();
 
-		TRACE("query.expired(%s) len:%ld\n", filename.c_str(), fi->size());
-#if defined(HAVE_SYS_INOTIFY_H)
-		if (fi->inotifyId_ >= 0) {
-			inotify_rm_watch(handle_, fi->inotifyId_);
-			auto i = inotifies_.find(fi->inotifyId_);
-			if (i != inotifies_.end())
-				inotifies_.erase(i);
-		}
-#endif
-		cache_.erase(i);
+	FilePtr fi = i->second;
+	if (isValid(fi.get())) {
+		TRACE("query.cached(%s) len:%ld\n", filename.c_str(), fi->size());
+		return fi;
 	}
 
-	if (FileInfoPtr fi = FileInfoPtr(new FileInfo(*this, filename))) {
-		fi->mimetype_ = get_mimetype(filename);
-		fi->etag_ = make_etag(*fi);
+	TRACE("query.expired(%s) len:%ld\n", filename.c_str(), fi->size());
+	invalidate(i);
+
+	return FilePtr();
+}
+
+FilePtr FileMgr::query(const std::string& _filename)
+{
+	std::string filename(normalize(_filename));
+
+	if (FilePtr fi = lookup(filename))
+		return fi;
+
+	return insert(filename, FilePtr(new File(filename)));
+}
+
+/*! asynchronously retrieves the file information for the given file.
+ *
+ * Cached entries are passed to \p done right away. Otherwise the file is stat()'ed on
+ * a thread of \p pool, and \p done is invoked from within \p executor's event loop,
+ * which must be the loop this manager is running on. This manager must outlive all
+ * pending queries.
+ *
+ * \retval true the query has been answered or scheduled.
+ * \retval false the query could not be scheduled, errno is set (EAGAIN when the pool is saturated).
+ */
+bool FileMgr::queryAsync(const std::string& _filename, ThreadPool* pool, LoopExecutor* executor,
+	std::function<void(FilePtr)> done)
+{
+	std::string filename(normalize(_filename));
+
+	if (FilePtr fi = lookup(filename)) {
+		done(fi);
+		return true;
+	}
+
+	return pool->post([this, filename, executor, done]() {
+		struct stat st;
+		int error = ::stat(filename.c_str(), &st) < 0 ? errno : 0;
+
+		executor->post([this, filename, st, error, done]() {
+			// another query may have completed in the meantime
+			FilePtr fi = lookup(filename);
+			if (!fi)
+				fi = insert(filename, FilePtr(new File(filename, st, error)));
+
+			done(fi);
+		});
+	});
+}
+
+/*! puts a freshly stat()'ed file into the cache and starts watching it for changes.
+ */
+FilePtr FileMgr::insert(const std::string& filename, FilePtr fi)
+{
+	fi->mgr_ = this;
+	fi->cachedAt_ = ev_now(loop_);
+	fi->mimetype_ = get_mimetype(filename);
+	fi->etag_ = make_etag(*fi);
 
 #if defined(HAVE_SYS_INOTIFY_H)
-		int wd = handle_ != -1 && fi->exists()
-				? ::inotify_add_watch(handle_, filename.c_str(),
-					/*IN_ONESHOT |*/ IN_ATTRIB | IN_DELETE_SELF | IN_MOVE_SELF | IN_UNMOUNT |
-					IN_DELETE_SELF | IN_MOVE_SELF)
-				: -1;
-		TRACE("query(%s).new -> %d len:%ld\n", filename.c_str(), wd, fi->size());
-
-		if (wd != -1) {
-			fi->inotifyId_ = wd;
-			inotifies_[wd] = fi;
+	int wd = handle_ != -1 && fi->exists()
+			? ::inotify_add_watch(handle_, filename.c_str(),
+				IN_MODIFY | IN_ATTRIB | IN_DELETE_SELF | IN_MOVE_SELF | IN_UNMOUNT)
+			: -1;
+	TRACE("query(%s).new -> %d len:%ld\n", filename.c_str(), wd, fi->size());
+
+	if (wd != -1) {
+		// the same inode may already be watched on behalf of another path
+		auto k = inotifies_.find(wd);
+		if (k != inotifies_.end()) {
+			k->second->inotify_ = -1;
+			k->second->cachedAt_ = 0;
 		}
-		cache_[filename] = fi;
+
+		fi->inotify_ = wd;
+		inotifies_[wd] = fi.get();
+	}
 #else
-		TRACE("query(%s)! len:%ld\n", filename.c_str(), fi->size());
-		cache_[filename] = fi;
+	TRACE("query(%s)! len:%ld\n", filename.c_str(), fi->size());
 #endif
 
-		return fi;
+	cache_[filename] = fi;
+
+	return fi;
+}
+
+void FileMgr::invalidate(std::unordered_map<std::string, FilePtr>::iterator i)
+{
+	TRACE("invalidate: %s\n", i->first.c_str());
+
+	detach(i->second.get());
+	cache_.erase(i);
+}
+
+/*! ensures that the given file has an open file descriptor (and mapping, if small enough).
+ *
+ * \retval true the file's descriptor is open and has been marked as most recently used.
+ * \retval false fd caching is disabled or the file could not be opened.
+ */
+bool FileMgr::acquire(File* file)
+{
+	if (file->fd_ >= 0) {
+		lru_.splice(lru_.begin(), lru_, file->lru_);
+		return true;
+	}
+
+	if (config_->maxOpenFiles == 0 || !file->exists() || !file->isRegular())
+		return false;
+
+	file->fd_ = ::open(file->path_.c_str(), O_RDONLY | O_CLOEXEC);
+	if (file->fd_ < 0)
+		return false;
+
+	// NB: truncating a file while it is mapped raises SIGBUS when touching the truncated pages,
+	// so we keep mappings small and drop them as soon as inotify reports a modification.
+	if (file->size() > 0 && file->size() <= config_->mmapMaxSize) {
+		void* data = ::mmap(nullptr, file->size(), PROT_READ, MAP_SHARED, file->fd_, 0);
+		if (data != MAP_FAILED) {
+			file->data_ = data;
+		}
 	}
 
-	TRACE("query(%s) failed (%s)\n", filename.c_str(), strerror(errno));
-	// either ::stat() or caching failed.
+	lru_.push_front(file);
+	file->lru_ = lru_.begin();
+
+	if (lru_.size() > config_->maxOpenFiles)
+		evict();
 
-	return FileInfoPtr();
+	return true;
 }
 
+/*! closes least recently used file descriptors until we are within our limit again.
+ *
+ * Files still referenced outside the cache are skipped, as their mapping may still be in use.
+ */
+void FileMgr::evict()
+{
+	auto i = lru_.end();
+
+	while (i != lru_.begin() && lru_.size() > config_->maxOpenFiles) {
+		File* file = *--i;
+
+		auto k = cache_.find(file->path_);
+		if (k != cache_.end() && k->second.use_count() > 1)
+			continue;
+
+		TRACE("evict: %s\n", file->path());
+		i = lru_.erase(i);
+		file->releaseHandle();
+	}
+}
+
+/*! removes the file from all bookkeeping of this manager.
+ *
+ * The cached file descriptor is closed and the mapping released, as the file may have
+ * been modified (truncating a mapped file raises SIGBUS on its readers).
+ * Streams retrieved via File::open() own a duplicate and remain usable.
+ */
+void FileMgr::detach(File* file)
+{
+	if (file->fd_ >= 0) {
+		lru_.erase(file->lru_);
+		file->releaseHandle();
+	}
+
+#if defined(HAVE_SYS_INOTIFY_H)
+	if (file->inotify_ != -1) {
+		inotify_rm_watch(handle_, file->inotify_);
+		inotifies_.erase(file->inotify_);
+		file->inotify_ = -1;
+	}
+#endif
+
+	file->mgr_ = nullptr;
+}
 
 #if defined(HAVE_SYS_INOTIFY_H)
-void FileInfoService::onFileChanged(ev::io& w, int revents)
+void FileMgr::onFileChanged(ev::io& w, int revents)
 {
 	TRACE("onFileChanged()\n");
 
@@ -146,45 +297,39 @@ void FileInfoService::onFileChanged(ev::io& w, int revents)
 				continue;
 			}
 
-			auto k = cache_.find(wi->second->filename());
-			TRACE("invalidate: %s\n", k->first.c_str());
-			// onInvalidate(k->first, k->second);
-			cache_.erase(k);
-			inotifies_.erase(wi);
-			int rv = inotify_rm_watch(handle_, ev->wd);
-			if (rv < 0) {
-				TRACE("error removing inotify watch (%d, %s): %s\n", ev->wd, ev->name, strerror(errno));
+			auto k = cache_.find(wi->second->path_);
+			if (k != cache_.end()) {
+				invalidate(k);
 			} else {
-				TRACE("inotify_rm_watch: %d (ok)\n", rv);
+				detach(wi->second);
 			}
 		}
 	}
 }
 #endif
 
-void FileInfoService::Config::loadMimetypes(const std::string& filename)
+void FileMgr::Config::loadMimetypes(const std::string& filename)
 {
-	Buffer input(x0::read_file(filename));
-	auto lines = Tokenizer<BufferRef, Buffer>::tokenize(input, "\n");
+	std::ifstream input(filename);
+	std::string line;
 
 	mimetypes.clear();
 
-	for (auto line: lines) {
-		line = line.trim();
-		auto columns = Tokenizer<BufferRef, BufferRef>::tokenize(line, " \t");
+	while (std::getline(input, line)) {
+		std::istringstream columns(line);
+		std::string mime;
 
-		auto ci = columns.begin(), ce = columns.end();
-		BufferRef mime = ci != ce ? *ci++ : BufferRef();
+		if (!(columns >> mime) || mime[0] == '#')
+			continue;
 
-		if (!mime.empty() && mime[0] != '#') {
-			for (; ci != ce; ++ci) {
-				mimetypes[ci->str()] = mime.str();
-			}
+		std::string ext;
+		while (columns >> ext) {
+			mimetypes[ext] = mime;
 		}
 	}
 }
 
-std::string FileInfoService::get_mimetype(const std::string& filename) const
+std::string FileMgr::get_mimetype(const std::string& filename) const
 {
 	std::size_t ndot = filename.find_last_of(".");
 	std::size_t nslash = filename.find_last_of("/");
@@ -214,4 +359,4 @@ std::string FileInfoService::get_mimetype(const std::string& filename) const
 	return config_->defaultMimetype;
 }
 
-} // namespace x0
+} // namespace xio
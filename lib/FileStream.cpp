@@ -1,77 +1,251 @@
 #include <xio/FileStream.h>
 #include <xio/StreamVisitor.h>
+#include <xio/Socket.h>
+#include <xio/Pipe.h>
+#include <xio/Buffer.h>
+#include <xio/ThreadPool.h>
+#include <xio/sysconfig.h>
+#include <sys/sendfile.h>
+#include <algorithm>
+#include <errno.h>
 
 namespace xio {
 
-FileStream::FileStream(int fd) :
-	fd_(fd)
+/*! writes all of \p size bytes from \p buf to \p stream, as data already received cannot be pushed back.
+ */
+static ssize_t writeFully(FileStream* stream, const char* buf, size_t size)
+{
+	size_t nwritten = 0;
+
+	while (nwritten < size) {
+		ssize_t rv = stream->write(buf + nwritten, size - nwritten);
+		if (rv <= 0)
+			return nwritten ? nwritten : rv;
+
+		nwritten += rv;
+	}
+
+	return nwritten;
+}
+
+/*! initializes a stream over the whole file.
+ *
+ * \param fd the file descriptor to read from / write to.
+ * \param owned whether or not to close \p fd when this stream is destroyed.
+ */
+FileStream::FileStream(int fd, bool owned) :
+	fd_(fd),
+	offset_(0),
+	length_(0),
+	owned_(owned)
+{
+	struct stat st;
+
+	if (::fstat(fd_, &st) == 0)
+		length_ = st.st_size;
+}
+
+/*! initializes a stream over the given window of the file.
+ *
+ * \param fd the file descriptor to read from / write to.
+ * \param offset file offset of the first byte of the window.
+ * \param length number of bytes in the window.
+ * \param owned whether or not to close \p fd when this stream is destroyed.
+ */
+FileStream::FileStream(int fd, off_t offset, size_t length, bool owned) :
+	fd_(fd),
+	offset_(offset),
+	length_(length),
+	owned_(owned)
 {
 }
 
 FileStream::~FileStream()
 {
-	if (fd_ >= 0)
+	if (owned_ && fd_ >= 0)
 		::close(fd_);
 }
 
 size_t FileStream::size() const
 {
-	struct stat st;
-
-	if (::fstat(fd_, &st) < 0)
-		return 0;
+	return length_;
+}
 
-	return st.st_size;
+void FileStream::setRange(off_t offset, size_t length)
+{
+	offset_ = offset;
+	length_ = length;
 }
 
 ssize_t FileStream::read(Buffer& result, size_t size)
 {
-	return -1; // TODO
+	size = std::min(size, length_);
+
+	if (!result.reserve(result.size() + size)) {
+		errno = ENOMEM;
+		return -1;
+	}
+
+	ssize_t rv = consumed(::pread(fd_, result.end(), size, offset_));
+
+	if (rv > 0)
+		result.resize(result.size() + rv);
+
+	return rv;
+}
+
+/*! reads up to \p size bytes at \p offset within this stream's window on a pool thread.
+ *
+ * The bytes are appended to \p result, and \p done is invoked with the number of bytes read
+ * (or -1 with errno set) from within \p executor's event loop. Unlike the synchronous read()
+ * functions, this does not consume from the stream's window.
+ *
+ * Neither \p result nor this stream must be touched or destroyed until \p done has been invoked.
+ *
+ * \retval true the read has been scheduled.
+ * \retval false the read could not be scheduled, errno is set (EAGAIN when the pool is saturated).
+ */
+bool FileStream::readAsync(Buffer& result, off_t offset, size_t size,
+	ThreadPool* pool, LoopExecutor* executor, std::function<void(ssize_t)> done)
+{
+	if (offset < 0 || static_cast<size_t>(offset) > length_) {
+		errno = EINVAL;
+		return false;
+	}
+
+	size = std::min(size, length_ - offset);
+
+	// allocate on the issuing thread, the pool thread only fills in the reserved space
+	if (!result.reserve(result.size() + size)) {
+		errno = ENOMEM;
+		return false;
+	}
+
+	int fd = fd_;
+	char* buf = result.end();
+	off_t pos = offset_ + offset;
+
+	return pool->post(executor,
+		[fd, buf, pos, size]() -> ssize_t {
+			ssize_t rv = ::pread(fd, buf, size, pos);
+
+			// readers tend to continue where they stopped, so let the kernel fetch the next chunk meanwhile
+			if (rv > 0) {
+				int error = errno;
+#if defined(HAVE_POSIX_FADVISE)
+				::posix_fadvise(fd, pos + rv, size, POSIX_FADV_WILLNEED);
+#elif defined(HAVE_READAHEAD)
+				::readahead(fd, pos + rv, size);
+#endif
+				errno = error;
+			}
+
+			return rv;
+		},
+		[&result, done](ssize_t rv) {
+			if (rv > 0)
+				result.resize(result.size() + rv);
+
+			done(rv);
+		}
+	);
+}
+
+/*! hints the kernel to load the given range of this stream's window into the page cache.
+ *
+ * This does not block on the actual disk I/O, so it may be called from within the event loop,
+ * e.g. right before serving a file via sendfile() or splice().
+ */
+void FileStream::prefetch(off_t offset, size_t size)
+{
+	if (offset < 0 || static_cast<size_t>(offset) >= length_)
+		return;
+
+	size = std::min(size, length_ - offset);
+
+#if defined(HAVE_POSIX_FADVISE)
+	::posix_fadvise(fd_, offset_ + offset, size, POSIX_FADV_WILLNEED);
+#elif defined(HAVE_READAHEAD)
+	::readahead(fd_, offset_ + offset, size);
+#endif
 }
 
 ssize_t FileStream::read(char* buf, size_t size)
 {
-	return ::read(fd_, buf, size);
+	return consumed(::pread(fd_, buf, std::min(size, length_), offset_));
 }
 
 ssize_t FileStream::read(Socket* socket, size_t size)
 {
-	return -1; // TODO
+	return read(socket->handle(), size);
 }
 
 ssize_t FileStream::read(Pipe* pipe, size_t size)
 {
-	return -1; // TODO
+	loff_t offset = offset_;
+	ssize_t rv = splice(fd_, &offset, pipe->writeFd(), nullptr, std::min(size, length_),
+		SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+
+	if (rv > 0)
+		pipe->size_ += rv;
+
+	return consumed(rv);
 }
 
 ssize_t FileStream::read(int fd, size_t size)
 {
-	return -1; // TODO
+	off_t offset = offset_;
+	return consumed(sendfile(fd, fd_, &offset, std::min(size, length_)));
 }
 
 int FileStream::read()
 {
-	return -1; // TODO
+	unsigned char ch;
+
+	if (consumed(::pread(fd_, &ch, sizeof(ch), offset_)) != 1)
+		return -1;
+
+	return ch;
 }
 
 ssize_t FileStream::write(const char* buf, size_t size)
 {
-	return ::write(fd_, buf, size);
+	return appended(::pwrite(fd_, buf, size, offset_ + length_));
 }
 
 ssize_t FileStream::write(Socket* socket, size_t size, Mode mode)
 {
-	return -1; // TODO
+	// no kernel support to splice from a socket into a file without an intermediate pipe
+	char buf[16 * 1024];
+
+	ssize_t rv = socket->read(buf, std::min(size, sizeof(buf)));
+	if (rv <= 0)
+		return rv;
+
+	return writeFully(this, buf, rv);
 }
 
 ssize_t FileStream::write(Pipe* pipe, size_t size, Mode mode)
 {
-	return -1; // TODO
+	loff_t offset = offset_ + length_;
+	ssize_t rv = splice(pipe->readFd(), nullptr, fd_, &offset, std::min(size, pipe->size()),
+		mode == Stream::MOVE ? SPLICE_F_MOVE | SPLICE_F_NONBLOCK : SPLICE_F_NONBLOCK);
+
+	if (rv > 0)
+		pipe->size_ -= rv;
+
+	return appended(rv);
 }
 
 ssize_t FileStream::write(int fd, size_t size)
 {
-	return -1; // TODO
+	char buf[16 * 1024];
+
+	ssize_t rv = ::read(fd, buf, std::min(size, sizeof(buf)));
+	if (rv <= 0)
+		return rv;
+
+	return writeFully(this, buf, rv);
 }
 
 void FileStream::accept(StreamVisitor& visitor)
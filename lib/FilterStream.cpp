@@ -1,21 +1,37 @@
 #include <xio/FilterStream.h>
+#include <xio/StreamVisitor.h>
 #include <xio/Filter.h>
 #include <xio/Buffer.h>
+#include <xio/Socket.h>
+#include <xio/Pipe.h>
+#include <algorithm>
 #include <deque>
+#include <cstring>
+#include <cerrno>
 
 namespace xio {
 
+//! minimum number of bytes to pull from the parent stream at once.
+static const size_t MIN_PULL_SIZE = 4096;
+
 FilterStream::FilterStream(std::unique_ptr<Stream> parent) :
-	parent_(std::move(parent))
+	parent_(std::move(parent)),
+	inputBuffer_(),
+	outputBuffer_(),
+	outputPos_(0),
+	stages_(),
+	finished_(false),
+	filters()
 {
 }
 
 FilterStream::FilterStream(Stream* parent, std::unique_ptr<Filter> filter) :
-	parent_(std::move(parent)),
+	parent_(parent),
 	inputBuffer_(),
-	inputPos_(0),
 	outputBuffer_(),
 	outputPos_(0),
+	stages_(),
+	finished_(false),
 	filters()
 {
 	filters.push_back(std::move(filter));
@@ -25,127 +41,316 @@ FilterStream::~FilterStream()
 {
 }
 
-ssize_t FilterStream::process(const BufferRef& input, Buffer& output)
+/*! passes \p input through all filters, appending the final result to \p output.
+ *
+ * Every stage but the last one writes into its own buffer, which is cleared (not freed)
+ * before reuse, and the next stage reads a view of it. The last stage writes
+ * straight into \p output.
+ *
+ * \param input raw data to filter, may be empty when just flushing.
+ * \param output buffer to append the filtered data to.
+ * \param mode whether filters should emit data they held back.
+ *
+ * \return number of bytes appended to \p output, or -1 if a filter failed.
+ */
+ssize_t FilterStream::process(const BufferRef& input, Buffer& output, Flush mode)
 {
-	if (filters.empty())
-		return 0;
+	if (filters.empty()) {
+		output.push_back(input);
+		return input.size();
+	}
 
-	if (filters.size() == 1)
-		return filters.front()->process(input, output);
+	const size_t last = filters.size() - 1;
+	const size_t before = output.size();
 
-	auto i = filters.begin();
-	auto e = filters.end();
-	Buffer result;
-	Buffer tmp;
+	while (stages_.size() < last)
+		stages_.emplace_back();
 
-	(*i++)->process(input, result);
+	BufferRef in(input);
 
-	do {
-		result.swap(tmp);
-		(*i++)->process(tmp.ref(), result);
-	} while (i != e);
+	for (size_t i = 0; i <= last; ++i) {
+		Filter* f = filters[i].get();
+		Buffer& out = i < last ? stages_[i] : output;
 
-	ssize_t n = result.size();
+		if (i < last)
+			out.clear();
 
-	if (output.capacity())
-		output.push_back(result);
-	else
-		output = std::move(result);
+		if (!in.empty() && f->process(in, out) < 0)
+			return -1;
 
-	return n;
+		if (mode == SYNC && f->flush(out) < 0)
+			return -1;
+
+		if (mode == FINISH && f->finish(out) < 0)
+			return -1;
+
+		if (i < last)
+			in = out.ref();
+	}
+
+	return output.size() - before;
 }
 
-// {{{ Stream API impl
-bool FilterStream::empty() const
+/*! filters \p input into the output buffer, compacting already consumed output first.
+ */
+ssize_t FilterStream::filter(const BufferRef& input, Flush mode)
 {
-	return parent_->empty();
+	if (finished_) {
+		errno = EPIPE;
+		return -1;
+	}
+
+	if (outputPos_ != 0) {
+		size_t n = pending();
+		memmove(outputBuffer_.data(), outputBuffer_.data() + outputPos_, n);
+		outputBuffer_.resize(n);
+		outputPos_ = 0;
+	}
+
+	if (mode == FINISH)
+		finished_ = true;
+
+	return process(input, outputBuffer_, mode);
 }
 
-size_t FilterStream::size() const
+void FilterStream::consume(size_t n)
 {
-	return parent_->size();
+	outputPos_ += n;
+
+	if (outputPos_ == outputBuffer_.size()) {
+		outputBuffer_.clear();
+		outputPos_ = 0;
+	}
 }
 
+/*! reads and filters from the parent until at least \p size bytes are pending.
+ *
+ * Reading 0 bytes from the parent finishes the filters.
+ *
+ * \return number of bytes pending, which may be less than \p size at the end of the stream,
+ *         or -1 if nothing is pending and the parent failed (e.g. with EAGAIN).
+ */
 ssize_t FilterStream::pull(size_t size)
 {
-	if (inputBuffer_.size() - inputPos_ >= size)
-		return size;
+	while (pending() < size && !finished_) {
+		inputBuffer_.clear();
 
-	inputBuffer_.reserve(inputBuffer_.size() + size);
+		ssize_t rv = parent_->read(inputBuffer_, std::max(size - pending(), MIN_PULL_SIZE));
+		if (rv < 0) {
+			if (pending())
+				break;
 
-	ssize_t rv = parent_->read(inputBuffer_, size);
+			return -1;
+		}
 
-	return rv != -1
-		? inputBuffer_.size() - inputPos_ + rv
-		: -1;
+		if (filter(inputBuffer_.ref(), rv != 0 ? NONE : FINISH) < 0)
+			return -1;
+	}
+
+	return pending();
 }
 
-ssize_t FilterStream::read(Buffer& result, size_t size)
+/*! writes pending output into the parent stream.
+ *
+ * \return number of bytes written, or -1 if the parent failed.
+ */
+ssize_t FilterStream::push()
+{
+	ssize_t total = 0;
+
+	while (pending()) {
+		ssize_t rv = parent_->write(outputBuffer_.data() + outputPos_, pending());
+		if (rv <= 0)
+			return total ? total : rv;
+
+		consume(rv);
+		total += rv;
+	}
+
+	return total;
+}
+
+/*! lets the filters emit everything they held back and writes it into the parent.
+ *
+ * \retval true all data has been passed on into the parent stream.
+ * \retval false the parent did not accept everything yet, or a filter failed.
+ */
+bool FilterStream::flush()
+{
+	if (!finished_ && filter(BufferRef(), SYNC) < 0)
+		return false;
+
+	push();
+
+	return pending() == 0;
+}
+
+/*! ends the filters' output and writes it into the parent.
+ *
+ * Can be called again to retry passing on what the parent did not accept yet.
+ *
+ * \retval true all data has been passed on into the parent stream.
+ * \retval false the parent did not accept everything yet, or a filter failed.
+ */
+bool FilterStream::finish()
+{
+	if (!finished_ && filter(BufferRef(), FINISH) < 0)
+		return false;
+
+	push();
+
+	return pending() == 0;
+}
+
+// {{{ Stream API impl
+bool FilterStream::empty() const
 {
-	pull(size);
+	return pending() == 0 && (finished_ || parent_->empty());
+}
 
-	process(inputBuffer_.ref(inputPos_), outputBuffer_);
+/*! number of filtered bytes that are ready to be read, or not yet written into the parent.
+ */
+size_t FilterStream::size() const
+{
+	return pending();
+}
 
-	size = std::min(size, outputBuffer_.size() - outputPos_);
+ssize_t FilterStream::read(Buffer& result, size_t size)
+{
+	ssize_t n = pull(size);
+	if (n <= 0)
+		return n;
 
-	size_t lsize = result.size();
-	result.push_back(outputBuffer_.data() + outputPos_, size);
-	return lsize - result.size();
+	n = std::min(size, static_cast<size_t>(n));
+	result.push_back(outputBuffer_.data() + outputPos_, n);
+	consume(n);
+
+	return n;
 }
 
 ssize_t FilterStream::read(char* buf, size_t size)
 {
-	size = pull(size);
+	ssize_t n = pull(size);
+	if (n <= 0)
+		return n;
 
-	process(inputBuffer_.ref(inputPos_), outputBuffer_);
+	n = std::min(size, static_cast<size_t>(n));
+	memcpy(buf, outputBuffer_.data() + outputPos_, n);
+	consume(n);
 
-	return size;
+	return n;
 }
 
 ssize_t FilterStream::read(Socket* socket, size_t size)
 {
-	return 0;
+	ssize_t n = pull(size);
+	if (n <= 0)
+		return n;
+
+	n = socket->write(outputBuffer_.data() + outputPos_, std::min(size, static_cast<size_t>(n)));
+	if (n > 0)
+		consume(n);
+
+	return n;
 }
 
 ssize_t FilterStream::read(Pipe* pipe, size_t size)
 {
-	return 0;
+	ssize_t n = pull(size);
+	if (n <= 0)
+		return n;
+
+	n = pipe->write(outputBuffer_.data() + outputPos_, std::min(size, static_cast<size_t>(n)));
+	if (n > 0)
+		consume(n);
+
+	return n;
 }
 
 ssize_t FilterStream::read(int fd, size_t size)
 {
-	return 0;
+	ssize_t n = pull(size);
+	if (n <= 0)
+		return n;
+
+	n = ::write(fd, outputBuffer_.data() + outputPos_, std::min(size, static_cast<size_t>(n)));
+	if (n > 0)
+		consume(n);
+
+	return n;
 }
 
 int FilterStream::read()
 {
-	return 0;
+	if (pull(1) <= 0)
+		return -1;
+
+	int ch = static_cast<unsigned char>(outputBuffer_.data()[outputPos_]);
+	consume(1);
+
+	return ch;
 }
 
+/*! filters the given data and passes the result on into the parent stream.
+ *
+ * All input is taken, whatever the parent does not accept yet stays pending
+ * until the next write, flush() or finish().
+ *
+ * \return \p size, or -1 if a filter or the parent failed.
+ */
 ssize_t FilterStream::write(const char* buf, size_t size)
 {
-	return 0;
+	if (filter(BufferRef(buf, size), NONE) < 0)
+		return -1;
+
+	if (push() < 0 && errno != EAGAIN)
+		return -1;
+
+	return size;
 }
 
-ssize_t FilterStream::write(Socket* socket, size_t size, Mode mode)
+ssize_t FilterStream::write(Socket* socket, size_t size, Mode /*mode*/)
 {
-	return 0;
+	inputBuffer_.clear();
+
+	ssize_t n = socket->read(inputBuffer_, size);
+	if (n <= 0)
+		return n;
+
+	return write(inputBuffer_.data(), n);
 }
 
-ssize_t FilterStream::write(Pipe* pipe, size_t size, Mode mode)
+ssize_t FilterStream::write(Pipe* pipe, size_t size, Mode /*mode*/)
 {
-	return 0;
+	inputBuffer_.clear();
+
+	ssize_t n = pipe->read(inputBuffer_, size);
+	if (n <= 0)
+		return n;
+
+	return write(inputBuffer_.data(), n);
 }
 
 ssize_t FilterStream::write(int fd, size_t size)
 {
-	return 0;
+	inputBuffer_.clear();
+
+	if (!inputBuffer_.reserve(size))
+		return -1;
+
+	ssize_t n = ::read(fd, inputBuffer_.data(), size);
+	if (n <= 0)
+		return n;
+
+	inputBuffer_.resize(n);
+
+	return write(inputBuffer_.data(), n);
 }
 
-void FilterStream::accept(StreamVisitor& v)
+void FilterStream::accept(StreamVisitor& visitor)
 {
+	visitor.visit(*this);
 }
-
 // }}}
 
 } // namespace xio
@@ -0,0 +1,406 @@
+/* <xio/HttpParser.cpp>
+ *
+ * This file is part of the x0 web server project and is released under LGPL-3.
+ * http://www.xzero.io/
+ *
+ * (c) 2009-2013 Christian Parpart <trapni@gmail.com>
+ */
+
+#include <xio/HttpParser.h>
+#include <xio/StringUtil.h>
+#include <cstring>
+#include <errno.h>
+
+#if defined(__SSE2__)
+#	include <emmintrin.h>
+#endif
+
+namespace xio {
+
+// {{{ character classes
+//! tchar as of RFC 7230, section 3.2.6, used for methods and header field names.
+static const bool tokenChars[256] = {
+	// 0x00 .. 0x1F: CTLs
+	0,0,0,0,0,0,0,0, 0,0,0,0,0,0,0,0, 0,0,0,0,0,0,0,0, 0,0,0,0,0,0,0,0,
+	//   !  "  #  $  %  &  '  (  )  *  +  ,  -  .  /
+	0, 1, 0, 1, 1, 1, 1, 1, 0, 0, 1, 1, 0, 1, 1, 0,
+	// 0 .. 9, :  ;  <  =  >  ?
+	1,1,1,1,1,1,1,1, 1,1,0,0,0,0,0,0,
+	// @  A .. O
+	0,1,1,1,1,1,1,1, 1,1,1,1,1,1,1,1,
+	// P .. Z, [  \  ]  ^  _
+	1,1,1,1,1,1,1,1, 1,1,1,0,0,0,1,1,
+	// `  a .. o
+	1,1,1,1,1,1,1,1, 1,1,1,1,1,1,1,1,
+	// p .. z, {  |  }  ~  DEL
+	1,1,1,1,1,1,1,1, 1,1,1,0,1,0,1,0,
+	// 0x80 .. 0xFF: not part of any token
+};
+
+static inline bool isToken(char c)
+{
+	return tokenChars[static_cast<unsigned char>(c)];
+}
+
+//! any visible character, i.e. no CTL, space or DEL.
+static inline bool isUriChar(char c)
+{
+	return static_cast<unsigned char>(c) > 0x20 && c != 0x7F;
+}
+
+//! field-content: visible characters, obs-text, space and horizontal tab.
+static inline bool isValueChar(char c)
+{
+	return (static_cast<unsigned char>(c) >= 0x20 && c != 0x7F) || c == '\t';
+}
+
+static inline bool isDigit(char c)
+{
+	return c >= '0' && c <= '9';
+}
+// }}}
+// {{{ scanning
+// URIs and header values make up most of a message head, so they are scanned
+// 16 bytes at a time where possible. SSE2 is part of every x86-64 CPU.
+
+static const char* scanUri(const char* i, const char* e)
+{
+#if defined(__SSE2__)
+	const __m128i min = _mm_set1_epi8(0x21);
+	const __m128i del = _mm_set1_epi8(0x7F);
+
+	for (; i + 16 <= e; i += 16) {
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(i));
+		__m128i ok = _mm_andnot_si128(_mm_cmpeq_epi8(v, del), _mm_cmpeq_epi8(_mm_max_epu8(v, min), v));
+		unsigned mask = _mm_movemask_epi8(ok) ^ 0xFFFF;
+
+		if (mask)
+			return i + __builtin_ctz(mask);
+	}
+#endif
+
+	while (i != e && isUriChar(*i))
+		++i;
+
+	return i;
+}
+
+static const char* scanValue(const char* i, const char* e)
+{
+#if defined(__SSE2__)
+	const __m128i min = _mm_set1_epi8(0x20);
+	const __m128i del = _mm_set1_epi8(0x7F);
+	const __m128i tab = _mm_set1_epi8('\t');
+
+	for (; i + 16 <= e; i += 16) {
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(i));
+		__m128i ok = _mm_andnot_si128(_mm_cmpeq_epi8(v, del), _mm_cmpeq_epi8(_mm_max_epu8(v, min), v));
+		ok = _mm_or_si128(ok, _mm_cmpeq_epi8(v, tab));
+		unsigned mask = _mm_movemask_epi8(ok) ^ 0xFFFF;
+
+		if (mask)
+			return i + __builtin_ctz(mask);
+	}
+#endif
+
+	while (i != e && isValueChar(*i))
+		++i;
+
+	return i;
+}
+// }}}
+
+HttpParser::HttpParser(Mode mode) :
+	mode_(mode),
+	state_(START),
+	base_(nullptr),
+	offset_(0),
+	tokenStart_(0),
+	versionPos_(0),
+	method_(),
+	uri_(),
+	reason_(),
+	status_(0),
+	versionMajor_(0),
+	versionMinor_(0),
+	headerCount_(0)
+{
+}
+
+/*! prepares the parser for the next message head.
+ */
+void HttpParser::reset()
+{
+	state_ = START;
+	base_ = nullptr;
+	offset_ = 0;
+	tokenStart_ = 0;
+	versionPos_ = 0;
+	method_ = Token();
+	uri_ = Token();
+	reason_ = Token();
+	status_ = 0;
+	versionMajor_ = 0;
+	versionMinor_ = 0;
+	headerCount_ = 0;
+}
+
+void HttpParser::reset(Mode mode)
+{
+	reset();
+	mode_ = mode;
+}
+
+/*! finds the first header field named \p name, ignoring case.
+ *
+ * \return the field's value, or an empty reference if there is no such field.
+ */
+BufferRef HttpParser::header(const BufferRef& name) const
+{
+	for (size_t i = 0; i < headerCount_; ++i)
+		if (headers_[i].name.length == name.size()
+				&& memiequals(base_ + headers_[i].name.offset, name.data(), name.size()))
+			return headerValue(i);
+
+	return BufferRef();
+}
+
+HttpParser::Token HttpParser::endToken(const char* end) const
+{
+	Token t;
+	t.offset = tokenStart_;
+	t.length = (end - base_) - tokenStart_;
+	return t;
+}
+
+ssize_t HttpParser::fail(int error)
+{
+	state_ = ERROR;
+	errno = error;
+	return -1;
+}
+
+/*! continues parsing the message head.
+ *
+ * \param data the input, which must start with the same byte on every call for the same
+ *             message head, and may only have grown since the last call. Only the bytes
+ *             beyond parsed() are looked at.
+ *
+ * \return the length of the message head (including the terminating empty line) once complete,
+ *         0 if more data is needed, or -1 on failure, with errno set to EBADMSG for malformed input,
+ *         E2BIG if there are more than MAX_HEADERS header fields, or EINVAL if \p data shrunk.
+ */
+ssize_t HttpParser::parse(const BufferRef& data)
+{
+	if (state_ == COMPLETE)
+		return offset_;
+
+	if (state_ == ERROR)
+		return fail(EBADMSG);
+
+	if (data.size() < offset_)
+		return fail(EINVAL);
+
+	if (data.size() > UINT32_MAX)
+		return fail(E2BIG);
+
+	base_ = data.data();
+
+	const char* i = base_ + offset_;
+	const char* e = base_ + data.size();
+
+	while (i != e) {
+		switch (state_) {
+			case START:
+				// leading empty lines are ignored (RFC 7230, section 3.5)
+				if (*i == '\r' || *i == '\n') {
+					++i;
+					break;
+				}
+
+				tokenStart_ = i - base_;
+				state_ = mode_ == REQUEST ? METHOD : VERSION;
+				break;
+			case METHOD:
+				while (i != e && isToken(*i))
+					++i;
+
+				if (i == e)
+					break;
+
+				if (*i != ' ' || static_cast<size_t>(i - base_) == tokenStart_)
+					return fail(EBADMSG);
+
+				method_ = endToken(i);
+				tokenStart_ = ++i - base_;
+				state_ = URI;
+				break;
+			case URI:
+				i = scanUri(i, e);
+
+				if (i == e)
+					break;
+
+				if (*i != ' ' || static_cast<size_t>(i - base_) == tokenStart_)
+					return fail(EBADMSG);
+
+				uri_ = endToken(i);
+				++i;
+				state_ = VERSION;
+				break;
+			case VERSION:
+				// "HTTP/" DIGIT "." DIGIT
+				if (versionPos_ < 5) {
+					if (*i != "HTTP/"[versionPos_])
+						return fail(EBADMSG);
+				} else if (versionPos_ == 6) {
+					if (*i != '.')
+						return fail(EBADMSG);
+				} else if (!isDigit(*i)) {
+					return fail(EBADMSG);
+				} else if (versionPos_ == 5) {
+					versionMajor_ = *i - '0';
+				} else {
+					versionMinor_ = *i - '0';
+				}
+
+				++i;
+
+				if (++versionPos_ == 8)
+					state_ = mode_ == REQUEST ? LINE_END : STATUS_SP;
+				break;
+			case STATUS_SP:
+				if (*i != ' ')
+					return fail(EBADMSG);
+
+				++i;
+				tokenStart_ = i - base_;
+				state_ = STATUS;
+				break;
+			case STATUS:
+				if (!isDigit(*i))
+					return fail(EBADMSG);
+
+				status_ = status_ * 10 + (*i - '0');
+				++i;
+
+				if (static_cast<size_t>(i - base_) - tokenStart_ == 3)
+					state_ = STATUS_END;
+				break;
+			case STATUS_END:
+				// the reason phrase may be omitted, including its leading space
+				if (*i == ' ') {
+					tokenStart_ = ++i - base_;
+					state_ = REASON;
+				} else if (*i == '\r' || *i == '\n') {
+					state_ = LINE_END;
+				} else {
+					return fail(EBADMSG);
+				}
+				break;
+			case REASON:
+				i = scanValue(i, e);
+
+				if (i == e)
+					break;
+
+				reason_ = endToken(i);
+				state_ = LINE_END;
+				break;
+			case LINE_END:
+				// bare LF is accepted as line terminator, too (RFC 7230, section 3.5)
+				if (*i == '\r') {
+					state_ = LINE_LF;
+				} else if (*i == '\n') {
+					state_ = HEADER_START;
+				} else {
+					return fail(EBADMSG);
+				}
+
+				++i;
+				break;
+			case LINE_LF:
+				if (*i != '\n')
+					return fail(EBADMSG);
+
+				++i;
+				state_ = HEADER_START;
+				break;
+			case HEADER_START:
+				if (*i == '\r') {
+					++i;
+					state_ = HEAD_END_LF;
+				} else if (*i == '\n') {
+					++i;
+					state_ = COMPLETE;
+					offset_ = i - base_;
+					return offset_;
+				} else if (headerCount_ == MAX_HEADERS) {
+					return fail(E2BIG);
+				} else {
+					// this also rejects obsolete line folding (leading whitespace)
+					tokenStart_ = i - base_;
+					state_ = HEADER_NAME;
+				}
+				break;
+			case HEADER_NAME:
+				while (i != e && isToken(*i))
+					++i;
+
+				if (i == e)
+					break;
+
+				if (*i != ':' || static_cast<size_t>(i - base_) == tokenStart_)
+					return fail(EBADMSG);
+
+				headers_[headerCount_].name = endToken(i);
+				++i;
+				state_ = HEADER_OWS;
+				break;
+			case HEADER_OWS:
+				while (i != e && (*i == ' ' || *i == '\t'))
+					++i;
+
+				if (i == e)
+					break;
+
+				tokenStart_ = i - base_;
+				state_ = HEADER_VALUE;
+				break;
+			case HEADER_VALUE: {
+				i = scanValue(i, e);
+
+				if (i == e)
+					break;
+
+				if (*i != '\r' && *i != '\n')
+					return fail(EBADMSG);
+
+				// strip trailing whitespace
+				const char* end = i;
+				while (static_cast<size_t>(end - base_) > tokenStart_ && (end[-1] == ' ' || end[-1] == '\t'))
+					--end;
+
+				headers_[headerCount_++].value = endToken(end);
+				state_ = LINE_END;
+				break;
+			}
+			case HEAD_END_LF:
+				if (*i != '\n')
+					return fail(EBADMSG);
+
+				++i;
+				state_ = COMPLETE;
+				offset_ = i - base_;
+				return offset_;
+			case COMPLETE:
+			case ERROR:
+				break;
+		}
+	}
+
+	offset_ = e - base_;
+	return 0;
+}
+
+} // namespace xio
@@ -105,13 +105,42 @@ void InetServer::setReusePort(bool value)
 	reusePort_ = value;
 }
 
+/*! creates a copy of this listener, to be served by the given event loop.
+ *
+ * If SO_REUSEPORT is enabled, the clone binds its own listener socket to the same
+ * address and port, thus, the kernel load-balances incoming connections between them.
+ * Otherwise the clone shares this listener's socket (by duplicating the file descriptor).
+ */
 InetServer* InetServer::clone(struct ev_loop* loop) const
 {
 	auto s = new InetServer(loop);
 
 	s->setBacklog(backlog_);
-	s->setReusePort(reusePort_);
-	s->open(ipaddr_, port_, flags_);
+	s->setMultiAcceptCount(multiAcceptCount_);
+
+	if (reusePort_) {
+		int flags = flags_;
+
+		if (typeMask_ & SOCK_NONBLOCK)
+			flags |= O_NONBLOCK;
+
+		if (typeMask_ & SOCK_CLOEXEC)
+			flags |= O_CLOEXEC;
+
+		s->setReusePort(true);
+		s->open(ipaddr_, port_, flags);
+	} else if (isOpen()) {
+		s->fd_ = fcntl(fd_, F_DUPFD_CLOEXEC, 0);
+		if (s->fd_ < 0) {
+			s->errorText_ = strerror(errno);
+		} else {
+			s->flags_ = flags_;
+			s->typeMask_ = typeMask_;
+			s->ipaddr_ = ipaddr_;
+			s->port_ = port_;
+			s->start();
+		}
+	}
 
 	return s;
 }
@@ -258,12 +287,27 @@ err:
 
 bool InetServer::bind(const IPAddress& ipaddr, int port)
 {
-	struct sockaddr_in sin;
-	memset(&sin, 0, sizeof(sin));
-	memcpy(&sin.sin_addr, ipaddr.data(), ipaddr.size());
-	sin.sin_port = htons(port);
+	int rv;
+
+	if (ipaddr.family() == AF_INET6) {
+		struct sockaddr_in6 sin6;
+		memset(&sin6, 0, sizeof(sin6));
+		sin6.sin6_family = AF_INET6;
+		memcpy(&sin6.sin6_addr, ipaddr.data(), ipaddr.size());
+		sin6.sin6_port = htons(port);
+
+		rv = ::bind(fd_, (const sockaddr*) &sin6, sizeof(sin6));
+	} else {
+		struct sockaddr_in sin;
+		memset(&sin, 0, sizeof(sin));
+		sin.sin_family = AF_INET;
+		memcpy(&sin.sin_addr, ipaddr.data(), ipaddr.size());
+		sin.sin_port = htons(port);
+
+		rv = ::bind(fd_, (const sockaddr*) &sin, sizeof(sin));
+	}
 
-	if (::bind(fd_, (const sockaddr*) &sin, sizeof(sin)) < 0)
+	if (rv < 0)
 		return false;
 
 	ipaddr_ = ipaddr;
@@ -0,0 +1,521 @@
+/* <xio/IoUring.cpp>
+ *
+ * This file is part of the x0 web server project and is released under LGPL-3.
+ * http://www.xzero.io/
+ *
+ * (c) 2009-2013 Christian Parpart <trapni@gmail.com>
+ */
+
+#include <xio/IoUring.h>
+#include <xio/sysconfig.h>
+#include <algorithm>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <assert.h>
+
+#if defined(HAVE_LINUX_IO_URING_H)
+#	include <linux/io_uring.h>
+#	include <sys/syscall.h>
+#	include <sys/eventfd.h>
+#	include <sys/mman.h>
+#endif
+
+namespace xio {
+
+#if 0 // !defined(XIO_NDEBUG)
+#	define TRACE(msg...) do { printf("IoUring: " msg); printf("\n"); } while (0)
+#else
+#	define TRACE(msg...) do { } while (0)
+#endif
+
+class IoUring::Request {
+public:
+	Completion callback;
+	int refs; //!< number of submissions referring to this request (itself and cancellations)
+};
+
+#if defined(HAVE_LINUX_IO_URING_H) // {{{ io_uring implementation
+static inline int sys_io_uring_setup(unsigned entries, struct io_uring_params* p)
+{
+	return syscall(__NR_io_uring_setup, entries, p);
+}
+
+static inline int sys_io_uring_enter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags)
+{
+	return syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0);
+}
+
+static inline int sys_io_uring_register(int fd, unsigned opcode, const void* arg, unsigned nargs)
+{
+	return syscall(__NR_io_uring_register, fd, opcode, arg, nargs);
+}
+
+// user_data tag of cancellation requests (Request objects are at least 2-byte aligned)
+#define CANCEL_TAG static_cast<uintptr_t>(1)
+
+#define OFFSET_PTR(base, offset) reinterpret_cast<unsigned*>(static_cast<char*>(base) + (offset))
+
+/*! initializes the ring.
+ *
+ * \param loop the event loop to submit and complete requests on.
+ * \param entries submission queue size; more requests per loop iteration are submitted early.
+ */
+IoUring::IoUring(struct ev_loop* loop, unsigned entries) :
+	loop_(loop),
+	fd_(-1),
+	eventFd_(-1),
+	errno_(0),
+	sqRing_(MAP_FAILED),
+	sqRingSize_(0),
+	sqHead_(nullptr),
+	sqTail_(nullptr),
+	sqMask_(nullptr),
+	sqArray_(nullptr),
+	sqEntries_(0),
+	sqes_(static_cast<struct io_uring_sqe*>(MAP_FAILED)),
+	lastSqe_(nullptr),
+	cqRing_(MAP_FAILED),
+	cqRingSize_(0),
+	cqHead_(nullptr),
+	cqTail_(nullptr),
+	cqMask_(nullptr),
+	cqes_(nullptr),
+	pending_(0),
+	inflight_(0),
+	requests_(),
+	freeList_(),
+	prepare_(loop),
+	completion_(loop)
+{
+	struct io_uring_params params;
+	memset(&params, 0, sizeof(params));
+
+	fd_ = sys_io_uring_setup(entries, &params);
+	if (fd_ < 0)
+		goto err;
+
+	sqRingSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+	cqRingSize_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+
+	if (params.features & IORING_FEAT_SINGLE_MMAP)
+		sqRingSize_ = cqRingSize_ = std::max(sqRingSize_, cqRingSize_);
+
+	sqRing_ = mmap(nullptr, sqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQ_RING);
+	if (sqRing_ == MAP_FAILED)
+		goto err;
+
+	if (params.features & IORING_FEAT_SINGLE_MMAP) {
+		cqRing_ = sqRing_;
+	} else {
+		cqRing_ = mmap(nullptr, cqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_CQ_RING);
+		if (cqRing_ == MAP_FAILED)
+			goto err;
+	}
+
+	sqes_ = static_cast<struct io_uring_sqe*>(mmap(nullptr, params.sq_entries * sizeof(struct io_uring_sqe),
+		PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQES));
+	if (sqes_ == MAP_FAILED)
+		goto err;
+
+	sqHead_ = OFFSET_PTR(sqRing_, params.sq_off.head);
+	sqTail_ = OFFSET_PTR(sqRing_, params.sq_off.tail);
+	sqMask_ = OFFSET_PTR(sqRing_, params.sq_off.ring_mask);
+	sqArray_ = OFFSET_PTR(sqRing_, params.sq_off.array);
+	sqEntries_ = params.sq_entries;
+
+	cqHead_ = OFFSET_PTR(cqRing_, params.cq_off.head);
+	cqTail_ = OFFSET_PTR(cqRing_, params.cq_off.tail);
+	cqMask_ = OFFSET_PTR(cqRing_, params.cq_off.ring_mask);
+	cqes_ = reinterpret_cast<struct io_uring_cqe*>(static_cast<char*>(cqRing_) + params.cq_off.cqes);
+
+	eventFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (eventFd_ < 0)
+		goto err;
+
+	if (sys_io_uring_register(fd_, IORING_REGISTER_EVENTFD, &eventFd_, 1) < 0)
+		goto err;
+
+	// neither watcher keeps the loop alive, only in-flight requests do.
+	prepare_.set<IoUring, &IoUring::onPrepare>(this);
+	prepare_.start();
+	ev_unref(loop_);
+
+	completion_.set<IoUring, &IoUring::onCompletion>(this);
+	completion_.start(eventFd_, ev::READ);
+	ev_unref(loop_);
+
+	TRACE("initialized with %u entries", sqEntries_);
+	return;
+
+err:
+	errno_ = errno;
+	TRACE("not available: %s", strerror(errno_));
+
+	if (sqes_ != MAP_FAILED)
+		munmap(sqes_, sqEntries_ * sizeof(struct io_uring_sqe));
+
+	if (cqRing_ != MAP_FAILED && cqRing_ != sqRing_)
+		munmap(cqRing_, cqRingSize_);
+
+	if (sqRing_ != MAP_FAILED)
+		munmap(sqRing_, sqRingSize_);
+
+	if (eventFd_ >= 0) {
+		::close(eventFd_);
+		eventFd_ = -1;
+	}
+
+	if (fd_ >= 0) {
+		::close(fd_);
+		fd_ = -1;
+	}
+}
+
+IoUring::~IoUring()
+{
+	if (!isOpen())
+		return;
+
+	// closing the ring cancels all requests still in flight, without completing them.
+	if (inflight_ > 0)
+		ev_unref(loop_);
+
+	ev_ref(loop_);
+	prepare_.stop();
+
+	ev_ref(loop_);
+	completion_.stop();
+
+	munmap(sqes_, sqEntries_ * sizeof(struct io_uring_sqe));
+
+	if (cqRing_ != sqRing_)
+		munmap(cqRing_, cqRingSize_);
+
+	munmap(sqRing_, sqRingSize_);
+
+	::close(eventFd_);
+	::close(fd_);
+
+	for (Request* request: requests_)
+		delete request;
+}
+
+/*! tests whether or not the running kernel supports io_uring.
+ */
+bool IoUring::isSupported()
+{
+	static int supported = -1;
+
+	if (supported < 0) {
+		struct io_uring_params params;
+		memset(&params, 0, sizeof(params));
+
+		int fd = sys_io_uring_setup(1, &params);
+		supported = fd >= 0;
+
+		if (fd >= 0) {
+			::close(fd);
+		}
+	}
+
+	return supported;
+}
+
+struct io_uring_sqe* IoUring::acquireSqe()
+{
+	unsigned tail = *sqTail_;
+
+	if (tail - __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE) >= sqEntries_) {
+		// submission queue full, submit early
+		if (!submit() || tail - __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE) >= sqEntries_) {
+			errno = EBUSY;
+			return nullptr;
+		}
+	}
+
+	unsigned index = tail & *sqMask_;
+	struct io_uring_sqe* sqe = &sqes_[index];
+	memset(sqe, 0, sizeof(*sqe));
+
+	sqArray_[index] = index;
+	__atomic_store_n(sqTail_, tail + 1, __ATOMIC_RELEASE);
+
+	lastSqe_ = sqe;
+	++pending_;
+
+	return sqe;
+}
+
+IoUring::Request* IoUring::prepare(struct io_uring_sqe* sqe, Completion&& cb)
+{
+	Request* request;
+
+	if (!freeList_.empty()) {
+		request = freeList_.back();
+		freeList_.pop_back();
+	} else {
+		request = new Request();
+		requests_.push_back(request);
+	}
+
+	request->callback = std::move(cb);
+	request->refs = 1;
+	sqe->user_data = reinterpret_cast<uintptr_t>(request);
+
+	if (inflight_++ == 0)
+		ev_ref(loop_);
+
+	return request;
+}
+
+void IoUring::release(Request* request)
+{
+	if (--request->refs == 0) {
+		request->callback = nullptr;
+		freeList_.push_back(request);
+	}
+
+	if (--inflight_ == 0)
+		ev_unref(loop_);
+}
+
+/*! queues a pread() (or read() for \p offset -1) for submission.
+ *
+ * \return request handle, valid until its completion, or nullptr on failure.
+ */
+IoUring::Request* IoUring::read(int fd, void* buf, size_t size, off_t offset, Completion cb)
+{
+	struct io_uring_sqe* sqe = acquireSqe();
+	if (!sqe)
+		return nullptr;
+
+	sqe->opcode = IORING_OP_READ;
+	sqe->fd = fd;
+	sqe->addr = reinterpret_cast<uintptr_t>(buf);
+	sqe->len = size;
+	sqe->off = offset;
+
+	return prepare(sqe, std::move(cb));
+}
+
+/*! queues a pwrite() (or write() for \p offset -1) for submission.
+ */
+IoUring::Request* IoUring::write(int fd, const void* buf, size_t size, off_t offset, Completion cb)
+{
+	struct io_uring_sqe* sqe = acquireSqe();
+	if (!sqe)
+		return nullptr;
+
+	sqe->opcode = IORING_OP_WRITE;
+	sqe->fd = fd;
+	sqe->addr = reinterpret_cast<uintptr_t>(buf);
+	sqe->len = size;
+	sqe->off = offset;
+
+	return prepare(sqe, std::move(cb));
+}
+
+/*! queues a preadv() for submission, \p iov must remain valid until completion.
+ */
+IoUring::Request* IoUring::readv(int fd, const struct iovec* iov, int iovcnt, off_t offset, Completion cb)
+{
+	struct io_uring_sqe* sqe = acquireSqe();
+	if (!sqe)
+		return nullptr;
+
+	sqe->opcode = IORING_OP_READV;
+	sqe->fd = fd;
+	sqe->addr = reinterpret_cast<uintptr_t>(iov);
+	sqe->len = iovcnt;
+	sqe->off = offset;
+
+	return prepare(sqe, std::move(cb));
+}
+
+/*! queues a pwritev() for submission, \p iov must remain valid until completion.
+ */
+IoUring::Request* IoUring::writev(int fd, const struct iovec* iov, int iovcnt, off_t offset, Completion cb)
+{
+	struct io_uring_sqe* sqe = acquireSqe();
+	if (!sqe)
+		return nullptr;
+
+	sqe->opcode = IORING_OP_WRITEV;
+	sqe->fd = fd;
+	sqe->addr = reinterpret_cast<uintptr_t>(iov);
+	sqe->len = iovcnt;
+	sqe->off = offset;
+
+	return prepare(sqe, std::move(cb));
+}
+
+/*! queues a splice() for submission, pass -1 as offset for pipes and sockets.
+ *
+ * Use \p link() in between two splices to chain file-to-pipe and pipe-to-socket
+ * transfers, the io_uring equivalent to sendfile().
+ */
+IoUring::Request* IoUring::splice(int fdIn, off_t offIn, int fdOut, off_t offOut, size_t size, unsigned flags, Completion cb)
+{
+	struct io_uring_sqe* sqe = acquireSqe();
+	if (!sqe)
+		return nullptr;
+
+	sqe->opcode = IORING_OP_SPLICE;
+	sqe->fd = fdOut;
+	sqe->off = offOut;
+	sqe->splice_fd_in = fdIn;
+	sqe->splice_off_in = offIn;
+	sqe->len = size;
+	sqe->splice_flags = flags;
+
+	return prepare(sqe, std::move(cb));
+}
+
+/*! queues a one-shot readiness poll for submission.
+ *
+ * \param events POLLIN/POLLOUT mask
+ *
+ * The completion result is the mask of ready events.
+ */
+IoUring::Request* IoUring::poll(int fd, int events, Completion cb)
+{
+	struct io_uring_sqe* sqe = acquireSqe();
+	if (!sqe)
+		return nullptr;
+
+	sqe->opcode = IORING_OP_POLL_ADD;
+	sqe->fd = fd;
+	sqe->poll32_events = events;
+
+	return prepare(sqe, std::move(cb));
+}
+
+/*! makes the next queued request start only after the last queued one succeeded.
+ */
+void IoUring::link()
+{
+	if (lastSqe_) {
+		lastSqe_->flags |= IOSQE_IO_LINK;
+	}
+}
+
+/*! cancels a request in flight, its completion callback will not be invoked anymore.
+ */
+void IoUring::cancel(Request* request)
+{
+	request->callback = nullptr;
+
+	if (struct io_uring_sqe* sqe = acquireSqe()) {
+		sqe->opcode = IORING_OP_ASYNC_CANCEL;
+		sqe->addr = reinterpret_cast<uintptr_t>(request);
+
+		// tagged reference, so that the request is not recycled before the cancellation completed
+		sqe->user_data = reinterpret_cast<uintptr_t>(request) | CANCEL_TAG;
+		++request->refs;
+
+		if (inflight_++ == 0)
+			ev_ref(loop_);
+	}
+}
+
+/*! submits all queued requests to the kernel.
+ *
+ * This is done automatically once per loop iteration.
+ */
+bool IoUring::submit()
+{
+	while (pending_ > 0) {
+		int rv = sys_io_uring_enter(fd_, pending_, 0, 0);
+
+		if (rv < 0) {
+			if (errno == EINTR)
+				continue;
+
+			// EAGAIN/EBUSY: the kernel is out of resources or completions must be reaped first,
+			// retry on the next loop iteration.
+			return false;
+		}
+
+		TRACE("submitted %d of %zu requests", rv, pending_);
+		pending_ -= rv;
+	}
+
+	return true;
+}
+
+void IoUring::onPrepare(ev::prepare&, int)
+{
+	lastSqe_ = nullptr;
+
+	if (pending_ > 0) {
+		submit();
+	}
+}
+
+void IoUring::onCompletion(ev::io&, int)
+{
+	uint64_t count;
+	(void) ::read(eventFd_, &count, sizeof(count));
+
+	unsigned head = *cqHead_;
+
+	while (head != __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE)) {
+		struct io_uring_cqe* cqe = &cqes_[head & *cqMask_];
+		uintptr_t userData = static_cast<uintptr_t>(cqe->user_data);
+		Request* request = reinterpret_cast<Request*>(userData & ~CANCEL_TAG);
+		ssize_t result = cqe->res;
+
+		__atomic_store_n(cqHead_, ++head, __ATOMIC_RELEASE);
+
+		if (userData & CANCEL_TAG) {
+			release(request);
+			continue;
+		}
+
+		// release before invoking, so that the callback may queue new requests
+		Completion cb(std::move(request->callback));
+		release(request);
+
+		if (cb) {
+			cb(result);
+		}
+	}
+}
+// }}}
+#else // {{{ no io_uring available at build time
+IoUring::IoUring(struct ev_loop* loop, unsigned entries) :
+	loop_(loop),
+	fd_(-1),
+	eventFd_(-1),
+	errno_(ENOSYS),
+	pending_(0),
+	inflight_(0),
+	prepare_(loop),
+	completion_(loop)
+{
+}
+
+IoUring::~IoUring()
+{
+}
+
+bool IoUring::isSupported()
+{
+	return false;
+}
+
+IoUring::Request* IoUring::read(int, void*, size_t, off_t, Completion) { errno = ENOSYS; return nullptr; }
+IoUring::Request* IoUring::write(int, const void*, size_t, off_t, Completion) { errno = ENOSYS; return nullptr; }
+IoUring::Request* IoUring::readv(int, const struct iovec*, int, off_t, Completion) { errno = ENOSYS; return nullptr; }
+IoUring::Request* IoUring::writev(int, const struct iovec*, int, off_t, Completion) { errno = ENOSYS; return nullptr; }
+IoUring::Request* IoUring::splice(int, off_t, int, off_t, size_t, unsigned, Completion) { errno = ENOSYS; return nullptr; }
+IoUring::Request* IoUring::poll(int, int, Completion) { errno = ENOSYS; return nullptr; }
+void IoUring::link() {}
+void IoUring::cancel(Request*) {}
+bool IoUring::submit() { return false; }
+// }}}
+#endif
+
+} // namespace xio
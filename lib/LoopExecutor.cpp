@@ -0,0 +1,211 @@
+/* <xio/LoopExecutor.cpp>
+ *
+ * This file is part of the x0 web server project and is released under LGPL-3.
+ * http://www.xzero.io/
+ *
+ * (c) 2009-2013 Christian Parpart <trapni@gmail.com>
+ */
+
+#include <xio/LoopExecutor.h>
+#include <assert.h>
+
+namespace xio {
+
+#if 0 // !defined(XIO_NDEBUG)
+#	define TRACE(msg...) do { printf("LoopExecutor: " msg); printf("\n"); } while (0)
+#else
+#	define TRACE(msg...) do { } while (0)
+#endif
+
+/*! initializes the executor, not yet attached to any thread.
+ *
+ * \param loop the event loop to run the tasks on.
+ * \param capacity maximum number of queued tasks, rounded up to the next power of two.
+ * \param budget maximum number of tasks to run per loop iteration.
+ *
+ * \see attach()
+ */
+LoopExecutor::LoopExecutor(struct ev_loop* loop, size_t capacity, size_t budget) :
+	loop_(loop),
+	cells_(),
+	mask_(0),
+	budget_(budget),
+	enqueuePos_(0),
+	enqueuePadding_(),
+	dequeuePos_(0),
+	dequeuePadding_(),
+	notified_(false),
+	owner_(std::thread::id()),
+	wakeup_(loop)
+{
+	size_t size = 2;
+	while (size < capacity)
+		size <<= 1;
+
+	mask_ = size - 1;
+	cells_.reset(new Cell[size]);
+
+	for (size_t i = 0; i < size; ++i)
+		cells_[i].sequence.store(i, std::memory_order_relaxed);
+
+	wakeup_.set<LoopExecutor, &LoopExecutor::onWakeup>(this);
+	wakeup_.start();
+}
+
+LoopExecutor::~LoopExecutor()
+{
+	wakeup_.stop();
+}
+
+/*! approximate number of queued tasks.
+ */
+size_t LoopExecutor::size() const
+{
+	return enqueuePos_.load(std::memory_order_relaxed) - dequeuePos_.load(std::memory_order_relaxed);
+}
+
+/*! marks the calling thread as the one running the loop.
+ *
+ * This happens implicitly on the first wakeup of the loop. Invoke it explicitly
+ * from the loop's thread before running the loop, for dispatch() to run tasks inline
+ * (and post() to make space on a full queue) right from the start.
+ */
+void LoopExecutor::attach()
+{
+	owner_.store(std::this_thread::get_id(), std::memory_order_relaxed);
+}
+
+bool LoopExecutor::isInLoopThread() const
+{
+	return owner_.load(std::memory_order_relaxed) == std::this_thread::get_id();
+}
+
+/*! enqueues a task, unless the queue is full.
+ *
+ * This function is thread-safe.
+ *
+ * \retval true the task has been queued.
+ * \retval false the queue is full, the task has been discarded.
+ */
+bool LoopExecutor::tryPost(Task task)
+{
+	if (!enqueue(task))
+		return false;
+
+	notify();
+	return true;
+}
+
+/*! enqueues a task, waiting for space in the queue if full.
+ *
+ * When invoked from within the loop's thread on a full queue, queued tasks are run
+ * inline to make space, as waiting would never finish.
+ *
+ * This function is thread-safe.
+ */
+void LoopExecutor::post(Task task)
+{
+	while (!enqueue(task)) {
+		if (isInLoopThread())
+			drain(budget_);
+		else
+			std::this_thread::yield();
+	}
+
+	notify();
+}
+
+/*! runs the task right away when invoked from within the loop's thread, or posts it otherwise.
+ *
+ * This function is thread-safe.
+ */
+void LoopExecutor::dispatch(Task task)
+{
+	if (isInLoopThread())
+		task();
+	else
+		post(std::move(task));
+}
+
+/*! reserves a cell and moves the task in, leaving \p task untouched if the queue is full.
+ */
+bool LoopExecutor::enqueue(Task& task)
+{
+	size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+	Cell* cell;
+
+	for (;;) {
+		cell = &cells_[pos & mask_];
+		size_t seq = cell->sequence.load(std::memory_order_acquire);
+		intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+
+		if (diff == 0) {
+			if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				break;
+		} else if (diff < 0) {
+			return false;
+		} else {
+			pos = enqueuePos_.load(std::memory_order_relaxed);
+		}
+	}
+
+	cell->task = std::move(task);
+	cell->sequence.store(pos + 1, std::memory_order_release);
+
+	return true;
+}
+
+void LoopExecutor::notify()
+{
+	// coalesce wakeups until the loop picked up the queue again
+	if (!notified_.exchange(true, std::memory_order_acq_rel)) {
+		wakeup_.send();
+	}
+}
+
+/*! runs up to \p limit queued tasks from within the loop's thread.
+ *
+ * \return number of tasks run.
+ */
+size_t LoopExecutor::drain(size_t limit)
+{
+	size_t count = 0;
+
+	while (count < limit) {
+		// only ever written by this thread, others just read it in size()
+		size_t pos = dequeuePos_.load(std::memory_order_relaxed);
+		Cell* cell = &cells_[pos & mask_];
+		size_t seq = cell->sequence.load(std::memory_order_acquire);
+
+		if (static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1) < 0)
+			break; // empty
+
+		Task task(std::move(cell->task));
+		cell->task = nullptr;
+		cell->sequence.store(pos + mask_ + 1, std::memory_order_release);
+		dequeuePos_.store(pos + 1, std::memory_order_relaxed);
+		++count;
+
+		task();
+	}
+
+	return count;
+}
+
+void LoopExecutor::onWakeup(ev::async&, int)
+{
+	attach();
+
+	// re-arm notifications before draining, so that tasks posted meanwhile wake us up again.
+	notified_.store(false, std::memory_order_release);
+
+	size_t count = drain(budget_);
+	TRACE("ran %zu tasks", count);
+
+	if (count == budget_ && size() > 0) {
+		// budget exhausted, continue on the next loop iteration
+		notify();
+	}
+}
+
+} // namespace xio
@@ -0,0 +1,150 @@
+/* <xio/MemoryBudget.cpp>
+ *
+ * This file is part of the x0 web server project and is released under LGPL-3.
+ * http://www.xzero.io/
+ *
+ * (c) 2009-2013 Christian Parpart <trapni@gmail.com>
+ */
+
+#include <xio/MemoryBudget.h>
+#include <algorithm>
+#include <errno.h>
+
+namespace xio {
+
+/*! initializes the budget.
+ *
+ * \param limit maximum number of bytes to hand out, 0 for no limit (accounting only).
+ * \param parent budget to additionally charge, must outlive this budget.
+ */
+MemoryBudget::MemoryBudget(size_t limit, MemoryBudget* parent) :
+	parent_(parent),
+	limit_(limit),
+	used_(0),
+	peak_(0),
+	rejected_(0),
+	allocator_(this, BufferAllocator::defaultAllocator())
+{
+}
+
+/*! retrieves the number of bytes that can still be charged, taking parents into account.
+ */
+size_t MemoryBudget::available() const
+{
+	size_t result = static_cast<size_t>(-1);
+
+	for (const MemoryBudget* b = this; b != nullptr; b = b->parent_) {
+		size_t limit = b->limit();
+		if (limit == 0)
+			continue;
+
+		size_t used = b->used();
+		result = std::min(result, used < limit ? limit - used : 0);
+	}
+
+	return result;
+}
+
+/*! charges \p n bytes to this budget and all of its parents.
+ *
+ * \retval true success
+ * \retval false the limit of this budget or one of its parents would be exceeded, errno is set to EAGAIN.
+ */
+bool MemoryBudget::charge(size_t n)
+{
+	size_t used = used_.load(std::memory_order_relaxed);
+	size_t value;
+
+	do {
+		value = used + n;
+		size_t limit = limit_.load(std::memory_order_relaxed);
+
+		if (limit != 0 && value > limit) {
+			rejected_.fetch_add(1, std::memory_order_relaxed);
+			errno = EAGAIN;
+			return false;
+		}
+	} while (!used_.compare_exchange_weak(used, value, std::memory_order_relaxed));
+
+	if (parent_ && !parent_->charge(n)) {
+		used_.fetch_sub(n, std::memory_order_relaxed);
+		rejected_.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	size_t peak = peak_.load(std::memory_order_relaxed);
+	while (value > peak && !peak_.compare_exchange_weak(peak, value, std::memory_order_relaxed))
+		;
+
+	return true;
+}
+
+/*! releases \p n previously charged bytes from this budget and all of its parents.
+ */
+void MemoryBudget::release(size_t n)
+{
+	used_.fetch_sub(n, std::memory_order_relaxed);
+
+	if (parent_)
+		parent_->release(n);
+}
+
+// {{{ MemoryBudget::Allocator
+/* Charges the capacity of each allocation to the budget, and takes the storage from the backend.
+ */
+MemoryBudget::Allocator::Allocator(MemoryBudget* budget, BufferAllocator* backend) :
+	budget_(budget),
+	backend_(backend)
+{
+}
+
+size_t MemoryBudget::Allocator::grow(size_t capacity, size_t required) const
+{
+	size_t value = backend_->grow(capacity, required);
+
+	// don't let the backend's geometric growth overshoot what is left of the budget,
+	// as long as the required capacity still fits.
+	size_t available = budget_->available();
+	if (value > capacity && value - capacity > available)
+		value = std::max(required, capacity + available);
+
+	return value;
+}
+
+char* MemoryBudget::Allocator::allocate(size_t capacity)
+{
+	if (!budget_->charge(capacity))
+		return nullptr;
+
+	char* data = backend_->allocate(capacity);
+	if (!data)
+		budget_->release(capacity);
+
+	return data;
+}
+
+char* MemoryBudget::Allocator::reallocate(char* data, size_t capacity, size_t newCapacity)
+{
+	if (newCapacity > capacity && !budget_->charge(newCapacity - capacity))
+		return nullptr;
+
+	char* result = backend_->reallocate(data, capacity, newCapacity);
+
+	if (!result) {
+		if (newCapacity > capacity)
+			budget_->release(newCapacity - capacity);
+	} else if (newCapacity < capacity) {
+		budget_->release(capacity - newCapacity);
+	}
+
+	return result;
+}
+
+void MemoryBudget::Allocator::deallocate(char* data, size_t capacity)
+{
+	backend_->deallocate(data, capacity);
+	budget_->release(capacity);
+}
+// }}}
+
+} // namespace xio
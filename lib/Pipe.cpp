@@ -42,6 +42,37 @@ size_t Pipe::size() const
 	return size_;
 }
 
+/** Retrieves the kernel buffer size of this pipe in bytes.
+ */
+size_t Pipe::capacity() const
+{
+#if defined(F_GETPIPE_SZ)
+	int rv = fcntl(writeFd(), F_GETPIPE_SZ);
+	if (rv > 0)
+		return rv;
+#endif
+
+	return 0;
+}
+
+/** Resizes the kernel buffer of this pipe.
+ *
+ * @param value requested size in bytes. The kernel rounds this up to page size
+ *              and may cap it at /proc/sys/fs/pipe-max-size.
+ *
+ * @retval true the pipe has been resized.
+ * @retval false the pipe could not be resized (errno is set).
+ */
+bool Pipe::setCapacity(size_t value)
+{
+#if defined(F_SETPIPE_SZ)
+	return fcntl(writeFd(), F_SETPIPE_SZ, static_cast<int>(value)) >= 0;
+#else
+	errno = ENOTSUP;
+	return false;
+#endif
+}
+
 void Pipe::clear()
 {
 	char buf[4096];
@@ -80,7 +111,7 @@ ssize_t Pipe::write(Socket* socket, size_t size, Mode mode)
 ssize_t Pipe::write(Pipe* pipe, size_t size, Mode mode)
 {
 	if (mode == MOVE) {
-		ssize_t rv = splice(pipe->readFd(), NULL, writeFd(), NULL, pipe->size_, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+		ssize_t rv = splice(pipe->readFd(), NULL, writeFd(), NULL, std::min(size, pipe->size_), SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
 		if (rv > 0) {
 			pipe->size_ -= rv;
 			size_ += rv;
@@ -149,7 +180,7 @@ ssize_t Pipe::read(char* buf, size_t size)
 
 ssize_t Pipe::read(Socket* socket, size_t size)
 {
-	return 0;//socket->read(this, size);
+	return socket->write(this, size, Stream::MOVE);
 }
 
 ssize_t Pipe::read(Pipe* pipe, size_t size)
@@ -0,0 +1,106 @@
+/* <xio/PipePool.cpp>
+ *
+ * This file is part of the x0 web server project and is released under LGPL-3.
+ * http://www.xzero.io/
+ *
+ * (c) 2009-2013 Christian Parpart <trapni@gmail.com>
+ */
+
+#include <xio/PipePool.h>
+#include <xio/Pipe.h>
+#include <fcntl.h>
+
+namespace xio {
+
+/** Initializes an empty pipe pool.
+ *
+ * @param highWaterMark maximum number of idle pipes to keep around.
+ * @param pipeSize kernel buffer size to apply to newly created pipes (0 for system default).
+ */
+PipePool::PipePool(size_t highWaterMark, size_t pipeSize) :
+	pipes_(),
+	highWaterMark_(highWaterMark),
+	pipeSize_(pipeSize)
+{
+	pipes_.reserve(highWaterMark_);
+}
+
+PipePool::~PipePool()
+{
+	clear();
+}
+
+/** Retrieves an empty pipe, either recycled or newly created.
+ *
+ * @return the pipe or \c nullptr if no pipe could be created (errno is set).
+ */
+Pipe* PipePool::acquire()
+{
+	if (!pipes_.empty()) {
+		Pipe* pipe = pipes_.back();
+		pipes_.pop_back();
+		return pipe;
+	}
+
+	Pipe* pipe = new Pipe(O_NONBLOCK | O_CLOEXEC);
+	if (!pipe->isOpen()) {
+		delete pipe;
+		return nullptr;
+	}
+
+	if (pipeSize_)
+		pipe->setCapacity(pipeSize_);
+
+	return pipe;
+}
+
+/** Hands a pipe back to the pool for later reuse.
+ *
+ * The ownership of the pipe is passed to the pool.
+ */
+void PipePool::release(Pipe* pipe)
+{
+	if (!pipe)
+		return;
+
+	if (pipe->isOpen() && pipe->isEmpty() && pipes_.size() < highWaterMark_) {
+		pipes_.push_back(pipe);
+	} else {
+		delete pipe;
+	}
+}
+
+/** Destroys all idle pipes.
+ */
+void PipePool::clear()
+{
+	for (auto pipe: pipes_)
+		delete pipe;
+
+	pipes_.clear();
+}
+
+void PipePool::setHighWaterMark(size_t value)
+{
+	highWaterMark_ = value;
+
+	while (pipes_.size() > highWaterMark_) {
+		delete pipes_.back();
+		pipes_.pop_back();
+	}
+}
+
+/** Sets the kernel buffer size for pooled pipes, resizing all idle ones.
+ */
+void PipePool::setPipeSize(size_t value)
+{
+	pipeSize_ = value;
+
+	if (pipeSize_) {
+		for (auto pipe: pipes_) {
+			pipe->setCapacity(pipeSize_);
+		}
+	}
+}
+
+} // namespace xio
@@ -0,0 +1,342 @@
+/* <xio/RingBufferStream.cpp>
+ *
+ * This file is part of the x0 web server project and is released under LGPL-3.
+ * http://www.xzero.io/
+ *
+ * (c) 2009-2013 Christian Parpart <trapni@gmail.com>
+ */
+
+#include <xio/RingBufferStream.h>
+#include <xio/StreamVisitor.h>
+#include <xio/Buffer.h>
+#include <xio/Socket.h>
+#include <xio/Pipe.h>
+#include <xio/sysconfig.h>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <errno.h>
+
+namespace xio {
+
+/*! initializes an empty ring of the given capacity.
+ *
+ * \param capacity number of bytes the stream can hold.
+ * \param mirrored whether to map the ring twice, back to back, for contiguous access.
+ *                 The capacity is then rounded up to a multiple of the page size.
+ *                 Falls back to a plain ring if the system does not support it.
+ */
+RingBufferStream::RingBufferStream(size_t capacity, bool mirrored) :
+	buffer_(nullptr),
+	capacity_(capacity),
+	head_(0),
+	size_(0),
+	mirrored_(false)
+{
+	if (mirrored && map())
+		return;
+
+	buffer_ = static_cast<char*>(std::malloc(capacity_));
+	if (!buffer_)
+		capacity_ = 0;
+}
+
+RingBufferStream::~RingBufferStream()
+{
+	if (mirrored_)
+		::munmap(buffer_, 2 * capacity_);
+	else
+		std::free(buffer_);
+}
+
+/*! maps one memfd twice into one contiguous reservation of twice the capacity.
+ */
+bool RingBufferStream::map()
+{
+#if defined(HAVE_MEMFD_CREATE)
+	size_t pageSize = sysconf(_SC_PAGESIZE);
+	size_t capacity = std::max(pageSize, (capacity_ + pageSize - 1) / pageSize * pageSize);
+
+	int fd = ::memfd_create("xio-ring", MFD_CLOEXEC);
+	if (fd < 0)
+		return false;
+
+	if (::ftruncate(fd, capacity) < 0) {
+		::close(fd);
+		return false;
+	}
+
+	char* base = static_cast<char*>(::mmap(nullptr, 2 * capacity, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+	if (base == MAP_FAILED) {
+		::close(fd);
+		return false;
+	}
+
+	bool ok = ::mmap(base, capacity, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) != MAP_FAILED
+		&& ::mmap(base + capacity, capacity, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) != MAP_FAILED;
+
+	::close(fd);
+
+	if (!ok) {
+		::munmap(base, 2 * capacity);
+		return false;
+	}
+
+	buffer_ = base;
+	capacity_ = capacity;
+	mirrored_ = true;
+
+	return true;
+#else
+	return false;
+#endif
+}
+
+size_t RingBufferStream::size() const
+{
+	return size_;
+}
+
+void RingBufferStream::clear()
+{
+	head_ = 0;
+	size_ = 0;
+}
+
+/*! retrieves the memory regions holding the buffered data, in order.
+ *
+ * \param iov array of at least two elements to store the regions to.
+ * \param limit maximum number of bytes to cover.
+ * \return number of regions stored (0, 1 or 2), the second one always starts at the beginning of the ring.
+ */
+int RingBufferStream::readRegions(struct iovec* iov, size_t limit) const
+{
+	size_t n = std::min(size_, limit);
+	if (n == 0)
+		return 0;
+
+	size_t first = mirrored_ ? n : std::min(n, capacity_ - head_);
+
+	iov[0].iov_base = buffer_ + head_;
+	iov[0].iov_len = first;
+
+	if (first == n)
+		return 1;
+
+	iov[1].iov_base = buffer_;
+	iov[1].iov_len = n - first;
+
+	return 2;
+}
+
+/*! retrieves the free memory regions, in order, to be filled and then committed via \p commit().
+ *
+ * \param iov array of at least two elements to store the regions to.
+ * \param limit maximum number of bytes to cover.
+ * \return number of regions stored (0, 1 or 2).
+ */
+int RingBufferStream::writeRegions(struct iovec* iov, size_t limit)
+{
+	size_t n = std::min(available(), limit);
+	if (n == 0)
+		return 0;
+
+	size_t i = tail();
+	size_t first = mirrored_ ? n : std::min(n, capacity_ - i);
+
+	iov[0].iov_base = buffer_ + i;
+	iov[0].iov_len = first;
+
+	if (first == n)
+		return 1;
+
+	iov[1].iov_base = buffer_;
+	iov[1].iov_len = n - first;
+
+	return 2;
+}
+
+/*! drops the given number of bytes from the front.
+ */
+void RingBufferStream::consume(size_t n)
+{
+	n = std::min(n, size_);
+	size_ -= n;
+
+	if (size_ == 0) {
+		// keep future regions contiguous for as long as possible
+		head_ = 0;
+	} else {
+		head_ += n;
+		if (head_ >= capacity_)
+			head_ -= capacity_;
+	}
+}
+
+/*! appends the given number of bytes, previously written into the regions returned by \p writeRegions().
+ */
+void RingBufferStream::commit(size_t n)
+{
+	size_ += std::min(n, available());
+}
+
+// {{{ write to ring
+ssize_t RingBufferStream::write(const char* buf, size_t size)
+{
+	struct iovec iov[2];
+	int n = writeRegions(iov, size);
+
+	if (n == 0 && size != 0) {
+		errno = EAGAIN;
+		return -1;
+	}
+
+	size_t nwritten = 0;
+	for (int i = 0; i < n; ++i) {
+		memcpy(iov[i].iov_base, buf + nwritten, iov[i].iov_len);
+		nwritten += iov[i].iov_len;
+	}
+
+	commit(nwritten);
+	return nwritten;
+}
+
+ssize_t RingBufferStream::write(Socket* socket, size_t size, Mode /*mode*/)
+{
+	return write(socket->handle(), size);
+}
+
+ssize_t RingBufferStream::write(Pipe* pipe, size_t size, Mode /*mode*/)
+{
+	struct iovec iov[2];
+	int n = writeRegions(iov, size);
+
+	if (n == 0 && size != 0) {
+		errno = EAGAIN;
+		return -1;
+	}
+
+	// Pipe must keep track of its size, so no readv() here
+	ssize_t nread = 0;
+	for (int i = 0; i < n; ++i) {
+		ssize_t rv = pipe->read(static_cast<char*>(iov[i].iov_base), iov[i].iov_len);
+		if (rv <= 0)
+			return committed(nread ? nread : rv);
+
+		nread += rv;
+
+		if (static_cast<size_t>(rv) < iov[i].iov_len)
+			break;
+	}
+
+	return committed(nread);
+}
+
+ssize_t RingBufferStream::write(int fd, size_t size)
+{
+	struct iovec iov[2];
+	int n = writeRegions(iov, size);
+
+	if (n == 0 && size != 0) {
+		errno = EAGAIN;
+		return -1;
+	}
+
+	return committed(::readv(fd, iov, n));
+}
+// }}}
+
+// {{{ read from ring
+ssize_t RingBufferStream::read(Buffer& result, size_t size)
+{
+	struct iovec iov[2];
+	int n = readRegions(iov, size);
+
+	size_t nread = 0;
+	for (int i = 0; i < n; ++i) {
+		result.push_back(static_cast<const char*>(iov[i].iov_base), iov[i].iov_len);
+		nread += iov[i].iov_len;
+	}
+
+	consume(nread);
+	return nread;
+}
+
+ssize_t RingBufferStream::read(char* buf, size_t size)
+{
+	struct iovec iov[2];
+	int n = readRegions(iov, size);
+
+	size_t nread = 0;
+	for (int i = 0; i < n; ++i) {
+		memcpy(buf + nread, iov[i].iov_base, iov[i].iov_len);
+		nread += iov[i].iov_len;
+	}
+
+	consume(nread);
+	return nread;
+}
+
+ssize_t RingBufferStream::read(Socket* socket, size_t size)
+{
+	struct iovec iov[2];
+	int n = readRegions(iov, size);
+
+	if (n == 0)
+		return 0;
+
+	return consumed(socket->writev(iov, n));
+}
+
+ssize_t RingBufferStream::read(Pipe* pipe, size_t size)
+{
+	struct iovec iov[2];
+	int n = readRegions(iov, size);
+
+	// Pipe must keep track of its size, so no writev() here
+	ssize_t nwritten = 0;
+	for (int i = 0; i < n; ++i) {
+		ssize_t rv = pipe->write(static_cast<const char*>(iov[i].iov_base), iov[i].iov_len);
+		if (rv <= 0)
+			return consumed(nwritten ? nwritten : rv);
+
+		nwritten += rv;
+
+		if (static_cast<size_t>(rv) < iov[i].iov_len)
+			break;
+	}
+
+	return consumed(nwritten);
+}
+
+ssize_t RingBufferStream::read(int fd, size_t size)
+{
+	struct iovec iov[2];
+	int n = readRegions(iov, size);
+
+	if (n == 0)
+		return 0;
+
+	return consumed(::writev(fd, iov, n));
+}
+
+int RingBufferStream::read()
+{
+	if (size_ == 0)
+		return -1;
+
+	int ch = static_cast<unsigned char>(buffer_[head_]);
+	consume(1);
+
+	return ch;
+}
+// }}}
+
+void RingBufferStream::accept(StreamVisitor& visitor)
+{
+	visitor.visit(*this);
+}
+
+} // namespace xio
@@ -0,0 +1,66 @@
+/* <xio/SharedBuffer.cpp>
+ *
+ * This file is part of the x0 web server project and is released under LGPL-3.
+ * http://www.xzero.io/
+ *
+ * (c) 2009-2013 Christian Parpart <trapni@gmail.com>
+ */
+
+#include <xio/SharedBuffer.h>
+
+namespace xio {
+
+/** Takes over the storage of the given buffer, without copying.
+ *
+ * The buffer is left empty.
+ */
+SharedBuffer::SharedBuffer(Buffer&& buffer) :
+	BufferRef(),
+	segment_(nullptr)
+{
+	if (buffer.capacity() == 0)
+		return;
+
+	BufferAllocator* owner = buffer.transferable();
+	if (!owner) {
+		// storage is embedded into the buffer, thus, copy into a segment of our own
+		*this = SharedBuffer(Buffer(buffer, 0, buffer.size()));
+		buffer.clear();
+		return;
+	}
+
+	segment_ = new Segment;
+	segment_->refs.store(1, std::memory_order_relaxed);
+	segment_->data = buffer.data_;
+	segment_->capacity = buffer.capacity_;
+	segment_->allocator = owner;
+
+	data_ = buffer.data_;
+	size_ = buffer.size_;
+
+	buffer.data_ = nullptr;
+	buffer.size_ = 0;
+	buffer.capacity_ = 0;
+}
+
+/** Creates a new segment holding a copy of the given data.
+ */
+SharedBuffer::SharedBuffer(const BufferRef& data) :
+	SharedBuffer(Buffer(data, 0, data.size()))
+{
+}
+
+void SharedBuffer::unref()
+{
+	if (!segment_)
+		return;
+
+	if (segment_->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+		segment_->allocator->deallocate(segment_->data, segment_->capacity);
+		delete segment_;
+	}
+
+	segment_ = nullptr;
+}
+
+} // namespace xio
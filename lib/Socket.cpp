@@ -6,6 +6,7 @@
 #include <sys/sendfile.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <linux/errqueue.h>
 #include <fcntl.h>
 #include <assert.h>
 
@@ -23,7 +24,12 @@ Socket::Socket(struct ev_loop* loop) :
 	io_(loop),
 	timeout_(TimeSpan::Zero),
 	timer_(loop),
-	handler_()
+	timerWheel_(nullptr),
+	wheelTimer_(),
+	handler_(),
+	zeroCopy_(false),
+	zeroCopyNextId_(0),
+	zeroCopyPending_()
 {
 	initialize();
 }
@@ -33,7 +39,12 @@ Socket::Socket(struct ev_loop* loop, int fd, int af, State state) :
 	state_(state),
 	io_(loop),
 	timer_(loop),
-	handler_()
+	timerWheel_(nullptr),
+	wheelTimer_(),
+	handler_(),
+	zeroCopy_(false),
+	zeroCopyNextId_(0),
+	zeroCopyPending_()
 {
 	(void) af;
 
@@ -49,14 +60,34 @@ void Socket::initialize()
 {
 	io_.set<Socket, &Socket::io>(this);
 	timer_.set<Socket, &Socket::timeout>(this);
+	wheelTimer_.set<Socket, &Socket::timeout>(this);
 }
 
 void Socket::close()
 {
 	if (fd_ >= 0) {
+		io_.stop();
+		stopTimer();
 		::close(fd_);
+		fd_ = -1;
 		state_ = Closed;
 	}
+
+	// the kernel keeps its own references to still pinned pages
+	zeroCopyPending_.clear();
+	zeroCopyNextId_ = 0;
+	zeroCopy_ = false;
+}
+
+/*! shuts down one or both directions of this connection.
+ *
+ * \param how SHUT_RD, SHUT_WR or SHUT_RDWR
+ * \retval 0 success
+ * \retval -1 failure, errno is set
+ */
+int Socket::shutdown(int how)
+{
+	return ::shutdown(fd_, how);
 }
 
 bool Socket::open(const SocketSpec& spec, int flags)
@@ -148,6 +179,69 @@ void Socket::setTcpCork(bool enable)
 	// TODO
 }
 
+/*! enables or disables sending via MSG_ZEROCOPY, see write(const SharedBuffer&, Mode).
+ *
+ * \retval true success
+ * \retval false failure, e.g. not supported by the kernel, errno is set.
+ */
+bool Socket::setZeroCopy(bool enable)
+{
+#if defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY)
+	int val = enable ? 1 : 0;
+	if (::setsockopt(fd_, SOL_SOCKET, SO_ZEROCOPY, &val, sizeof(val)) < 0)
+		return false;
+
+	zeroCopy_ = enable;
+	return true;
+#else
+	errno = ENOTSUP;
+	return false;
+#endif
+}
+
+/*! releases the buffers of all MSG_ZEROCOPY sends the kernel has completed.
+ *
+ * Completions are reported via the socket's error queue, which is checked automatically
+ * whenever the socket becomes readable or writable, and before each zero-copy send.
+ *
+ * \return number of sends still pending.
+ */
+size_t Socket::reapZeroCopy()
+{
+#if defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY)
+	while (!zeroCopyPending_.empty()) {
+		char control[CMSG_SPACE(sizeof(struct sock_extended_err)) + 64];
+		struct msghdr msg;
+		memset(&msg, 0, sizeof(msg));
+		msg.msg_control = control;
+		msg.msg_controllen = sizeof(control);
+
+		if (::recvmsg(fd_, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0)
+			break;
+
+		for (struct cmsghdr* cm = CMSG_FIRSTHDR(&msg); cm != nullptr; cm = CMSG_NXTHDR(&msg, cm)) {
+			if (!((cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR)
+					|| (cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR)))
+				continue;
+
+			const struct sock_extended_err* ee = (const struct sock_extended_err*) CMSG_DATA(cm);
+			if (ee->ee_errno != 0 || ee->ee_origin != SO_EE_ORIGIN_ZEROCOPY)
+				continue;
+
+			// [ee_info, ee_data] is the (inclusive) range of completed send ids,
+			// which are reported in order for stream sockets.
+			uint32_t last = ee->ee_data;
+			while (!zeroCopyPending_.empty()
+					&& static_cast<int32_t>(zeroCopyPending_.front().id - last) <= 0) {
+				zeroCopyPending_.pop_front();
+			}
+		}
+	}
+#endif
+
+	return zeroCopyPending_.size();
+}
+
 TimeSpan Socket::lingering() const
 {
 	// TODO
@@ -177,7 +271,10 @@ void Socket::on(int mode, TimeSpan timeout, std::function<void(int)> cb)
 
 	handler_ = cb;
 	timeout_ = timeout;
-	timer_.start(timeout.value(), 0);
+
+	if (timeout_)
+		startTimer(timeout_);
+
 	io_.start(fd_, mode);
 }
 
@@ -192,7 +289,7 @@ void Socket::watch(int mode, TimeSpan timeout)
 void Socket::watch(int mode)
 {
 	if (timeout_)
-		timer_.start(timeout_.value(), 0);
+		startTimer(timeout_);
 
 	if (io_.is_active())
 		io_.stop();
@@ -205,23 +302,70 @@ void Socket::restart()
 	if (!io_.is_active())
 		return;
 
-	if (timer_.is_active())
-		timer_.stop();
+	stopTimer();
 
 	if (timeout_)
-		timer_.start(timeout_.value());
+		startTimer(timeout_);
 }
 
 void Socket::stop()
 {
-	timer_.stop();
+	stopTimer();
 	io_.stop();
 	std::move(handler_);
 }
 
+/*! Moves this socket onto another event loop, e.g. to hand it over to another thread.
+ *
+ * The socket stops watching for I/O, and is detached from its timer wheel,
+ * as that belongs to the old loop. Invoke this from the thread owning the old loop
+ * before passing the socket on, e.g. via LoopExecutor::post().
+ */
+void Socket::setLoop(struct ev_loop* loop)
+{
+	stop();
+
+	timerWheel_ = nullptr;
+
+	io_.set(loop);
+	timer_.set(loop);
+}
+
+/*! Uses the given timer wheel for I/O timeouts instead of a dedicated ev::timer.
+ *
+ * This is recommended for servers with many concurrent connections, as
+ * re-arming a wheel timer is O(1), while re-arming an ev::timer is O(log n).
+ *
+ * \param wheel the timer wheel to use (must outlive this socket), or nullptr to use the ev::timer again.
+ */
+void Socket::setTimerWheel(TimerWheel* wheel)
+{
+	stopTimer();
+	timerWheel_ = wheel;
+}
+
+void Socket::startTimer(TimeSpan timeout)
+{
+	if (timerWheel_)
+		timerWheel_->start(&wheelTimer_, timeout);
+	else
+		timer_.start(timeout.value(), 0);
+}
+
+void Socket::stopTimer()
+{
+	if (timerWheel_)
+		wheelTimer_.stop();
+	else
+		timer_.stop();
+}
+
 void Socket::io(ev::io&, int revents)
 {
-	timer_.stop();
+	stopTimer();
+
+	if (!zeroCopyPending_.empty())
+		reapZeroCopy();
 
 	if (state_ == Connecting)
 		onConnectComplete();
@@ -286,6 +430,13 @@ void Socket::timeout(ev::timer&, int)
 	handler_(Socket::TIMEOUT);
 }
 
+void Socket::timeout(TimerWheel::Timer&)
+{
+	io_.stop();
+
+	handler_(Socket::TIMEOUT);
+}
+
 size_t Socket::size() const
 {
 	return 0; // not supported
@@ -358,9 +509,59 @@ ssize_t Socket::write(const char* buf, size_t size)
 	return ::write(fd_, buf, size);
 }
 
+/**
+ * Writes the given shared buffer to this socket.
+ *
+ * With \p mode being Stream::ZEROCOPY, zero-copy being enabled on this socket (see setZeroCopy())
+ * and the payload being at least \p ZeroCopyThreshold bytes, the kernel sends directly from
+ * the buffer's memory. The written part of the buffer is then kept referenced until the kernel
+ * reports completion, so the caller may drop its reference right away.
+ *
+ * @param data the data to write.
+ * @param mode Stream::ZEROCOPY to avoid copying the payload into the kernel, if possible.
+ *
+ * @return number of bytes written or -1 on error (errno is set).
+ */
+ssize_t Socket::write(const SharedBuffer& data, Mode mode)
+{
+#if defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY)
+	if (mode == Stream::ZEROCOPY && zeroCopy_ && data.size() >= ZeroCopyThreshold) {
+		if (!zeroCopyPending_.empty())
+			reapZeroCopy();
+
+		ssize_t rv = ::send(fd_, data.data(), data.size(), MSG_ZEROCOPY);
+
+		// each successful MSG_ZEROCOPY send consumes one completion id
+		if (rv >= 0)
+			zeroCopyPending_.push_back({ zeroCopyNextId_++, data.slice(0, rv) });
+
+		if (rv >= 0 || errno != ENOBUFS)
+			return rv;
+
+		// ENOBUFS: out of optmem for pinning pages, thus copy instead
+	}
+#endif
+
+	return ::write(fd_, data.data(), data.size());
+}
+
+/**
+ * Writes the given I/O vector (gathered write) to this socket.
+ *
+ * @param iov array of memory regions to write, in order.
+ * @param iovcnt number of elements in \p iov (at most IOV_MAX).
+ *
+ * @return number of bytes written, which may end in the middle of any region,
+ *         or -1 on error (errno is set).
+ */
+ssize_t Socket::writev(const struct iovec* iov, int iovcnt)
+{
+	return ::writev(fd_, iov, iovcnt);
+}
+
 ssize_t Socket::write(FileStream* fs, size_t size, Mode mode)
 {
-	return sendfile(fd_, fs->handle(), nullptr, size);
+	return fs->read(this, size);
 }
 
 ssize_t Socket::write(Socket* socket, size_t size, Mode mode)
@@ -378,7 +579,11 @@ ssize_t Socket::write(Pipe* pipe, size_t size, Mode mode)
 		? SPLICE_F_NONBLOCK | SPLICE_F_MORE | SPLICE_F_MOVE
 		: SPLICE_F_NONBLOCK | SPLICE_F_MORE;
 
-	return splice(pipe->readFd(), nullptr, fd_, nullptr, size, flags);
+	ssize_t rv = splice(pipe->readFd(), nullptr, fd_, nullptr, size, flags);
+	if (rv > 0)
+		pipe->size_ -= rv;
+
+	return rv;
 }
 
 ssize_t Socket::write(int fd, size_t size)
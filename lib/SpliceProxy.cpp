@@ -0,0 +1,290 @@
+/* <xio/SpliceProxy.cpp>
+ *
+ * This file is part of the x0 web server project and is released under LGPL-3.
+ * http://www.xzero.io/
+ *
+ * (c) 2009-2013 Christian Parpart <trapni@gmail.com>
+ */
+
+#include <xio/SpliceProxy.h>
+#include <xio/PipePool.h>
+#include <xio/Socket.h>
+#include <xio/Pipe.h>
+#include <sys/socket.h>
+#include <fcntl.h>
+#include <errno.h>
+
+namespace xio {
+
+#if 0 // !defined(XIO_NDEBUG)
+#	define TRACE(msg...) do { printf(msg); printf("\n"); } while (0)
+#else
+#	define TRACE(msg...) do { } while (0)
+#endif
+
+// maximum number of source reads per direction and I/O event,
+// so that one busy direction cannot starve the rest of the event loop.
+#define SPLICE_PROXY_MAX_READS 16
+
+/*! initializes a proxy between \p client and \p backend, taking ownership of both sockets.
+ *
+ * \param client the accepted downstream connection.
+ * \param backend the upstream connection, either operational or still connecting.
+ * \param pipePool optional pool to acquire the two intermediate pipes from.
+ */
+SpliceProxy::SpliceProxy(Socket* client, Socket* backend, PipePool* pipePool) :
+	upstream_{client, backend, nullptr, 0, false, false, false, false},
+	downstream_{backend, client, nullptr, 0, false, false, false, false},
+	pipePool_(pipePool),
+	chunkSize_(64 * 1024),
+	idleTimeout_(TimeSpan::Zero),
+	clientMode_(0),
+	backendMode_(0),
+	error_(0),
+	active_(false)
+{
+}
+
+SpliceProxy::~SpliceProxy()
+{
+	close();
+
+	delete upstream_.source;
+	delete upstream_.sink;
+}
+
+/*! starts forwarding data in both directions.
+ *
+ * \param idleTimeout time without any I/O on either side after which the proxy
+ *                    is finished with ETIMEDOUT, or TimeSpan::Zero for no timeout.
+ */
+void SpliceProxy::start(TimeSpan idleTimeout)
+{
+	if (active_)
+		return;
+
+	active_ = true;
+	error_ = 0;
+	idleTimeout_ = idleTimeout;
+
+	for (Direction* d: { &upstream_, &downstream_ }) {
+		d->pipe = pipePool_ ? pipePool_->acquire() : new Pipe(O_NONBLOCK | O_CLOEXEC);
+
+		if (!d->pipe || !d->pipe->isOpen()) {
+			finish(errno ? errno : EMFILE);
+			return;
+		}
+	}
+
+	if (backend()->state() == Socket::Connecting) {
+		TRACE("SpliceProxy: waiting for backend to connect");
+		backend()->on(Socket::CONNECTED, idleTimeout_, std::bind(&SpliceProxy::onBackendEvent, this, std::placeholders::_1));
+		backendMode_ = Socket::WRITE;
+		return;
+	}
+
+	startForwarding();
+}
+
+void SpliceProxy::startForwarding()
+{
+	upstream_.wantRead = true;
+	downstream_.wantRead = true;
+
+	client()->on(Socket::READ, idleTimeout_, std::bind(&SpliceProxy::onClientEvent, this, std::placeholders::_1));
+	clientMode_ = Socket::READ;
+
+	backend()->on(Socket::READ, idleTimeout_, std::bind(&SpliceProxy::onBackendEvent, this, std::placeholders::_1));
+	backendMode_ = Socket::READ;
+}
+
+/*! stops forwarding without invoking \p onClose().
+ *
+ * Data still buffered in the pipes is discarded.
+ */
+void SpliceProxy::close()
+{
+	if (!active_)
+		return;
+
+	active_ = false;
+
+	for (Direction* d: { &upstream_, &downstream_ }) {
+		d->source->stop();
+
+		if (d->pipe) {
+			if (pipePool_)
+				pipePool_->release(d->pipe);
+			else
+				delete d->pipe;
+
+			d->pipe = nullptr;
+		}
+	}
+
+	clientMode_ = 0;
+	backendMode_ = 0;
+}
+
+void SpliceProxy::onClientEvent(int revents)
+{
+	clientMode_ = 0; // the socket's watcher is stopped on timeouts
+
+	if (revents & Socket::TIMEOUT) {
+		finish(ETIMEDOUT);
+		return;
+	}
+
+	if ((revents & Socket::READ) && !pump(upstream_)) {
+		finish(errno);
+		return;
+	}
+
+	if ((revents & Socket::WRITE) && !pump(downstream_)) {
+		finish(errno);
+		return;
+	}
+
+	update();
+}
+
+void SpliceProxy::onBackendEvent(int revents)
+{
+	backendMode_ = 0; // the socket's watcher is stopped on timeouts and connect completion
+
+	if (revents & Socket::TIMEOUT) {
+		finish(ETIMEDOUT);
+		return;
+	}
+
+	if (revents & Socket::CONNECTED) {
+		if (backend()->state() != Socket::Operational) {
+			finish(errno ? errno : ECONNREFUSED);
+			return;
+		}
+
+		TRACE("SpliceProxy: backend connected");
+		startForwarding();
+		return;
+	}
+
+	if ((revents & Socket::READ) && !pump(downstream_)) {
+		finish(errno);
+		return;
+	}
+
+	if ((revents & Socket::WRITE) && !pump(upstream_)) {
+		finish(errno);
+		return;
+	}
+
+	update();
+}
+
+/*! moves as much data as currently possible from the direction's source into its sink.
+ *
+ * \retval true the direction is either done or waiting for readiness of one of its sockets.
+ * \retval false an I/O error occured, errno is set.
+ */
+bool SpliceProxy::pump(Direction& d)
+{
+	d.wantRead = false;
+	d.wantWrite = false;
+
+	for (int reads = 0; !d.done; ) {
+		if (!d.pipe->isEmpty()) {
+			ssize_t rv = d.sink->write(d.pipe, d.pipe->size(), Stream::MOVE);
+
+			if (rv > 0) {
+				d.bytes += rv;
+				continue;
+			}
+
+			if (rv < 0 && errno == EAGAIN) {
+				// sink is full: stop reading the source until the pipe could be flushed
+				d.wantWrite = true;
+				return true;
+			}
+
+			if (rv == 0)
+				errno = EPIPE;
+
+			return false;
+		}
+
+		if (d.eof) {
+			TRACE("SpliceProxy: half-closing after %zu bytes", d.bytes);
+			if (d.sink->shutdown(SHUT_WR) < 0 && errno != ENOTCONN)
+				return false;
+
+			d.done = true;
+			break;
+		}
+
+		if (reads++ == SPLICE_PROXY_MAX_READS) {
+			d.wantRead = true;
+			return true;
+		}
+
+		ssize_t rv = d.source->read(d.pipe, chunkSize_);
+
+		if (rv == 0) {
+			d.eof = true;
+		} else if (rv < 0) {
+			if (errno != EAGAIN)
+				return false;
+
+			d.wantRead = true;
+			return true;
+		}
+	}
+
+	return true;
+}
+
+void SpliceProxy::update()
+{
+	if (upstream_.done && downstream_.done) {
+		finish(0);
+		return;
+	}
+
+	watch(client(),
+		(upstream_.wantRead ? Socket::READ : 0) | (downstream_.wantWrite ? Socket::WRITE : 0),
+		clientMode_);
+
+	watch(backend(),
+		(downstream_.wantRead ? Socket::READ : 0) | (upstream_.wantWrite ? Socket::WRITE : 0),
+		backendMode_);
+}
+
+void SpliceProxy::watch(Socket* socket, int mode, int& current)
+{
+	if (mode == current) {
+		// activity on the proxy, re-arm the idle timer
+		socket->restart();
+	} else if (mode == 0) {
+		socket->stop();
+	} else {
+		socket->watch(mode);
+	}
+
+	current = mode;
+}
+
+void SpliceProxy::finish(int error)
+{
+	TRACE("SpliceProxy: finished (%s), %zu bytes up, %zu bytes down",
+		error ? strerror(error) : "success", upstream_.bytes, downstream_.bytes);
+
+	close();
+	error_ = error;
+
+	// the callback is allowed to destroy this proxy
+	auto cb = onClose;
+	if (cb) {
+		cb(this);
+	}
+}
+
+} // namespace xio
@@ -0,0 +1,122 @@
+/* <xio/ThreadPool.cpp>
+ *
+ * This file is part of the x0 web server project and is released under LGPL-3.
+ * http://www.xzero.io/
+ *
+ * (c) 2009-2013 Christian Parpart <trapni@gmail.com>
+ */
+
+#include <xio/ThreadPool.h>
+#include <xio/LoopExecutor.h>
+#include <errno.h>
+
+namespace xio {
+
+/*! starts the pool's threads.
+ *
+ * \param threads number of threads, i.e. the maximum number of concurrently blocking tasks.
+ * \param maxQueued maximum number of tasks waiting for a thread, further posts are rejected.
+ */
+ThreadPool::ThreadPool(size_t threads, size_t maxQueued) :
+	maxQueued_(maxQueued),
+	stopped_(false),
+	lock_(),
+	cond_(),
+	tasks_(),
+	threads_()
+{
+	for (size_t i = 0; i < threads; ++i) {
+		threads_.emplace_back(&ThreadPool::run, this);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	stop();
+}
+
+size_t ThreadPool::queued() const
+{
+	std::lock_guard<std::mutex> _l(lock_);
+	return tasks_.size();
+}
+
+/*! enqueues a task to be run on one of the pool's threads.
+ *
+ * This function is thread-safe.
+ *
+ * \retval true the task has been queued.
+ * \retval false the pool is stopped or its queue is full (errno is set to EAGAIN).
+ */
+bool ThreadPool::post(Task task)
+{
+	{
+		std::lock_guard<std::mutex> _l(lock_);
+
+		if (stopped_ || tasks_.size() >= maxQueued_) {
+			errno = EAGAIN;
+			return false;
+		}
+
+		tasks_.push_back(std::move(task));
+	}
+
+	cond_.notify_one();
+	return true;
+}
+
+/*! runs \p work on one of the pool's threads and passes its result to \p done within the executor's loop.
+ *
+ * \p done gets invoked with errno set to the value it had after running \p work.
+ */
+bool ThreadPool::post(LoopExecutor* executor, std::function<ssize_t()> work, std::function<void(ssize_t)> done)
+{
+	return post([executor, work, done]() {
+		ssize_t result = work();
+		int error = errno;
+
+		executor->post([done, result, error]() {
+			errno = error;
+			done(result);
+		});
+	});
+}
+
+/*! finishes all queued tasks and joins all threads.
+ */
+void ThreadPool::stop()
+{
+	{
+		std::lock_guard<std::mutex> _l(lock_);
+		stopped_ = true;
+	}
+
+	cond_.notify_all();
+
+	for (auto& thread: threads_) {
+		if (thread.joinable()) {
+			thread.join();
+		}
+	}
+}
+
+void ThreadPool::run()
+{
+	for (;;) {
+		Task task;
+		{
+			std::unique_lock<std::mutex> l(lock_);
+			cond_.wait(l, [this]() { return stopped_ || !tasks_.empty(); });
+
+			if (tasks_.empty())
+				return; // stopped
+
+			task = std::move(tasks_.front());
+			tasks_.pop_front();
+		}
+
+		task();
+	}
+}
+
+} // namespace xio
@@ -0,0 +1,178 @@
+/* <xio/TimerWheel.cpp>
+ *
+ * This file is part of the x0 web server project and is released under LGPL-3.
+ * http://www.xzero.io/
+ *
+ * (c) 2009-2013 Christian Parpart <trapni@gmail.com>
+ */
+
+#include <xio/TimerWheel.h>
+#include <cmath>
+#include <assert.h>
+
+namespace xio {
+
+/*! initializes the timer wheel.
+ *
+ * \param loop the event loop to tick on
+ * \param resolution the granularity of all timers on this wheel
+ * \param slots number of wheel slots; timeouts up to \p slots x \p resolution
+ *              do not need to be looked at before they expire.
+ */
+TimerWheel::TimerWheel(struct ev_loop* loop, TimeSpan resolution, size_t slots) :
+	loop_(loop),
+	resolution_(resolution),
+	slots_(slots, nullptr),
+	expired_(nullptr),
+	size_(0),
+	lastTick_(0),
+	ticker_(loop)
+{
+	assert(resolution_.value() > 0);
+	assert(slots > 0);
+
+	ticker_.set<TimerWheel, &TimerWheel::onTick>(this);
+}
+
+TimerWheel::~TimerWheel()
+{
+	slots_.push_back(expired_); // just so it gets cleared, too
+
+	for (auto timer: slots_) {
+		while (timer) {
+			Timer* next = timer->next_;
+			timer->wheel_ = nullptr;
+			timer->prev_ = nullptr;
+			timer->next_ = nullptr;
+			timer = next;
+		}
+	}
+
+	ticker_.stop();
+}
+
+uint64_t TimerWheel::currentTick() const
+{
+	return static_cast<uint64_t>(ev_now(loop_) / resolution_.value());
+}
+
+/*! starts (or re-arms) the given timer to expire after \p timeout.
+ */
+void TimerWheel::start(Timer* timer, TimeSpan timeout)
+{
+	if (timer->wheel_)
+		timer->wheel_->unlink(timer);
+
+	if (size_ == 0) {
+		lastTick_ = currentTick();
+		ticker_.start(resolution_.value(), resolution_.value());
+	}
+
+	// round up, so that a timer never fires early
+	uint64_t ticks = static_cast<uint64_t>(std::ceil(timeout.value() / resolution_.value()));
+
+	link(timer, currentTick() + std::max(ticks, static_cast<uint64_t>(1)));
+}
+
+/*! stops the given timer, if active.
+ */
+void TimerWheel::stop(Timer* timer)
+{
+	if (timer->wheel_ != this)
+		return;
+
+	unlink(timer);
+
+	if (size_ == 0) {
+		ticker_.stop();
+	}
+}
+
+void TimerWheel::link(Timer* timer, uint64_t expiry)
+{
+	Timer*& head = slots_[expiry % slots_.size()];
+
+	timer->wheel_ = this;
+	timer->expiry_ = expiry;
+	timer->prev_ = nullptr;
+	timer->next_ = head;
+
+	if (head)
+		head->prev_ = timer;
+
+	head = timer;
+	++size_;
+}
+
+void TimerWheel::unlink(Timer* timer)
+{
+	if (timer->prev_)
+		timer->prev_->next_ = timer->next_;
+	else if (timer == expired_)
+		expired_ = timer->next_;
+	else
+		slots_[timer->expiry_ % slots_.size()] = timer->next_;
+
+	if (timer->next_)
+		timer->next_->prev_ = timer->prev_;
+
+	timer->wheel_ = nullptr;
+	timer->prev_ = nullptr;
+	timer->next_ = nullptr;
+	--size_;
+}
+
+void TimerWheel::onTick(ev::timer&, int)
+{
+	const uint64_t now = currentTick();
+
+	// catch up on all ticks since the last run, but visit each slot at most once.
+	uint64_t tick = now - lastTick_ > slots_.size()
+		? now - slots_.size() + 1
+		: lastTick_ + 1;
+
+	for (; tick <= now && size_ > 0; ++tick) {
+		Timer*& head = slots_[tick % slots_.size()];
+
+		// move all expired timers of this slot onto the expired_ list first,
+		// as any callback may stop, re-arm or destroy any other timer of the slot.
+		for (Timer* timer = head; timer != nullptr; ) {
+			Timer* next = timer->next_;
+
+			if (timer->expiry_ <= now) {
+				if (timer->prev_)
+					timer->prev_->next_ = next;
+				else
+					head = next;
+
+				if (next)
+					next->prev_ = timer->prev_;
+
+				timer->prev_ = nullptr;
+				timer->next_ = expired_;
+				if (expired_)
+					expired_->prev_ = timer;
+				expired_ = timer;
+			}
+
+			timer = next;
+		}
+
+		// timers stopped (or re-armed) by a preceding callback have already left the expired_ list.
+		while (Timer* timer = expired_) {
+			unlink(timer);
+
+			if (timer->callback_) {
+				timer->callback_(*timer);
+			}
+		}
+	}
+
+	lastTick_ = now;
+
+	if (size_ == 0) {
+		ticker_.stop();
+	}
+}
+
+} // namespace xio
@@ -93,11 +93,26 @@ UnixServer::~UnixServer()
 {
 }
 
+/*! creates a copy of this listener, sharing its socket, to be served by the given event loop.
+ *
+ * \note the clone does not unlink the socket path on close, only the original listener does.
+ */
 UnixServer* UnixServer::clone(struct ev_loop* loop) const
 {
 	auto s = new UnixServer(loop);
 
-	s->open(path_, flags_);
+	s->setMultiAcceptCount(multiAcceptCount_);
+
+	if (isOpen()) {
+		s->fd_ = fcntl(fd_, F_DUPFD_CLOEXEC, 0);
+		if (s->fd_ < 0) {
+			s->errorText_ = strerror(errno);
+		} else {
+			s->flags_ = flags_;
+			s->typeMask_ = typeMask_;
+			s->start();
+		}
+	}
 
 	return s;
 }
@@ -0,0 +1,246 @@
+/* <xio/WorkerGroup.cpp>
+ *
+ * This file is part of the x0 web server project and is released under LGPL-3.
+ * http://www.xzero.io/
+ *
+ * (c) 2009-2013 Christian Parpart <trapni@gmail.com>
+ */
+
+#include <xio/WorkerGroup.h>
+#include <xio/ServerSocket.h>
+#include <xio/InetServer.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <algorithm>
+#include <assert.h>
+
+namespace xio {
+
+#if 0 // !defined(XIO_NDEBUG)
+#	define TRACE(msg...) do { printf(msg); printf("\n"); } while (0)
+#else
+#	define TRACE(msg...) do { } while (0)
+#endif
+
+// {{{ WorkerGroup
+/*! retrieves the CPUs this process may run on, honoring its affinity mask (e.g. taskset, cgroups).
+ */
+static std::vector<int> availableCPUs()
+{
+	std::vector<int> cpus;
+
+	cpu_set_t set;
+	CPU_ZERO(&set);
+
+	if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+		for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+			if (CPU_ISSET(cpu, &set)) {
+				cpus.push_back(cpu);
+			}
+		}
+	}
+
+	if (cpus.empty()) {
+		long count = sysconf(_SC_NPROCESSORS_ONLN);
+
+		for (long cpu = 0; cpu < std::max(count, 1L); ++cpu) {
+			cpus.push_back(static_cast<int>(cpu));
+		}
+	}
+
+	return cpus;
+}
+
+/*! initializes the worker group, without starting any thread yet.
+ *
+ * \param count number of workers to create, or 0 for one per CPU available to this process.
+ * \param pinned whether or not to pin each worker's thread onto its own CPU (out of the process' affinity mask).
+ */
+WorkerGroup::WorkerGroup(size_t count, bool pinned) :
+	workers_(),
+	pinned_(pinned),
+	running_(false),
+	nextWorker_(0)
+{
+	std::vector<int> cpus = availableCPUs();
+
+	if (count == 0)
+		count = cpus.size();
+
+	for (size_t i = 0; i < count; ++i) {
+		int cpu = pinned ? cpus[i % cpus.size()] : -1;
+		workers_.emplace_back(new Worker(this, i, cpu));
+	}
+}
+
+WorkerGroup::~WorkerGroup()
+{
+	stop();
+	join();
+}
+
+struct ev_loop* WorkerGroup::loop(size_t index) const
+{
+	return workers_[index]->loop();
+}
+
+/*! clones the given listener into every worker's event loop.
+ *
+ * Must be invoked before start(). The given listener is stopped, and closed if
+ * it is bound with SO_REUSEPORT (as then each clone owns its own listener socket),
+ * thus, it is merely used as a template.
+ *
+ * \retval true the listener has been cloned into every worker.
+ * \retval false at least one clone failed to open, none has been added.
+ */
+bool WorkerGroup::listen(ServerSocket* listener)
+{
+	assert(!running_ && "Cannot add listeners to a running worker group.");
+
+	// all or nothing, so clones are only handed to the workers once all of them opened
+	std::vector<std::unique_ptr<ServerSocket>> clones;
+
+	for (auto& worker: workers_) {
+		std::unique_ptr<ServerSocket> s(listener->clone(worker->loop()));
+
+		if (!s->isOpen())
+			return false;
+
+		s->callback = listener->callback;
+		clones.push_back(std::move(s));
+	}
+
+	for (size_t i = 0; i < workers_.size(); ++i) {
+		workers_[i]->listeners_.push_back(std::move(clones[i]));
+	}
+
+	listener->stop();
+
+	if (auto inet = dynamic_cast<InetServer*>(listener))
+		if (inet->reusePort())
+			inet->close();
+
+	return true;
+}
+
+/*! spawns all worker threads, each running its own event loop.
+ */
+void WorkerGroup::start()
+{
+	if (running_)
+		return;
+
+	running_ = true;
+
+	for (auto& worker: workers_) {
+		worker->start();
+	}
+}
+
+/*! asynchronously breaks all worker loops.
+ *
+ * \see join()
+ */
+void WorkerGroup::stop()
+{
+	if (!running_)
+		return;
+
+	for (auto& worker: workers_) {
+		worker->stop();
+	}
+}
+
+/*! waits for all worker threads to finish.
+ */
+void WorkerGroup::join()
+{
+	for (auto& worker: workers_) {
+		worker->join();
+	}
+
+	running_ = false;
+}
+
+/*! posts a task onto the next worker (round robin).
+ */
+void WorkerGroup::post(std::function<void()> task)
+{
+	size_t index = nextWorker_.fetch_add(1, std::memory_order_relaxed) % workers_.size();
+	workers_[index]->post(std::move(task));
+}
+
+/*! posts a task onto the given worker.
+ */
+void WorkerGroup::post(size_t index, std::function<void()> task)
+{
+	workers_[index]->post(std::move(task));
+}
+// }}}
+// {{{ WorkerGroup::Worker
+WorkerGroup::Worker::Worker(WorkerGroup* group, size_t id, int cpu) :
+	group_(group),
+	id_(id),
+	cpu_(cpu),
+	loop_(ev_loop_new(EVFLAG_AUTO)),
+	executor_(new LoopExecutor(loop_)),
+	listeners_(),
+	thread_()
+{
+}
+
+WorkerGroup::Worker::~Worker()
+{
+	listeners_.clear();
+	executor_.reset();
+	ev_loop_destroy(loop_);
+}
+
+/*! enqueues a task to be invoked from within this worker's thread.
+ *
+ * This function is thread-safe.
+ */
+void WorkerGroup::Worker::post(std::function<void()> task)
+{
+	executor_->post(std::move(task));
+}
+
+void WorkerGroup::Worker::start()
+{
+	thread_ = std::thread(&Worker::run, this);
+}
+
+void WorkerGroup::Worker::stop()
+{
+	post([this]() { ev_break(loop_, EVBREAK_ALL); });
+}
+
+void WorkerGroup::Worker::join()
+{
+	if (thread_.joinable()) {
+		thread_.join();
+	}
+}
+
+void WorkerGroup::Worker::run()
+{
+	if (cpu_ >= 0) {
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(cpu_, &set);
+
+		if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) {
+			TRACE("worker %zu: could not pin to CPU %d", id_, cpu_);
+		}
+	}
+
+	executor_->attach();
+
+	TRACE("worker %zu: running", id_);
+	ev_run(loop_, 0);
+	TRACE("worker %zu: stopped", id_);
+}
+// }}}
+
+} // namespace xio
@@ -0,0 +1,108 @@
+/* <xio/ZstdFilter.cpp>
+ *
+ * This file is part of the x0 web server project and is released under LGPL-3.
+ * http://www.xzero.io/
+ *
+ * (c) 2009-2013 Christian Parpart <trapni@gmail.com>
+ */
+
+#include <xio/ZstdFilter.h>
+#include <xio/sysconfig.h>
+#include <algorithm>
+#include <errno.h>
+
+#if defined(HAVE_ZSTD_H) && defined(HAVE_LIBZSTD)
+#	include <zstd.h>
+#endif
+
+namespace xio {
+
+#if defined(HAVE_ZSTD_H) && defined(HAVE_LIBZSTD) // {{{ zstd implementation
+ZstdFilter::ZstdFilter(int level) :
+	level_(level),
+	ctx_(ZSTD_createCCtx())
+{
+	if (ctx_ && ZSTD_isError(ZSTD_CCtx_setParameter(ctx_, ZSTD_c_compressionLevel, level))) {
+		ZSTD_freeCCtx(ctx_);
+		ctx_ = nullptr;
+	}
+}
+
+ZstdFilter::~ZstdFilter()
+{
+	ZSTD_freeCCtx(ctx_);
+}
+
+bool ZstdFilter::isSupported()
+{
+	return true;
+}
+
+ssize_t ZstdFilter::process(const BufferRef& input, Buffer& output)
+{
+	return compress(input, output, ZSTD_e_continue);
+}
+
+ssize_t ZstdFilter::flush(Buffer& output)
+{
+	return compress(BufferRef(), output, ZSTD_e_flush);
+}
+
+/*! ends the current frame, the context is then ready for the next one.
+ */
+ssize_t ZstdFilter::finish(Buffer& output)
+{
+	return compress(BufferRef(), output, ZSTD_e_end);
+}
+
+/*! feeds \p input to the compressor and appends whatever it emits to \p output.
+ *
+ * \param mode one of ZSTD_e_continue, ZSTD_e_flush, or ZSTD_e_end.
+ * \return number of bytes appended, or -1 on failure.
+ */
+ssize_t ZstdFilter::compress(const BufferRef& input, Buffer& output, int mode)
+{
+	if (!ctx_) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	const size_t before = output.size();
+	ZSTD_inBuffer in = { input.data(), input.size(), 0 };
+
+	for (;;) {
+		if (output.capacity() - output.size() < 256
+				&& !output.reserve(output.size() + std::max(ZSTD_CStreamOutSize(), (in.size - in.pos) / 2))) {
+			errno = ENOMEM;
+			return -1;
+		}
+
+		ZSTD_outBuffer out = { output.data() + output.size(), output.capacity() - output.size(), 0 };
+
+		size_t remaining = ZSTD_compressStream2(ctx_, &out, &in, static_cast<ZSTD_EndDirective>(mode));
+
+		output.resize(output.size() + out.pos);
+
+		if (ZSTD_isError(remaining)) {
+			errno = EINVAL;
+			return -1;
+		}
+
+		// flushing is complete once nothing remains, otherwise once all input is taken
+		if (mode != ZSTD_e_continue ? remaining == 0 : in.pos == in.size)
+			break;
+	}
+
+	return output.size() - before;
+}
+#else // }}} {{{ stubs for builds without zstd
+ZstdFilter::ZstdFilter(int level) : level_(level), ctx_(nullptr) {}
+ZstdFilter::~ZstdFilter() {}
+bool ZstdFilter::isSupported() { return false; }
+ssize_t ZstdFilter::process(const BufferRef&, Buffer&) { errno = ENOSYS; return -1; }
+ssize_t ZstdFilter::flush(Buffer&) { errno = ENOSYS; return -1; }
+ssize_t ZstdFilter::finish(Buffer&) { errno = ENOSYS; return -1; }
+ssize_t ZstdFilter::compress(const BufferRef&, Buffer&, int) { errno = ENOSYS; return -1; }
+#endif // }}}
+
+} // namespace xio
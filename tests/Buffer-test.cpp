@@ -8,6 +8,10 @@
 
 #include <gtest/gtest.h>
 #include <xio/Buffer.h>
+#include <xio/SharedBuffer.h>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
 
 using namespace xio;
 
@@ -31,6 +35,42 @@ TEST(BufferBase, find1)
 	ASSERT_EQ(BufferRef::npos, b.find("not-found"));
 }
 
+TEST(BufferBase, find2)
+{
+	// long enough to run through the vectorized kernels
+	Buffer b;
+	for (int i = 0; i < 100; ++i)
+		b.push_back("Header: value\r\n");
+	b.push_back("\r\nbody\r\n\r\n");
+
+	ASSERT_EQ(1498, b.find("\r\n\r\n"));
+	ASSERT_EQ(1498, b.find(BufferRef("\r\n\r\n")));
+	ASSERT_EQ(1506, b.find("\r\n\r\n", 1499));
+	ASSERT_EQ(BufferRef::npos, b.find("\r\n\r\n", 1507));
+	ASSERT_EQ(BufferRef::npos, b.find("not-found"));
+	ASSERT_EQ(BufferRef::npos, b.find("x", b.size()));
+}
+
+TEST(BufferBase, rfind1)
+{
+	BufferRef b("fnorded,by,nature,by");
+	ASSERT_EQ(18, b.rfind("by"));
+	ASSERT_EQ(18, b.rfind(BufferRef("by")));
+	ASSERT_EQ(0, b.rfind("fnord"));
+	ASSERT_EQ(BufferRef::npos, b.rfind("not-found"));
+}
+
+TEST(BufferBase, rfind2)
+{
+	Buffer b;
+	b.push_back("\r\n\r\n");
+	for (int i = 0; i < 100; ++i)
+		b.push_back("Header: value\r\n");
+
+	ASSERT_EQ(0, b.rfind("\r\n\r\n"));
+	ASSERT_EQ(1497, b.rfind("value"));
+}
+
 TEST(BufferBase, split1)
 {
 	Buffer b("fnorded,by,nature");
@@ -154,3 +194,349 @@ TEST(Buffer, slice)
 	ASSERT_EQ("b", b.slice(4, 1));
 }
 // }}}
+// {{{ BufferAllocator
+TEST(BufferAllocator, geometricGrowth)
+{
+	Buffer b(BufferAllocator::slab());
+	b.push_back("12345678");
+	ASSERT_EQ(8, b.capacity());
+
+	b.push_back("9");
+	ASSERT_EQ(32, b.capacity());
+
+	for (int i = 0; i < 1000; ++i)
+		b.push_back("0123456789");
+
+	ASSERT_EQ(10009, b.size());
+	ASSERT_EQ(16384, b.capacity());
+	ASSERT_TRUE(b.begins("123456789"));
+	ASSERT_TRUE(b.ends("0123456789"));
+}
+
+TEST(BufferAllocator, linearGrowth)
+{
+	Buffer b(BufferAllocator::system());
+	b.push_back("foo");
+	ASSERT_EQ(3, b.capacity());
+
+	b.push_back("bar");
+	ASSERT_EQ(Buffer::CHUNK_SIZE, b.capacity());
+	ASSERT_EQ("foobar", b);
+}
+
+TEST(BufferAllocator, swap)
+{
+	Buffer a(BufferAllocator::system());
+	Buffer b(BufferAllocator::slab());
+	a.push_back("foo");
+	b.push_back("bar");
+
+	a.swap(b);
+	ASSERT_EQ("bar", a);
+	ASSERT_EQ("foo", b);
+	ASSERT_EQ(BufferAllocator::slab(), a.allocator());
+	ASSERT_EQ(BufferAllocator::system(), b.allocator());
+}
+
+TEST(BufferAllocator, move)
+{
+	Buffer a(BufferAllocator::system());
+	a.push_back("foo");
+
+	Buffer b(std::move(a));
+	ASSERT_EQ("foo", b);
+	ASSERT_EQ(BufferAllocator::system(), b.allocator());
+	ASSERT_TRUE(a.empty());
+	ASSERT_EQ(0, a.capacity());
+}
+// }}}
+// {{{ InlineBuffer
+TEST(InlineBuffer, inlineStorage)
+{
+	InlineBuffer<32> b;
+	ASSERT_TRUE(b.empty());
+
+	b.push_back("Hello, ");
+	b.push_back(42);
+	ASSERT_EQ("Hello, 42", b);
+	ASSERT_TRUE(b.isInline());
+	ASSERT_EQ(32, b.capacity());
+}
+
+TEST(InlineBuffer, spill)
+{
+	InlineBuffer<8> b;
+	b.push_back("12345678");
+	ASSERT_TRUE(b.isInline());
+
+	b.push_back("9abcdef");
+	ASSERT_FALSE(b.isInline());
+	ASSERT_EQ("123456789abcdef", b);
+
+	// moving spilled storage out transfers it to the backend allocator
+	const char* data = b.data();
+	Buffer c(std::move(b));
+	ASSERT_EQ("123456789abcdef", c);
+	ASSERT_EQ(data, c.data());
+	ASSERT_EQ(BufferAllocator::defaultAllocator(), c.allocator());
+	ASSERT_TRUE(b.empty());
+}
+
+TEST(InlineBuffer, move)
+{
+	InlineBuffer<16> a;
+	a.push_back("foo");
+
+	// inline storage cannot leave its buffer, and is copied instead
+	Buffer b(std::move(a));
+	ASSERT_EQ("foo", b);
+	ASSERT_NE(a.data(), b.data());
+	ASSERT_TRUE(a.empty());
+
+	InlineBuffer<16> c;
+	c.push_back("bar");
+	b.swap(c);
+	ASSERT_EQ("bar", b);
+	ASSERT_EQ("foo", c);
+
+	Buffer d;
+	d = std::move(c);
+	ASSERT_EQ("foo", d);
+
+	InlineBuffer<16> e(BufferRef("shared"));
+	SharedBuffer s(std::move(e));
+	ASSERT_EQ("shared", s);
+	ASSERT_TRUE(e.empty());
+}
+// }}}
+// {{{ number formatting / parsing
+TEST(Buffer, formatInteger)
+{
+	Buffer b;
+	b << 0 << ' ' << -1 << ' ' << 42u << ' ' << 1234567890123LL;
+	ASSERT_EQ("0 -1 42 1234567890123", b);
+
+	b.clear();
+	b << LLONG_MIN << ' ' << ULLONG_MAX;
+	ASSERT_EQ("-9223372036854775808 18446744073709551615", b);
+
+	// compare against snprintf around every power of ten
+	unsigned long long pow = 1;
+	for (int i = 0; i < 19; ++i, pow *= 10) {
+		for (unsigned long long v: { pow - 1, pow, pow + 1 }) {
+			char expected[32];
+			snprintf(expected, sizeof(expected), "%llu", v);
+			b.clear();
+			b.push_back(v);
+			ASSERT_EQ(expected, b.str());
+		}
+	}
+}
+
+TEST(Buffer, formatDouble)
+{
+	Buffer b;
+	b << 1.0 << ' ' << -0.5 << ' ' << 0.1 << ' ' << (0.1 + 0.2) << ' ' << 1e100;
+	ASSERT_EQ("1 -0.5 0.1 0.30000000000000004 1e+100", b);
+
+	for (double v: { 3.141592653589793, 2.0 / 3.0, 1e-300, 123456.789, 5e-324 }) {
+		b.clear();
+		b.push_back(v);
+		double parsed = 0;
+		ASSERT_TRUE(b.toDouble(&parsed));
+		ASSERT_EQ(v, parsed);
+	}
+
+	char buf[32];
+	ASSERT_EQ("5e-324", std::string(buf, formatDouble(buf, 5e-324)));
+	ASSERT_EQ("1.7976931348623157e+308", std::string(buf, formatDouble(buf, 1.7976931348623157e308)));
+	ASSERT_EQ("0.0001", std::string(buf, formatDouble(buf, 1e-4)));
+	ASSERT_EQ("1e-05", std::string(buf, formatDouble(buf, 1e-5)));
+	ASSERT_EQ("-123.456", std::string(buf, formatDouble(buf, -123.456)));
+	ASSERT_EQ("9007199254740994", std::string(buf, formatDouble(buf, 9007199254740994.0)));
+	ASSERT_EQ("1e+21", std::string(buf, formatDouble(buf, 1e21)));
+}
+
+/* the number of significant digits of the shortest "%.*e" representation that round-trips.
+ */
+static int shortestDigits(double v)
+{
+	char buf[64];
+	for (int precision = 0; precision < 17; ++precision) {
+		snprintf(buf, sizeof(buf), "%.*e", precision, v);
+		if (strtod(buf, nullptr) == v)
+			return precision + 1;
+	}
+	return 17;
+}
+
+static int countSignificant(const std::string& s)
+{
+	size_t end = s.find('e');
+	std::string mantissa = s.substr(0, end);
+	int n = 0;
+	bool leading = true;
+	for (char ch: mantissa) {
+		if (ch < '0' || ch > '9')
+			continue;
+		if (ch == '0' && leading)
+			continue;
+		leading = false;
+		++n;
+	}
+	// trailing zeros of integral values are no significant digits
+	if (end == std::string::npos && mantissa.find('.') == std::string::npos)
+		for (size_t i = mantissa.size(); i > 0 && mantissa[i - 1] == '0'; --i)
+			--n;
+	return n;
+}
+
+TEST(Buffer, formatDoubleShortest)
+{
+	uint64_t state = 0x9E3779B97F4A7C15ULL;
+	char buf[32];
+
+	for (int i = 0; i < 200000; ++i) {
+		// xorshift64*, yielding random bit patterns across the whole exponent range
+		state ^= state >> 12;
+		state ^= state << 25;
+		state ^= state >> 27;
+		uint64_t bits = state * 2685821657736338717ULL;
+
+		double v;
+		memcpy(&v, &bits, sizeof(v));
+		if (std::isnan(v) || std::isinf(v))
+			continue;
+
+		std::string s(buf, formatDouble(buf, v));
+		ASSERT_EQ(v, strtod(s.c_str(), nullptr));
+		ASSERT_EQ(shortestDigits(v), countSignificant(s));
+
+		double parsed;
+		ASSERT_TRUE(BufferRef(s.data(), s.size()).toDouble(&parsed));
+		ASSERT_EQ(v, parsed);
+	}
+}
+
+TEST(BufferBase, toInteger)
+{
+	long long v;
+	ASSERT_TRUE(BufferRef("12345678901234567").toInteger(&v));
+	ASSERT_EQ(12345678901234567LL, v);
+
+	ASSERT_TRUE(BufferRef("-9223372036854775808").toInteger(&v));
+	ASSERT_EQ(LLONG_MIN, v);
+
+	ASSERT_FALSE(BufferRef("9223372036854775808").toInteger(&v));
+	ASSERT_EQ(ERANGE, errno);
+
+	ASSERT_FALSE(BufferRef("12345678x").toInteger(&v));
+	ASSERT_EQ(EINVAL, errno);
+
+	ASSERT_FALSE(BufferRef("-").toInteger(&v));
+	ASSERT_FALSE(BufferRef("").toInteger(&v));
+
+	unsigned long long u;
+	ASSERT_TRUE(BufferRef("18446744073709551615").toUnsigned(&u));
+	ASSERT_EQ(ULLONG_MAX, u);
+	ASSERT_FALSE(BufferRef("18446744073709551616").toUnsigned(&u));
+	ASSERT_EQ(ERANGE, errno);
+	ASSERT_TRUE(BufferRef("000000000000000000000000000000001").toUnsigned(&u));
+	ASSERT_EQ(1, u);
+
+	double d;
+	ASSERT_FALSE(BufferRef("1e999").toDouble(&d));
+	ASSERT_EQ(ERANGE, errno);
+
+	ASSERT_TRUE(BufferRef("1.5").toDouble(&d));
+	ASSERT_EQ(1.5, d);
+	ASSERT_TRUE(BufferRef("-.25e+2").toDouble(&d));
+	ASSERT_EQ(-25, d);
+	ASSERT_TRUE(BufferRef("2.2250738585072011e-308").toDouble(&d));
+	ASSERT_EQ(2.2250738585072011e-308, d);
+	ASSERT_TRUE(BufferRef("1e-400").toDouble(&d));
+	ASSERT_EQ(0, d);
+
+	for (const char* invalid: { " 1.5", "1.5 ", "0x10", "nan", "inf", "-inf", ".", "1e", "1e+", "1.5.", "--1", "" }) {
+		ASSERT_FALSE(BufferRef(invalid, strlen(invalid)).toDouble(&d));
+		ASSERT_EQ(EINVAL, errno);
+	}
+
+	// legacy API parses a prefix and clamps
+	ASSERT_EQ(-42, BufferRef("-42abc").toInt());
+	ASSERT_EQ(INT_MAX, BufferRef("99999999999").toInt());
+	ASSERT_EQ(0xbeef, BufferRef("BeEfz").hex<int>());
+}
+// }}}
+// {{{ ASCII case folding
+TEST(BufferBase, icompare)
+{
+	BufferRef b("Content-Type");
+	ASSERT_TRUE(iequals(b, "content-type"));
+	ASSERT_TRUE(iequals(b, std::string("CONTENT-TYPE")));
+	ASSERT_FALSE(iequals(b, "content-typ"));
+	ASSERT_FALSE(iequals(b, "content_type"));
+
+	ASSERT_TRUE(b.ibegins("CONTENT-"));
+	ASSERT_TRUE(b.ibegins(BufferRef("content")));
+	ASSERT_TRUE(b.ibegins('c'));
+	ASSERT_FALSE(b.ibegins("content-type-x"));
+
+	ASSERT_TRUE(b.iends("-TYPE"));
+	ASSERT_TRUE(b.iends(std::string("type")));
+	ASSERT_TRUE(b.iends('E'));
+	ASSERT_FALSE(b.iends("x-content-type"));
+
+	// letters only, '@' (0x40) vs '`' (0x60) differ in 0x20 as well
+	ASSERT_FALSE(iequals(BufferRef("@[\\]^_"), "`{|}~\x7f"));
+}
+
+TEST(StringUtil, memiequals)
+{
+	// every length around the 8, 16 and 32 byte kernel widths, all byte pairs at every position
+	char a[80];
+	char b[80];
+
+	for (size_t n = 1; n < sizeof(a); n += 7) {
+		for (int c = 0; c < 256; ++c) {
+			for (int d = 0; d < 256; d += 3) {
+				memset(a, 'x', n);
+				memset(b, 'X', n);
+				size_t at = (c + d) % n;
+				a[at] = static_cast<char>(c);
+				b[at] = static_cast<char>(d);
+
+				bool expected = c == d || (isalpha(c) && c < 128 && (c | 0x20) == (d | 0x20));
+				ASSERT_EQ(expected, memiequals(a, b, n));
+			}
+		}
+	}
+}
+
+TEST(StringUtil, memtoupper)
+{
+	char src[300];
+	char upper[300];
+	char lower[300];
+
+	for (size_t i = 0; i < sizeof(src); ++i)
+		src[i] = static_cast<char>(i);
+
+	for (size_t offset: { 0, 1, 7, 13 }) {
+		size_t n = sizeof(src) - offset;
+		memtoupper(upper, src + offset, n);
+		memtolower(lower, src + offset, n);
+
+		for (size_t i = 0; i < n; ++i) {
+			unsigned char c = src[offset + i];
+			ASSERT_EQ(c < 128 ? toupper(c) : c, static_cast<unsigned char>(upper[i]));
+			ASSERT_EQ(c < 128 ? tolower(c) : c, static_cast<unsigned char>(lower[i]));
+		}
+	}
+
+	// in-place
+	char text[] = "Hello, World! 0123456789 The Quick Brown Fox";
+	memtolower(text, text, sizeof(text) - 1);
+	ASSERT_STREQ("hello, world! 0123456789 the quick brown fox", text);
+}
+// }}}
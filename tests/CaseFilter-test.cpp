@@ -0,0 +1,36 @@
+#include <gtest/gtest.h>
+#include <xio/CaseFilter.h>
+#include <xio/FilterStream.h>
+#include <xio/BufferStream.h>
+#include <memory>
+
+using namespace xio;
+
+TEST(CaseFilter, process)
+{
+	UpperCaseFilter upper;
+	LowerCaseFilter lower;
+	Buffer output;
+
+	ASSERT_EQ(13, upper.process(BufferRef("Hello, World!"), output));
+	ASSERT_EQ("HELLO, WORLD!", output);
+
+	ASSERT_EQ(4, lower.process(BufferRef(" ABC"), output));
+	ASSERT_EQ("HELLO, WORLD! abc", output);
+}
+
+TEST(CaseFilter, chain)
+{
+	static const char text[] = "The Quick Brown Fox Jumps Over The Lazy Dog";
+	BufferStream* source = new BufferStream();
+	source->write(text, sizeof(text) - 1);
+
+	FilterStream stream(source, std::unique_ptr<Filter>(new LowerCaseFilter()));
+	stream.filters.push_back(std::unique_ptr<Filter>(new UpperCaseFilter()));
+
+	Buffer output;
+	while (stream.read(output, 16) > 0)
+		;
+
+	ASSERT_EQ("THE QUICK BROWN FOX JUMPS OVER THE LAZY DOG", output);
+}
@@ -0,0 +1,99 @@
+#include <gtest/gtest.h>
+#include <xio/ChunkedDecoder.h>
+#include <xio/FilterStream.h>
+#include <xio/BufferStream.h>
+#include <cstring>
+#include <memory>
+
+using namespace xio;
+
+static const char body[] =
+	"5;name=value\r\n"
+	"hello\r\n"
+	"A \r\n"
+	", world!\r\n\r\n"
+	"0\r\n"
+	"Expires: never\r\n"
+	"\r\n"
+	"GET / HTTP/1.1\r\n";
+
+TEST(ChunkedDecoder, decode)
+{
+	ChunkedDecoder decoder;
+	Buffer output;
+
+	ASSERT_EQ(15, decoder.process(BufferRef(body), output));
+	ASSERT_EQ("hello, world!\r\n", output);
+	ASSERT_TRUE(decoder.isFinished());
+	ASSERT_EQ(16, decoder.unconsumed());
+}
+
+TEST(ChunkedDecoder, byteByByte)
+{
+	ChunkedDecoder decoder;
+	Buffer output;
+
+	for (size_t i = 0; i < sizeof(body) - 1 && !decoder.isFinished(); ++i)
+		ASSERT_NE(-1, decoder.process(BufferRef(body + i, 1), output));
+
+	ASSERT_EQ("hello, world!\r\n", output);
+	ASSERT_TRUE(decoder.isFinished());
+}
+
+TEST(ChunkedDecoder, filterStream)
+{
+	BufferStream* source = new BufferStream();
+	source->write("3\nfoo\n3\nbar\n0\n\n", 15);
+
+	FilterStream stream(source, std::unique_ptr<Filter>(new ChunkedDecoder()));
+
+	Buffer output;
+	while (stream.read(output, 2) > 0)
+		;
+
+	ASSERT_EQ("foobar", output);
+}
+
+TEST(ChunkedDecoder, extensions)
+{
+	const char* inputs[] = {
+		"5;a\r\nhello\r\n0\r\n\r\n",
+		"5 ; a = b ;c\r\nhello\r\n0\r\n\r\n",
+		"5;a=\"quoted ;=\\\" value\";b=1\r\nhello\r\n0\r\n\r\n",
+		"5\t;a=b\t\nhello\n0\n\n",
+	};
+
+	for (const char* input: inputs) {
+		ChunkedDecoder decoder;
+		Buffer output;
+		ASSERT_EQ(5, decoder.process(BufferRef(input, strlen(input)), output));
+		ASSERT_EQ("hello", output);
+		ASSERT_TRUE(decoder.isFinished());
+	}
+}
+
+TEST(ChunkedDecoder, malformed)
+{
+	const char* inputs[] = {
+		"\r\n",                   // missing size
+		"x\r\n",                  // invalid size
+		"5x\r\nhello\r\n",        // junk after size
+		"3\r\nfooX",              // missing CRLF after data
+		"10000000000000000\r\n",  // size overflow
+		"0\r\n\rX",               // CR without LF
+		"5 garbage\r\nhello\r\n", // junk after size, separated by whitespace
+		"5;\r\nhello\r\n",        // extension without name
+		"5;a=\r\nhello\r\n",      // extension without value
+		"5;a=b c\r\nhello\r\n",   // junk after extension
+		"5;a=\"b\x01\"\r\n",      // control character in quoted value
+		"5;a(b)\r\nhello\r\n",    // no token
+		"5\rX",                   // CR without LF
+	};
+
+	for (const char* input: inputs) {
+		ChunkedDecoder decoder;
+		Buffer output;
+		ASSERT_EQ(-1, decoder.process(BufferRef(input, strlen(input)), output));
+		ASSERT_EQ(EBADMSG, errno);
+	}
+}
@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+#include <xio/ChunkedEncoder.h>
+#include <xio/ChunkedDecoder.h>
+#include <xio/ChunkedStream.h>
+#include <xio/FilterStream.h>
+#include <xio/BufferStream.h>
+#include <xio/Pipe.h>
+#include <memory>
+
+using namespace xio;
+
+static Buffer drain(Stream& stream)
+{
+	Buffer result;
+	while (stream.read(result, 1024) > 0)
+		;
+	return result;
+}
+
+TEST(ChunkedEncoder, process)
+{
+	ChunkedEncoder encoder;
+	Buffer output;
+
+	ASSERT_EQ(0, encoder.process(BufferRef(), output));
+	ASSERT_EQ(8, encoder.process(BufferRef("foo"), output));
+
+	Buffer payload;
+	payload.push_back(std::string(300, 'x'));
+	ASSERT_EQ(307, encoder.process(payload.ref(), output));
+
+	ASSERT_FALSE(encoder.isFinished());
+	ASSERT_EQ(5, encoder.finish(output));
+	ASSERT_TRUE(encoder.isFinished());
+
+	ASSERT_EQ("3\r\nfoo\r\n12c\r\n" + std::string(300, 'x') + "\r\n0\r\n\r\n", output.str());
+}
+
+TEST(ChunkedEncoder, filterStream)
+{
+	BufferStream* sink = new BufferStream();
+	FilterStream stream(sink, std::unique_ptr<Filter>(new ChunkedEncoder()));
+
+	ASSERT_EQ(5, stream.write("hello", 5));
+	ASSERT_EQ(6, stream.write(", world", 6));
+	ASSERT_TRUE(stream.finish());
+
+	ASSERT_EQ("5\r\nhello\r\n6\r\n, worl\r\n0\r\n\r\n", drain(*sink));
+}
+
+TEST(ChunkedEncoder, pipe)
+{
+	Pipe payload;
+	ChunkedStream output;
+	ChunkedEncoder encoder;
+
+	ASSERT_EQ(5, encoder.write(&output, "head:", 5));
+
+	ASSERT_EQ(16, payload.write("spliced payload!", 16));
+	ASSERT_EQ(16, encoder.write(&output, &payload, 1024));
+	ASSERT_EQ(0, payload.size());
+
+	ASSERT_EQ(0, encoder.write(&output, &payload, 1024));
+	ASSERT_TRUE(encoder.finish(&output));
+
+	ASSERT_EQ("5\r\nhead:\r\n10\r\nspliced payload!\r\n0\r\n\r\n", drain(output));
+}
+
+TEST(ChunkedEncoder, pipePartial)
+{
+	Pipe payload;
+	ChunkedStream output;
+	ChunkedEncoder encoder;
+
+	ASSERT_EQ(16, payload.write("spliced payload!", 16));
+	ASSERT_EQ(5, encoder.write(&output, &payload, 5));
+	ASSERT_EQ(11, payload.size());
+
+	ASSERT_EQ(11, encoder.write(&output, &payload, 1024));
+	ASSERT_EQ(0, payload.size());
+	ASSERT_TRUE(encoder.finish(&output));
+
+	ASSERT_EQ("5\r\nsplic\r\nb\r\ned payload!\r\n0\r\n\r\n", drain(output));
+}
+
+TEST(ChunkedEncoder, roundTrip)
+{
+	ChunkedEncoder encoder;
+	Buffer encoded;
+
+	for (size_t n = 1; n < 40; n += 3)
+		encoder.process(BufferRef(std::string(n, 'a' + n % 26).c_str(), n), encoded);
+	encoder.finish(encoded);
+
+	ChunkedDecoder decoder;
+	Buffer decoded;
+	ASSERT_NE(-1, decoder.process(encoded.ref(), decoded));
+	ASSERT_TRUE(decoder.isFinished());
+
+	Buffer expected;
+	for (size_t n = 1; n < 40; n += 3)
+		expected.push_back(std::string(n, 'a' + n % 26));
+
+	ASSERT_EQ(expected, decoded);
+}
@@ -2,6 +2,8 @@
 #include <xio/Pipe.h>
 #include <xio/ChunkedStream.h>
 #include <xio/BufferStream.h>
+#include <xio/Socket.h>
+#include <sys/socket.h>
 
 using namespace xio;
 
@@ -110,3 +112,128 @@ TEST(ChunkedStream, pipe_copy1)
 	buf[n] = '\0';
 	ASSERT_EQ(buf, std::string("foo"));
 }
+
+TEST(ChunkedStream, socket_writev1)
+{
+	int fds[2];
+	ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+
+	ev::loop_ref loop = ev::default_loop(0);
+	Socket socket(loop, fds[0], AF_UNIX);
+	ChunkedStream stream;
+
+	stream.write("Hello", 5);
+	stream.write(", ", 2);
+	stream.write("World", 5);
+	ASSERT_EQ(12, stream.size());
+
+	ssize_t n = stream.read(&socket, stream.size());
+	ASSERT_EQ(12, n);
+	ASSERT_TRUE(stream.empty());
+
+	char buf[20];
+	n = ::read(fds[1], buf, sizeof(buf));
+	ASSERT_EQ(12, n);
+	ASSERT_EQ("Hello, World", std::string(buf, n));
+
+	::close(fds[1]);
+}
+
+TEST(ChunkedStream, socket_writev_partial)
+{
+	int fds[2];
+	ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+
+	ev::loop_ref loop = ev::default_loop(0);
+	Socket socket(loop, fds[0], AF_UNIX);
+	ChunkedStream stream;
+
+	stream.write("foo", 3);
+	stream.write("bar", 3);
+
+	// stop in the middle of the second chunk
+	ssize_t n = stream.read(&socket, 4);
+	ASSERT_EQ(4, n);
+	ASSERT_EQ(2, stream.size());
+
+	n = stream.read(&socket, stream.size());
+	ASSERT_EQ(2, n);
+	ASSERT_TRUE(stream.empty());
+
+	char buf[10];
+	n = ::read(fds[1], buf, sizeof(buf));
+	ASSERT_EQ(6, n);
+	ASSERT_EQ("foobar", std::string(buf, n));
+
+	::close(fds[1]);
+}
+
+TEST(ChunkedStream, socket_empty_head)
+{
+	int in[2];
+	int out[2];
+	int pfd[2];
+	ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, in));
+	ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, out));
+	ASSERT_EQ(0, ::pipe(pfd));
+
+	ev::loop_ref loop = ev::default_loop(0);
+	Socket source(loop, in[0], AF_UNIX);
+	Socket target(loop, out[0], AF_UNIX);
+	ChunkedStream stream;
+
+	// nothing to read yet, leaving an empty memory chunk behind
+	ASSERT_EQ(-1, stream.write(&source, 100, Stream::COPY));
+	ASSERT_EQ(EAGAIN, errno);
+
+	ASSERT_EQ(5, ::write(pfd[1], "Hello", 5));
+	ASSERT_EQ(5, stream.write(pfd[0], 5));
+
+	// ... and now an empty pipe chunk in the middle
+	ASSERT_EQ(-1, stream.write(&source, 100, Stream::MOVE));
+	ASSERT_EQ(6, stream.write(", Bye!", 6));
+	ASSERT_EQ(11, stream.size());
+
+	ASSERT_EQ(11, stream.read(&target, 100));
+	ASSERT_TRUE(stream.empty());
+
+	char buf[20];
+	ASSERT_EQ(11, ::read(out[1], buf, sizeof(buf)));
+	ASSERT_EQ("Hello, Bye!", std::string(buf, 11));
+
+	::close(in[1]);
+	::close(out[1]);
+	::close(pfd[0]);
+	::close(pfd[1]);
+}
+
+TEST(ChunkedStream, size_mixed)
+{
+	Pipe pipe;
+	ChunkedStream stream;
+
+	ASSERT_EQ(3, stream.write("foo", 3));
+	ASSERT_EQ(3, pipe.write("bar", 3));
+	ASSERT_EQ(3, stream.write(&pipe, 3, Stream::MOVE));
+	ASSERT_EQ(3, stream.write("baz", 3));
+	ASSERT_EQ(9, stream.size());
+
+	// reading through the head chunk directly keeps the size in sync
+	char buf[16];
+	ASSERT_EQ(2, stream.front().read(buf, 2));
+	ASSERT_EQ(7, stream.size());
+
+	// reads span chunk boundaries
+	ASSERT_EQ(7, stream.read(buf, sizeof(buf)));
+	ASSERT_EQ("obarbaz", std::string(buf, 7));
+	ASSERT_TRUE(stream.empty());
+	ASSERT_EQ(0, stream.size());
+
+	// drained chunks are reused
+	for (int i = 0; i < 100; ++i) {
+		ASSERT_EQ(3, stream.write("abc", 3));
+		ASSERT_EQ('a', stream.read());
+		ASSERT_EQ(2, stream.read(buf, sizeof(buf)));
+		ASSERT_EQ(0, stream.size());
+	}
+}
@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+#include <xio/DateTime.h>
+#include <string>
+#include <time.h>
+
+using namespace xio;
+
+static std::string format(std::time_t t)
+{
+	char buf[DateTime::HTTP_DATE_SIZE];
+	return std::string(buf, DateTime::formatHttpDate(buf, t));
+}
+
+TEST(DateTime, formatHttpDate)
+{
+	ASSERT_EQ("Thu, 01 Jan 1970 00:00:00 GMT", format(0));
+	ASSERT_EQ("Sun, 06 Nov 1994 08:49:37 GMT", format(784111777));
+	ASSERT_EQ("Tue, 29 Feb 2000 23:59:59 GMT", format(951868799));
+	ASSERT_EQ("Wed, 31 Dec 1969 23:59:59 GMT", format(-1));
+}
+
+TEST(DateTime, formatHttpDateMatchesStrftime)
+{
+	// walks 1970 - 2100 in odd steps, to hit every weekday, month and leap year
+	for (std::time_t t = 0; t < 4102444800; t += 86400 * 3 + 3607) {
+		struct tm tm;
+		char expected[64];
+		gmtime_r(&t, &tm);
+		strftime(expected, sizeof(expected), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+
+		ASSERT_EQ(std::string(expected), format(t));
+	}
+}
+
+TEST(DateTime, parseHttpDate)
+{
+	std::time_t t = 0;
+	ASSERT_TRUE(DateTime::parseHttpDate("Sun, 06 Nov 1994 08:49:37 GMT", 29, &t));
+	ASSERT_EQ(784111777, t);
+
+	for (t = 0; t < 4102444800; t += 86400 * 5 + 7919) {
+		std::string s = format(t);
+		std::time_t parsed = 0;
+		ASSERT_TRUE(DateTime::parseHttpDate(s.data(), s.size(), &parsed));
+		ASSERT_EQ(t, parsed);
+	}
+
+	ASSERT_EQ(784111777, DateTime(std::string("Sun, 06 Nov 1994 08:49:37 GMT")).unixtime());
+}
+
+TEST(DateTime, parseHttpDateInvalid)
+{
+	std::time_t t = 42;
+	ASSERT_FALSE(DateTime::parseHttpDate("", 0, &t));
+	ASSERT_FALSE(DateTime::parseHttpDate("Sun, 06 Nov 1994 08:49:37 UTC", 29, &t));
+	ASSERT_FALSE(DateTime::parseHttpDate("Sun, 06 Nov 1994 08:49:37 GMT ", 30, &t));
+	ASSERT_FALSE(DateTime::parseHttpDate("Sun, 06 Foo 1994 08:49:37 GMT", 29, &t));
+	ASSERT_FALSE(DateTime::parseHttpDate("Sun, 00 Nov 1994 08:49:37 GMT", 29, &t));
+	ASSERT_FALSE(DateTime::parseHttpDate("Sun, 06 Nov 1994 24:49:37 GMT", 29, &t));
+	ASSERT_FALSE(DateTime::parseHttpDate("Sun, 06 Nov 1994 08:4x:37 GMT", 29, &t));
+	ASSERT_FALSE(DateTime::parseHttpDate("Sunday, 06-Nov-94 08:49:37 GMT", 30, &t));
+	ASSERT_FALSE(DateTime::parseHttpDate("Sun Nov  6 08:49:37 1994     ", 29, &t));
+	ASSERT_EQ(42, t);
+
+	ASSERT_FALSE(DateTime(std::string("garbage")).valid());
+}
+
+TEST(DateTime, httpDateCache)
+{
+	DateTime dt(static_cast<ev::tstamp>(784111777));
+	ASSERT_EQ("Sun, 06 Nov 1994 08:49:37 GMT", dt.httpDate().str());
+
+	// same second: same bytes
+	const char* data = dt.httpDate().data();
+	dt.update(784111777.5);
+	ASSERT_EQ(data, dt.httpDate().data());
+	ASSERT_EQ("Sun, 06 Nov 1994 08:49:37 GMT", dt.httpDate().str());
+
+	// next second, same day
+	dt.update(784111778);
+	ASSERT_EQ("Sun, 06 Nov 1994 08:49:38 GMT", dt.httpDate().str());
+
+	// next day
+	dt.update(784111778 + 86400 - 30);
+	ASSERT_EQ("Mon, 07 Nov 1994 08:49:08 GMT", dt.httpDate().str());
+
+	// back in time, crossing the day boundary
+	dt.update(784080000 - 1);
+	ASSERT_EQ("Sat, 05 Nov 1994 23:59:59 GMT", dt.httpDate().str());
+}
@@ -0,0 +1,139 @@
+#include <gtest/gtest.h>
+#include <xio/DeflateFilter.h>
+#include <xio/FilterStream.h>
+#include <xio/BufferStream.h>
+#include <algorithm>
+#include <memory>
+
+using namespace xio;
+
+static Buffer text(size_t lines)
+{
+	Buffer result;
+	for (size_t i = 0; i < lines; ++i) {
+		result.push_back("line ");
+		result.push_back(i);
+		result.push_back(": the quick brown fox jumps over the lazy dog\n");
+	}
+	return result;
+}
+
+static Buffer inflate(const BufferRef& input)
+{
+	InflateFilter filter;
+	Buffer result;
+	EXPECT_NE(-1, filter.process(input, result));
+	return result;
+}
+
+TEST(DeflateFilter, roundTrip)
+{
+	if (!DeflateFilter::isSupported())
+		return;
+
+	Buffer input = text(1000);
+	DeflateFilter filter(9);
+	Buffer output;
+
+	for (size_t i = 0; i < input.size(); i += 1000)
+		ASSERT_NE(-1, filter.process(input.ref(i, std::min(input.size() - i, static_cast<size_t>(1000))), output));
+
+	ASSERT_LT(0, filter.finish(output));
+	ASSERT_LT(output.size(), input.size() / 10);
+	ASSERT_EQ(input, inflate(output.ref()));
+}
+
+TEST(DeflateFilter, flush)
+{
+	if (!DeflateFilter::isSupported())
+		return;
+
+	DeflateFilter filter;
+	Buffer output;
+
+	ASSERT_NE(-1, filter.process(BufferRef("hello"), output));
+	ASSERT_NE("hello", inflate(output.ref()));
+
+	ASSERT_LT(0, filter.flush(output));
+	ASSERT_EQ("hello", inflate(output.ref()));
+
+	ASSERT_NE(-1, filter.process(BufferRef(", world"), output));
+	ASSERT_LT(0, filter.finish(output));
+	ASSERT_EQ("hello, world", inflate(output.ref()));
+}
+
+TEST(DeflateFilter, reuse)
+{
+	if (!DeflateFilter::isSupported())
+		return;
+
+	DeflateFilter filter(1);
+	Buffer first;
+	Buffer second;
+
+	filter.process(BufferRef("first"), first);
+	filter.finish(first);
+
+	filter.process(BufferRef("second"), second);
+	filter.finish(second);
+
+	ASSERT_EQ("first", inflate(first.ref()));
+	ASSERT_EQ("second", inflate(second.ref()));
+}
+
+TEST(GzipFilter, filterStream)
+{
+	if (!DeflateFilter::isSupported())
+		return;
+
+	Buffer input = text(500);
+	BufferStream* source = new BufferStream();
+	source->write(input.data(), input.size());
+
+	FilterStream stream(source, std::unique_ptr<Filter>(new GzipFilter()));
+
+	Buffer output;
+	while (stream.read(output, 100) > 0)
+		;
+
+	ASSERT_TRUE(stream.finished());
+	ASSERT_EQ('\x1f', output[0]);
+	ASSERT_EQ('\x8b', output[1]);
+	ASSERT_EQ(input, inflate(output.ref()));
+}
+
+TEST(InflateFilter, corrupt)
+{
+	if (!DeflateFilter::isSupported())
+		return;
+
+	InflateFilter filter;
+	Buffer output;
+
+	ASSERT_EQ(-1, filter.process(BufferRef("not compressed at all"), output));
+	ASSERT_EQ(EINVAL, errno);
+}
+
+TEST(InflateFilter, truncated)
+{
+	if (!DeflateFilter::isSupported())
+		return;
+
+	GzipFilter gzip;
+	Buffer input(text(100));
+	Buffer compressed;
+	ASSERT_NE(-1, gzip.process(input.ref(), compressed));
+	ASSERT_LT(0, gzip.finish(compressed));
+
+	InflateFilter filter;
+	Buffer output;
+	ASSERT_NE(-1, filter.process(compressed.ref(0, compressed.size() - 4), output));
+	ASSERT_EQ(-1, filter.finish(output));
+	ASSERT_EQ(EINVAL, errno);
+
+	// the filter has been reset, ready for the next stream
+	output.clear();
+	ASSERT_NE(-1, filter.process(compressed.ref(), output));
+	ASSERT_EQ(0, filter.finish(output));
+	ASSERT_EQ(input, output);
+}
@@ -0,0 +1,160 @@
+#include <gtest/gtest.h>
+#include <xio/FileMgr.h>
+#include <xio/Buffer.h>
+#include <string>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <utime.h>
+#include <ev++.h>
+
+using namespace xio;
+
+static std::string createTempFile(const char* content)
+{
+	char path[] = "/tmp/xio-FileMgr-test.XXXXXX";
+	int fd = mkstemp(path);
+	::write(fd, content, strlen(content));
+	::close(fd);
+	return path;
+}
+
+TEST(FileMgr, query)
+{
+	ev::dynamic_loop loop;
+	FileMgr::Config config;
+	FileMgr mgr(loop, &config);
+
+	std::string path = createTempFile("hello");
+
+	FilePtr a = mgr.query(path);
+	ASSERT_TRUE(a->exists());
+	ASSERT_EQ(5, a->size());
+	ASSERT_TRUE(a == mgr.query(path));
+	ASSERT_EQ(1, mgr.size());
+
+	// fd caching is disabled by default
+	auto fs = a->open(O_RDONLY);
+	ASSERT_FALSE(a->isCached());
+	ASSERT_TRUE(fs->isOwned());
+
+	FilePtr missing = mgr.query(path + ".missing");
+	ASSERT_FALSE(missing->exists());
+	ASSERT_EQ("", missing->lastModified());
+
+	unlink(path.c_str());
+}
+
+TEST(FileMgr, lastModified)
+{
+	ev::dynamic_loop loop;
+	FileMgr::Config config;
+	FileMgr mgr(loop, &config);
+
+	std::string path = createTempFile("hello");
+	struct utimbuf times = { 784111777, 784111777 };
+	ASSERT_EQ(0, utime(path.c_str(), &times));
+
+	FilePtr file = mgr.query(path);
+	ASSERT_EQ("Sun, 06 Nov 1994 08:49:37 GMT", file->lastModified());
+
+	unlink(path.c_str());
+}
+
+TEST(FileMgr, fdCache)
+{
+	ev::dynamic_loop loop;
+	FileMgr::Config config;
+	config.maxOpenFiles = 2;
+	FileMgr mgr(loop, &config);
+
+	std::string paths[3] = {
+		createTempFile("one"),
+		createTempFile("two"),
+		createTempFile("three")
+	};
+
+	FilePtr a = mgr.query(paths[0]);
+
+	auto fs = a->open(O_RDONLY);
+	ASSERT_TRUE(a->isCached());
+	ASSERT_TRUE(fs->isOwned());
+
+	Buffer buf;
+	ASSERT_EQ(3, fs->read(buf, 100));
+	ASSERT_TRUE(buf == "one");
+
+	// small files get mapped, too
+	ASSERT_TRUE(a->isMapped());
+	ASSERT_EQ(0, memcmp(a->data(), "one", 3));
+
+	// re-opening reuses the cached descriptor
+	ASSERT_TRUE(a->open(O_RDONLY)->handle() != fs->handle());
+	ASSERT_EQ(1, mgr.openFiles());
+
+	// least recently used entry is closed first, once unreferenced
+	a.reset();
+	mgr.query(paths[1])->open(O_RDONLY);
+	mgr.query(paths[2])->open(O_RDONLY);
+	ASSERT_EQ(2, mgr.openFiles());
+	ASSERT_FALSE(mgr.query(paths[0])->isCached());
+	ASSERT_TRUE(mgr.query(paths[2])->isCached());
+
+	for (auto& path: paths)
+		unlink(path.c_str());
+}
+
+TEST(FileMgr, invalidate)
+{
+	ev::dynamic_loop loop;
+	FileMgr::Config config;
+	config.maxOpenFiles = 8;
+	FileMgr mgr(loop, &config);
+
+	std::string path = createTempFile("before");
+
+	FilePtr a = mgr.query(path);
+	ASSERT_TRUE(a->data() != nullptr);
+	ASSERT_EQ(1, mgr.openFiles());
+
+	int fd = ::open(path.c_str(), O_WRONLY | O_APPEND);
+	::write(fd, "+after", 6);
+	::close(fd);
+
+	ev_run(loop, EVRUN_ONCE);
+
+	ASSERT_EQ(0, mgr.size());
+	ASSERT_EQ(0, mgr.openFiles());
+
+	// the stale mapping is gone, and a fresh query sees the new contents
+	ASSERT_FALSE(a->isCached());
+	ASSERT_TRUE(a->data() == nullptr);
+
+	FilePtr b = mgr.query(path);
+	ASSERT_TRUE(a != b);
+	ASSERT_EQ(12, b->size());
+
+	unlink(path.c_str());
+}
+
+TEST(FileMgr, streamOutlivesCache)
+{
+	ev::dynamic_loop loop;
+	FileMgr::Config config;
+	config.maxOpenFiles = 1;
+	FileMgr mgr(loop, &config);
+
+	std::string a = createTempFile("AAAA-this-file");
+	std::string b = createTempFile("BBBB-other-file");
+
+	// the only FilePtr is dropped right away, and the next query evicts its descriptor
+	auto fs = mgr.query(a)->open(O_RDONLY);
+	auto other = mgr.query(b)->open(O_RDONLY);
+	ASSERT_EQ(1, mgr.openFiles());
+
+	Buffer buf;
+	ASSERT_EQ(14, fs->read(buf, 100));
+	ASSERT_TRUE(buf == "AAAA-this-file");
+
+	unlink(a.c_str());
+	unlink(b.c_str());
+}
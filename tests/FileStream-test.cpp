@@ -0,0 +1,101 @@
+#include <gtest/gtest.h>
+#include <xio/FileStream.h>
+#include <xio/Socket.h>
+#include <xio/Pipe.h>
+#include <xio/Buffer.h>
+#include <string>
+#include <sys/socket.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <ev++.h>
+
+using namespace xio;
+
+static int createTempFile(const std::string& content)
+{
+	char path[] = "/tmp/xio-FileStream-test.XXXXXX";
+	int fd = mkstemp(path);
+	unlink(path);
+
+	if (fd >= 0)
+		::write(fd, content.data(), content.size());
+
+	return fd;
+}
+
+static const std::string content = "0123456789abcdefghijklmnopqrstuvwxyz";
+
+TEST(FileStream, window)
+{
+	int fd = createTempFile(content);
+	ASSERT_TRUE(fd >= 0);
+
+	FileStream whole(fd, false);
+	ASSERT_EQ(content.size(), whole.size());
+
+	// two streams sharing the same fd, read interleaved
+	FileStream a(fd, 10, 6, false);
+	FileStream b(fd, 30, 6, true);
+
+	char buf[16];
+	ASSERT_EQ(3, a.read(buf, 3));
+	ASSERT_EQ(0, memcmp(buf, "abc", 3));
+	ASSERT_EQ(4, b.read(buf, 4));
+	ASSERT_EQ(0, memcmp(buf, "uvwx", 4));
+
+	ASSERT_EQ('d', a.read());
+	ASSERT_EQ(2, a.size());
+	ASSERT_EQ(14, a.offset());
+
+	Buffer result;
+	ASSERT_EQ(2, a.read(result, 100));
+	ASSERT_TRUE(result == "ef");
+	ASSERT_EQ(0, a.size());
+	ASSERT_EQ(0, a.read(buf, sizeof(buf)));
+
+	// the fd's own position remained untouched
+	ASSERT_EQ(content.size(), lseek(fd, 0, SEEK_CUR));
+}
+
+TEST(FileStream, sendfile)
+{
+	int fd = createTempFile(content);
+	FileStream fs(fd, 4, 8);
+
+	int sv[2];
+	ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, sv));
+
+	ev::dynamic_loop loop;
+	Socket socket(loop, sv[0], AF_UNIX);
+
+	ASSERT_EQ(5, socket.write(&fs, 5));
+	ASSERT_EQ(3, fs.read(&socket, 100));
+	ASSERT_EQ(0, fs.size());
+
+	char buf[16];
+	ASSERT_EQ(8, ::read(sv[1], buf, sizeof(buf)));
+	ASSERT_EQ(0, memcmp(buf, "456789ab", 8));
+
+	::close(sv[1]);
+}
+
+TEST(FileStream, splice)
+{
+	int fd = createTempFile(content);
+	FileStream fs(fd, 26, 10);
+	Pipe pipe(O_NONBLOCK);
+
+	ASSERT_EQ(10, fs.read(&pipe, 100));
+	ASSERT_EQ(10, pipe.size());
+
+	// append pipe contents to the end of another window
+	FileStream out(fd, 0, content.size(), false);
+	ASSERT_EQ(10, out.write(&pipe, pipe.size()));
+	ASSERT_EQ(0, pipe.size());
+	ASSERT_EQ(content.size() + 10, out.size());
+
+	Buffer result;
+	FileStream tail(fd, content.size(), 10, false);
+	ASSERT_EQ(10, tail.read(result, 10));
+	ASSERT_TRUE(result == "qrstuvwxyz");
+}
@@ -0,0 +1,137 @@
+#include <gtest/gtest.h>
+#include <xio/FilterStream.h>
+#include <xio/BufferStream.h>
+#include <xio/Filter.h>
+#include <memory>
+#include <cstring>
+
+using namespace xio;
+
+// uppercases its input
+class UpperFilter : public Filter
+{
+public:
+	virtual ssize_t process(const BufferRef& input, Buffer& output)
+	{
+		for (char ch: input)
+			output.push_back(static_cast<char>(toupper(ch)));
+
+		return input.size();
+	}
+};
+
+// holds back all data until flushed, and appends a trailer when finished
+class HoldingFilter : public Filter
+{
+public:
+	HoldingFilter() : held_(), finished_(0) {}
+
+	int finished() const { return finished_; }
+
+	virtual ssize_t process(const BufferRef& input, Buffer& /*output*/)
+	{
+		held_.push_back(input);
+		return 0;
+	}
+
+	virtual ssize_t flush(Buffer& output)
+	{
+		ssize_t n = held_.size();
+		output.push_back(held_);
+		held_.clear();
+		return n;
+	}
+
+	virtual ssize_t finish(Buffer& output)
+	{
+		++finished_;
+		ssize_t n = flush(output);
+		output.push_back("$");
+		return n + 1;
+	}
+
+private:
+	Buffer held_;
+	int finished_;
+};
+
+static BufferStream* source(const char* data)
+{
+	BufferStream* stream = new BufferStream();
+	stream->write(data, strlen(data));
+	return stream;
+}
+
+static Buffer drain(Stream& stream)
+{
+	Buffer result;
+	while (stream.read(result, 3) > 0)
+		;
+	return result;
+}
+
+TEST(FilterStream, passThrough)
+{
+	FilterStream stream(std::unique_ptr<Stream>(source("hello")));
+
+	ASSERT_EQ("hello", drain(stream));
+	ASSERT_TRUE(stream.finished());
+	ASSERT_TRUE(stream.empty());
+}
+
+TEST(FilterStream, readChar)
+{
+	FilterStream stream(source("hello, world"), std::unique_ptr<Filter>(new UpperFilter()));
+
+	char buf[5];
+	ASSERT_EQ(5, stream.read(buf, sizeof(buf)));
+	ASSERT_EQ("HELLO", Buffer(BufferRef(buf, 5), 0, 5));
+
+	ASSERT_EQ(',', stream.read());
+
+	ASSERT_EQ(5, stream.read(buf, sizeof(buf)));
+	ASSERT_EQ(" WORL", Buffer(BufferRef(buf, 5), 0, 5));
+
+	ASSERT_EQ(1, stream.read(buf, sizeof(buf)));
+	ASSERT_EQ('D', buf[0]);
+
+	ASSERT_EQ(0, stream.read(buf, sizeof(buf)));
+	ASSERT_EQ(-1, stream.read());
+}
+
+TEST(FilterStream, chain)
+{
+	HoldingFilter* holder = new HoldingFilter();
+
+	FilterStream stream(source("abc"), std::unique_ptr<Filter>(holder));
+	stream.filters.push_back(std::unique_ptr<Filter>(new UpperFilter()));
+
+	ASSERT_EQ("ABC$", drain(stream));
+	ASSERT_EQ(1, holder->finished());
+}
+
+TEST(FilterStream, write)
+{
+	HoldingFilter* holder = new HoldingFilter();
+	BufferStream* sink = new BufferStream();
+
+	FilterStream stream(sink, std::unique_ptr<Filter>(new UpperFilter()));
+	stream.filters.push_back(std::unique_ptr<Filter>(holder));
+
+	ASSERT_EQ(3, stream.write("abc", 3));
+	ASSERT_EQ(3, stream.write("def", 3));
+	ASSERT_EQ(0, sink->size());
+
+	ASSERT_TRUE(stream.flush());
+	ASSERT_EQ(6, sink->size());
+
+	ASSERT_EQ(2, stream.write("gh", 2));
+	ASSERT_TRUE(stream.finish());
+	ASSERT_TRUE(stream.finished());
+	ASSERT_EQ(1, holder->finished());
+
+	ASSERT_EQ("ABCDEFGH$", drain(*sink));
+
+	ASSERT_EQ(-1, stream.write("x", 1));
+	ASSERT_EQ(EPIPE, errno);
+}
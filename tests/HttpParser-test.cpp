@@ -0,0 +1,130 @@
+#include <gtest/gtest.h>
+#include <xio/HttpParser.h>
+#include <xio/Buffer.h>
+#include <cstring>
+
+using namespace xio;
+
+static const char request[] =
+	"GET /index.html?q=1 HTTP/1.1\r\n"
+	"Host: example.com\r\n"
+	"User-Agent: xio-test/1.0 \t \r\n"
+	"Accept:*/*\r\n"
+	"X-Empty:\r\n"
+	"\r\n";
+
+TEST(HttpParser, request)
+{
+	HttpParser parser(HttpParser::REQUEST);
+
+	ASSERT_EQ(sizeof(request) - 1, parser.parse(BufferRef(request)));
+	ASSERT_TRUE(parser.isComplete());
+
+	ASSERT_EQ("GET", parser.method());
+	ASSERT_EQ("/index.html?q=1", parser.uri());
+	ASSERT_EQ(1, parser.versionMajor());
+	ASSERT_EQ(1, parser.versionMinor());
+
+	ASSERT_EQ(4, parser.headerCount());
+	ASSERT_EQ("Host", parser.headerName(0));
+	ASSERT_EQ("example.com", parser.headerValue(0));
+	ASSERT_EQ("xio-test/1.0", parser.header(BufferRef("user-agent")));
+	ASSERT_EQ("*/*", parser.header(BufferRef("ACCEPT")));
+	ASSERT_EQ("", parser.header(BufferRef("X-Empty")));
+	ASSERT_TRUE(parser.header(BufferRef("Cookie")).empty());
+}
+
+TEST(HttpParser, response)
+{
+	HttpParser parser(HttpParser::RESPONSE);
+	BufferRef input("HTTP/1.0 404 Not Found\nContent-Length: 0\n\nbody");
+
+	ASSERT_EQ(input.size() - 4, parser.parse(input));
+	ASSERT_EQ(404, parser.status());
+	ASSERT_EQ("Not Found", parser.reason());
+	ASSERT_EQ(0, parser.versionMinor());
+	ASSERT_EQ("0", parser.header(BufferRef("Content-Length")));
+
+	parser.reset();
+	ASSERT_EQ(16, parser.parse(BufferRef("HTTP/1.1 204\r\n\r\n\r\n")));
+	ASSERT_EQ(204, parser.status());
+	ASSERT_TRUE(parser.reason().empty());
+}
+
+TEST(HttpParser, incremental)
+{
+	// feed byte by byte, reallocating the input buffer in between
+	HttpParser parser;
+	const size_t length = sizeof(request) - 1;
+
+	for (size_t n = 1; n < length; ++n) {
+		Buffer buf;
+		buf.push_back(request, n);
+		ASSERT_EQ(0, parser.parse(buf.ref()));
+		ASSERT_EQ(n, parser.parsed());
+	}
+
+	Buffer buf;
+	buf.push_back(request, length);
+	ASSERT_EQ(length, parser.parse(buf.ref()));
+	ASSERT_EQ("/index.html?q=1", parser.uri());
+	ASSERT_EQ("xio-test/1.0", parser.headerValue(1));
+}
+
+TEST(HttpParser, pipelined)
+{
+	Buffer buf;
+	for (int i = 0; i < 3; ++i)
+		buf.push_back(request);
+
+	HttpParser parser;
+	size_t offset = 0;
+	int count = 0;
+
+	while (offset < buf.size()) {
+		parser.reset();
+		ssize_t n = parser.parse(buf.ref(offset));
+		ASSERT_LT(0, n);
+		ASSERT_EQ("example.com", parser.header(BufferRef("Host")));
+		offset += n;
+		++count;
+	}
+
+	ASSERT_EQ(3, count);
+}
+
+TEST(HttpParser, malformed)
+{
+	const char* inputs[] = {
+		"GET  / HTTP/1.1\r\n\r\n",            // empty URI
+		"G@T / HTTP/1.1\r\n\r\n",             // invalid method
+		"GET / HTTP/1.x\r\n\r\n",             // invalid version
+		"GET / HTTP/1.1\r\nHost : x\r\n\r\n", // space before colon
+		"GET / HTTP/1.1\r\nA: b\r\n c\r\n\r\n", // obsolete line folding
+		"GET / HTTP/1.1\r\nA: b\x01\r\n\r\n",  // control character
+		"GET / HTTP/1.1\rX",                  // CR without LF
+	};
+
+	for (const char* input: inputs) {
+		HttpParser parser;
+		ASSERT_EQ(-1, parser.parse(BufferRef(input, strlen(input))));
+		ASSERT_EQ(EBADMSG, errno);
+		ASSERT_TRUE(parser.isError());
+	}
+
+	HttpParser parser(HttpParser::RESPONSE);
+	ASSERT_EQ(-1, parser.parse(BufferRef("HTTP/1.1 20 OK\r\n\r\n")));
+}
+
+TEST(HttpParser, tooManyHeaders)
+{
+	Buffer buf;
+	buf.push_back("GET / HTTP/1.1\r\n");
+	for (int i = 0; i <= HttpParser::MAX_HEADERS; ++i)
+		buf.push_back("X: y\r\n");
+	buf.push_back("\r\n");
+
+	HttpParser parser;
+	ASSERT_EQ(-1, parser.parse(buf.ref()));
+	ASSERT_EQ(E2BIG, errno);
+}
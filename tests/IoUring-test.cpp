@@ -0,0 +1,68 @@
+#include <gtest/gtest.h>
+#include <xio/IoUring.h>
+#include <sys/socket.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <ev++.h>
+
+using namespace xio;
+
+TEST(IoUring, readWrite)
+{
+	ev::dynamic_loop loop;
+	IoUring ring(loop);
+
+	if (!ring.isOpen()) {
+		ASSERT_FALSE(IoUring::isSupported());
+		return; // kernel without io_uring, fallback is tested elsewhere
+	}
+
+	int fds[2];
+	ASSERT_EQ(0, pipe(fds));
+
+	char buf[16] = {0};
+	ssize_t written = -1;
+	ssize_t nread = -1;
+
+	// both requests are submitted in one batch, the read is linked to the write.
+	ASSERT_TRUE(ring.write(fds[1], "hello", 5, -1, [&](ssize_t rv) { written = rv; }) != nullptr);
+	ring.link();
+	ASSERT_TRUE(ring.read(fds[0], buf, sizeof(buf), -1, [&](ssize_t rv) { nread = rv; }) != nullptr);
+	ASSERT_EQ(2, ring.pending());
+
+	ev_run(loop, 0);
+
+	ASSERT_EQ(0, ring.pending());
+	ASSERT_EQ(0, ring.inflight());
+	ASSERT_EQ(5, written);
+	ASSERT_EQ(5, nread);
+	ASSERT_EQ(0, memcmp(buf, "hello", 5));
+
+	::close(fds[0]);
+	::close(fds[1]);
+}
+
+TEST(IoUring, cancel)
+{
+	ev::dynamic_loop loop;
+	IoUring ring(loop);
+
+	if (!ring.isOpen())
+		return;
+
+	int fds[2];
+	ASSERT_EQ(0, pipe(fds));
+
+	bool invoked = false;
+	IoUring::Request* request = ring.poll(fds[0], POLLIN, [&](ssize_t) { invoked = true; });
+	ring.submit();
+	ring.cancel(request);
+
+	ev_run(loop, 0);
+
+	ASSERT_FALSE(invoked);
+	ASSERT_EQ(0, ring.inflight());
+
+	::close(fds[0]);
+	::close(fds[1]);
+}
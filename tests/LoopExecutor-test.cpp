@@ -0,0 +1,134 @@
+#include <gtest/gtest.h>
+#include <xio/LoopExecutor.h>
+#include <xio/Socket.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+
+using namespace xio;
+
+TEST(LoopExecutor, multipleProducers)
+{
+	ev::dynamic_loop loop;
+	LoopExecutor executor(loop, 64);
+	ASSERT_EQ(64, executor.capacity());
+
+	const int producers = 4;
+	const int tasksPerProducer = 10000;
+	int count = 0; // only touched within the loop's thread
+
+	std::vector<std::thread> threads;
+	for (int i = 0; i < producers; ++i) {
+		threads.emplace_back([&]() {
+			for (int k = 0; k < tasksPerProducer; ++k) {
+				executor.post([&]() {
+					if (++count == producers * tasksPerProducer) {
+						ev_break(loop, EVBREAK_ALL);
+					}
+				});
+			}
+		});
+	}
+
+	ev_run(loop, 0);
+
+	for (auto& thread: threads)
+		thread.join();
+
+	ASSERT_EQ(producers * tasksPerProducer, count);
+	ASSERT_EQ(0, executor.size());
+}
+
+TEST(LoopExecutor, budget)
+{
+	ev::dynamic_loop loop;
+	LoopExecutor executor(loop, 16, 3);
+
+	int count = 0;
+	for (int i = 0; i < 10; ++i)
+		ASSERT_TRUE(executor.tryPost([&]() { ++count; }));
+
+	ev_run(loop, EVRUN_NOWAIT);
+	ASSERT_EQ(3, count);
+
+	while (count < 10)
+		ev_run(loop, EVRUN_NOWAIT);
+
+	ASSERT_EQ(0, executor.size());
+}
+
+TEST(LoopExecutor, bounded)
+{
+	ev::dynamic_loop loop;
+	LoopExecutor executor(loop, 4);
+
+	for (int i = 0; i < 4; ++i)
+		ASSERT_TRUE(executor.tryPost([]() {}));
+
+	ASSERT_FALSE(executor.tryPost([]() {}));
+	ASSERT_EQ(4, executor.drain(100));
+	ASSERT_TRUE(executor.tryPost([]() {}));
+}
+
+TEST(LoopExecutor, dispatch)
+{
+	ev::dynamic_loop loop;
+	LoopExecutor executor(loop);
+
+	// not attached to any thread until the loop ran (or attach() was called)
+	bool invoked = false;
+	ASSERT_FALSE(executor.isInLoopThread());
+	executor.dispatch([&]() { invoked = true; });
+	ASSERT_FALSE(invoked);
+	ASSERT_EQ(1, executor.size());
+
+	ev_run(loop, EVRUN_NOWAIT);
+	ASSERT_TRUE(invoked);
+	ASSERT_TRUE(executor.isInLoopThread());
+
+	invoked = false;
+	executor.dispatch([&]() { invoked = true; });
+	ASSERT_TRUE(invoked);
+	ASSERT_EQ(0, executor.size());
+
+	std::thread([&]() {
+		ASSERT_FALSE(executor.isInLoopThread());
+		executor.dispatch([&]() { ev_break(loop, EVBREAK_ALL); });
+	}).join();
+
+	ASSERT_EQ(1, executor.size());
+	ev_run(loop, 0);
+	ASSERT_EQ(0, executor.size());
+}
+
+TEST(LoopExecutor, moveSocket)
+{
+	ev::dynamic_loop source;
+	ev::dynamic_loop target;
+	LoopExecutor executor(target);
+
+	int fds[2];
+	ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds));
+
+	Socket* socket = new Socket(source, fds[0], AF_UNIX);
+	socket->setLoop(target);
+	ASSERT_TRUE(socket->loop() == target);
+
+	int result = 0;
+	executor.post([&]() {
+		socket->on(Socket::READ, TimeSpan::fromSeconds(5), [&](int revents) {
+			result = revents;
+			socket->stop();
+			ev_break(target, EVBREAK_ALL);
+		});
+	});
+
+	::write(fds[1], "x", 1);
+	ev_run(target, 0);
+
+	ASSERT_EQ(Socket::READ, result);
+
+	delete socket;
+	::close(fds[1]);
+}
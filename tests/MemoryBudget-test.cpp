@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+#include <xio/MemoryBudget.h>
+#include <xio/BufferStream.h>
+#include <xio/ChunkedStream.h>
+#include <xio/Buffer.h>
+#include <string>
+#include <errno.h>
+
+using namespace xio;
+
+TEST(MemoryBudget, charge)
+{
+	MemoryBudget global(100);
+	MemoryBudget connection(80, &global);
+	MemoryBudget other(0, &global);
+
+	ASSERT_TRUE(connection.charge(60));
+	ASSERT_EQ(60, connection.used());
+	ASSERT_EQ(60, global.used());
+	ASSERT_EQ(20, connection.available());
+
+	// exceeds the connection's own limit
+	ASSERT_FALSE(connection.charge(30));
+	ASSERT_EQ(EAGAIN, errno);
+	ASSERT_EQ(1, connection.rejected());
+
+	// exceeds the global limit only
+	ASSERT_TRUE(other.charge(30));
+	ASSERT_FALSE(connection.charge(20));
+	ASSERT_EQ(60, connection.used());
+	ASSERT_EQ(90, global.used());
+
+	connection.release(60);
+	other.release(30);
+	ASSERT_EQ(0, global.used());
+	ASSERT_EQ(90, global.peak());
+	ASSERT_EQ(60, connection.peak());
+}
+
+TEST(MemoryBudget, buffer)
+{
+	MemoryBudget budget(8192);
+
+	{
+		Buffer buf(budget.allocator());
+		buf.push_back(std::string(1000, 'a'));
+		ASSERT_EQ(1000, buf.size());
+		ASSERT_EQ(buf.capacity(), budget.used());
+
+		Buffer moved(std::move(buf));
+		ASSERT_EQ(moved.capacity(), budget.used());
+
+		ASSERT_FALSE(moved.reserve(10000));
+		ASSERT_EQ(1000, moved.size());
+	}
+
+	ASSERT_EQ(0, budget.used());
+}
+
+TEST(MemoryBudget, bufferUpToLimit)
+{
+	MemoryBudget budget(6000);
+	Buffer buf(budget.allocator());
+
+	ASSERT_TRUE(buf.reserve(4096));
+	ASSERT_EQ(4096, budget.used());
+
+	// the allocator's growth step exceeds the budget, the required size does not
+	ASSERT_TRUE(buf.reserve(4097));
+	ASSERT_LE(budget.used(), 6000);
+
+	ASSERT_TRUE(buf.reserve(6000));
+	ASSERT_EQ(6000, budget.used());
+
+	ASSERT_FALSE(buf.reserve(6001));
+	ASSERT_EQ(EAGAIN, errno);
+	ASSERT_EQ(6000, buf.capacity());
+}
+
+TEST(MemoryBudget, bufferStream)
+{
+	MemoryBudget budget(4096);
+	BufferStream stream(&budget);
+
+	std::string chunk(1024, 'x');
+	ASSERT_EQ(1024, stream.write(chunk.data(), chunk.size()));
+
+	ssize_t rv;
+	while ((rv = stream.write(chunk.data(), chunk.size())) > 0)
+		;
+
+	ASSERT_EQ(-1, rv);
+	ASSERT_EQ(EAGAIN, errno);
+	ASSERT_LE(budget.used(), 4096);
+}
+
+TEST(MemoryBudget, chunkedStream)
+{
+	MemoryBudget budget(16 * 1024);
+	ChunkedStream stream;
+	stream.setBudget(&budget);
+
+	std::string chunk(4096, 'y');
+	size_t total = 0;
+	ssize_t rv;
+	while ((rv = stream.write(chunk.data(), chunk.size())) > 0)
+		total += rv;
+
+	ASSERT_EQ(-1, rv);
+	ASSERT_EQ(EAGAIN, errno);
+	ASSERT_LT(0, total);
+	ASSERT_EQ(total, stream.size());
+	ASSERT_LE(budget.used(), 16 * 1024);
+
+	// draining the stream gives the budget back
+	Buffer out;
+	ASSERT_EQ(total, stream.read(out, total));
+	ASSERT_EQ(0, budget.used());
+	ASSERT_EQ(chunk.size(), stream.write(chunk.data(), chunk.size()));
+}
@@ -0,0 +1,79 @@
+#include <gtest/gtest.h>
+#include <xio/PipePool.h>
+#include <xio/Pipe.h>
+#include <xio/ChunkedStream.h>
+
+using namespace xio;
+
+TEST(PipePool, recycle)
+{
+	PipePool pool(2);
+	ASSERT_TRUE(pool.empty());
+
+	Pipe* a = pool.acquire();
+	ASSERT_TRUE(a != nullptr);
+	ASSERT_TRUE(a->isOpen());
+
+	pool.release(a);
+	ASSERT_EQ(1, pool.size());
+
+	Pipe* b = pool.acquire();
+	ASSERT_EQ(a, b);
+	ASSERT_TRUE(pool.empty());
+
+	pool.release(b);
+}
+
+TEST(PipePool, releaseNonEmpty)
+{
+	PipePool pool;
+	Pipe* pipe = pool.acquire();
+	pipe->write("foo", 3);
+
+	pool.release(pipe);
+	ASSERT_TRUE(pool.empty());
+}
+
+TEST(PipePool, highWaterMark)
+{
+	PipePool pool(1);
+	Pipe* a = pool.acquire();
+	Pipe* b = pool.acquire();
+
+	pool.release(a);
+	pool.release(b);
+	ASSERT_EQ(1, pool.size());
+
+	pool.setHighWaterMark(0);
+	ASSERT_TRUE(pool.empty());
+}
+
+TEST(PipePool, pipeSize)
+{
+	PipePool pool(4, 128 * 1024);
+	Pipe* pipe = pool.acquire();
+	ASSERT_TRUE(pipe->capacity() >= 128 * 1024);
+	pool.release(pipe);
+}
+
+TEST(PipePool, chunkedStream)
+{
+	PipePool pool;
+	Pipe source;
+	char buf[10];
+
+	{
+		ChunkedStream stream(&pool);
+		source.write("foo", 3);
+		ASSERT_EQ(3, stream.write(&source, source.size(), Stream::MOVE));
+		ASSERT_EQ(3, stream.read(buf, sizeof(buf)));
+		ASSERT_EQ(1, pool.size());
+
+		source.write("bar", 3);
+		ASSERT_EQ(3, stream.write(&source, source.size(), Stream::MOVE));
+		ASSERT_TRUE(pool.empty());
+	}
+
+	// stream got destructed with a non-empty pipe
+	ASSERT_TRUE(pool.empty());
+}
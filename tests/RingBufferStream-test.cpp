@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+#include <xio/RingBufferStream.h>
+#include <xio/Socket.h>
+#include <xio/Buffer.h>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <errno.h>
+#include <ev++.h>
+
+using namespace xio;
+
+TEST(RingBufferStream, wrapAround)
+{
+	RingBufferStream ring(8);
+	ASSERT_EQ(8, ring.capacity());
+	ASSERT_FALSE(ring.isMirrored());
+
+	ASSERT_EQ(6, ring.write("abcdef", 6));
+	ASSERT_EQ('a', ring.read());
+
+	char buf[8];
+	ASSERT_EQ(3, ring.read(buf, 3));
+	ASSERT_EQ("bcd", std::string(buf, 3));
+
+	// wraps around the end of the ring
+	ASSERT_EQ(6, ring.write("ghijklmn", 8));
+	ASSERT_TRUE(ring.full());
+	ASSERT_EQ(-1, ring.write("o", 1));
+	ASSERT_EQ(EAGAIN, errno);
+
+	struct iovec iov[2];
+	ASSERT_EQ(2, ring.readRegions(iov));
+	ASSERT_EQ("efgh", std::string((char*) iov[0].iov_base, iov[0].iov_len));
+	ASSERT_EQ("ijkl", std::string((char*) iov[1].iov_base, iov[1].iov_len));
+	ASSERT_EQ(1, ring.readRegions(iov, 3));
+	ASSERT_EQ(3, iov[0].iov_len);
+
+	Buffer result;
+	ASSERT_EQ(8, ring.read(result, 100));
+	ASSERT_EQ("efghijkl", result.str());
+	ASSERT_EQ(0, ring.size());
+	ASSERT_EQ(-1, ring.read());
+}
+
+TEST(RingBufferStream, mirrored)
+{
+	RingBufferStream ring(100, true);
+	if (!ring.isMirrored())
+		return; // not supported by the system
+
+	size_t capacity = ring.capacity();
+	ASSERT_EQ(0, capacity % sysconf(_SC_PAGESIZE));
+
+	std::string head(capacity - 10, 'x');
+	ASSERT_EQ(head.size(), ring.write(head.data(), head.size()));
+	ring.consume(head.size() - 5);
+
+	ASSERT_EQ(20, ring.write("0123456789abcdefghij", 20));
+
+	// the buffered data is contiguous, even though it wraps around
+	struct iovec iov[2];
+	ASSERT_EQ(1, ring.readRegions(iov));
+	ASSERT_EQ(25, iov[0].iov_len);
+	ASSERT_EQ("xxxxx0123456789abcdefghij", std::string(ring.data(), ring.size()));
+}
+
+TEST(RingBufferStream, socket)
+{
+	ev::dynamic_loop loop;
+
+	int fds[2];
+	ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+	Socket a(loop, fds[0], AF_UNIX);
+	Socket b(loop, fds[1], AF_UNIX);
+
+	RingBufferStream ring(16);
+
+	// keep one byte buffered all the time, so the regions keep wrapping around
+	ASSERT_EQ(1, ring.write("#", 1));
+
+	// stream far more data through the ring than it can hold, its footprint stays constant
+	std::string sent("#");
+	std::string received;
+	for (int i = 0; i < 100; ++i) {
+		std::string chunk = std::to_string(i * 7919) + ";";
+		sent += chunk;
+		ASSERT_EQ(chunk.size(), ::write(fds[0], chunk.data(), chunk.size()));
+
+		ASSERT_EQ(chunk.size(), ring.write(&b, chunk.size()));
+		ASSERT_EQ(chunk.size(), ring.read(&b, chunk.size()));
+
+		char buf[16];
+		ASSERT_EQ(chunk.size(), ::read(fds[0], buf, sizeof(buf)));
+		received.append(buf, chunk.size());
+	}
+
+	ASSERT_EQ(1, ring.size());
+	received.push_back(ring.read());
+
+	ASSERT_EQ(sent, received);
+	ASSERT_EQ(16, ring.capacity());
+}
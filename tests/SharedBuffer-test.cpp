@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+#include <xio/SharedBuffer.h>
+#include <thread>
+
+using namespace xio;
+
+TEST(SharedBuffer, empty)
+{
+	SharedBuffer b;
+	ASSERT_TRUE(b.empty());
+	ASSERT_EQ(0, b.useCount());
+}
+
+TEST(SharedBuffer, moveFromBuffer)
+{
+	Buffer buf;
+	buf.push_back("Hello, World");
+	const char* storage = buf.data();
+
+	SharedBuffer b(std::move(buf));
+	ASSERT_TRUE(buf.empty());
+	ASSERT_EQ(0, buf.capacity());
+
+	ASSERT_EQ(storage, b.data()); // no copy
+	ASSERT_EQ("Hello, World", b);
+	ASSERT_EQ(1, b.useCount());
+}
+
+TEST(SharedBuffer, copy)
+{
+	SharedBuffer b(BufferRef("foo.bar"));
+	ASSERT_EQ("foo.bar", b);
+
+	SharedBuffer c(b);
+	ASSERT_EQ(2, b.useCount());
+	ASSERT_EQ(b.data(), c.data());
+
+	SharedBuffer d(std::move(c));
+	ASSERT_EQ(2, b.useCount());
+	ASSERT_TRUE(c.empty());
+}
+
+TEST(SharedBuffer, slice)
+{
+	SharedBuffer tail;
+	{
+		Buffer buf("GET /index.html HTTP/1.1");
+		SharedBuffer b(std::move(buf));
+		SharedBuffer path = b.slice(4, 11);
+		tail = b.slice(16);
+
+		ASSERT_EQ("/index.html", path);
+		ASSERT_EQ(3, b.useCount());
+	}
+
+	// slice still pins the segment
+	ASSERT_EQ("HTTP/1.1", tail);
+	ASSERT_EQ(1, tail.useCount());
+}
+
+TEST(SharedBuffer, crossThread)
+{
+	SharedBuffer b(Buffer("payload"));
+	std::string result;
+
+	std::thread t([&result](SharedBuffer v) { result = v.str(); }, b.slice(0, 3));
+	t.join();
+
+	ASSERT_EQ("pay", result);
+	ASSERT_EQ(1, b.useCount());
+}
@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+#include <xio/Socket.h>
+#include <xio/IPAddress.h>
+#include <xio/SharedBuffer.h>
+#include <string>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <fcntl.h>
+#include <ev++.h>
+
+using namespace xio;
+
+// creates a listening TCP socket on a random loopback port
+static int listenLoopback(int* port)
+{
+	int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+
+	sockaddr_in sin;
+	memset(&sin, 0, sizeof(sin));
+	sin.sin_family = AF_INET;
+	sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+	socklen_t len = sizeof(sin);
+	if (::bind(fd, (sockaddr*) &sin, sizeof(sin)) < 0
+			|| ::listen(fd, 1) < 0
+			|| ::getsockname(fd, (sockaddr*) &sin, &len) < 0) {
+		::close(fd);
+		return -1;
+	}
+
+	*port = ntohs(sin.sin_port);
+	return fd;
+}
+
+TEST(Socket, zeroCopy)
+{
+	ev::dynamic_loop loop;
+
+	int port = 0;
+	int listener = listenLoopback(&port);
+	ASSERT_LE(0, listener);
+
+	Socket client(loop);
+	ASSERT_EQ(Socket::Operational, client.open(IPAddress("127.0.0.1"), port));
+	int peer = ::accept(listener, nullptr, nullptr);
+	ASSERT_LE(0, peer);
+
+	if (!client.setZeroCopy(true)) {
+		// kernel without SO_ZEROCOPY support
+		::close(peer);
+		::close(listener);
+		return;
+	}
+
+	Buffer buffer;
+	buffer.push_back(std::string(64 * 1024, 'z'));
+	SharedBuffer payload(std::move(buffer));
+
+	// small payloads are copied
+	ASSERT_EQ(16, client.write(payload.slice(0, 16), Stream::ZEROCOPY));
+	ASSERT_EQ(0, client.zeroCopyPending());
+
+	ssize_t rv = client.write(payload, Stream::ZEROCOPY);
+	ASSERT_LT(0, rv);
+	ASSERT_EQ(1, client.zeroCopyPending());
+	ASSERT_EQ(2, payload.useCount());
+
+	std::string received;
+	char buf[4096];
+	while (received.size() < 16 + static_cast<size_t>(rv)) {
+		ssize_t n = ::read(peer, buf, sizeof(buf));
+		ASSERT_LT(0, n);
+		received.append(buf, n);
+	}
+
+	// the completion on the error queue wakes up the socket's watcher
+	int events = 0;
+	client.on(Socket::READ, TimeSpan::fromSeconds(5), [&](int revents) {
+		events = revents;
+		client.stop();
+	});
+	ev_run(loop, 0);
+
+	ASSERT_NE(0, events & Socket::READ);
+	ASSERT_EQ(0, client.zeroCopyPending());
+	ASSERT_EQ(1, payload.useCount());
+
+	::close(peer);
+	::close(listener);
+}
@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+#include <xio/SpliceProxy.h>
+#include <xio/PipePool.h>
+#include <xio/Socket.h>
+#include <string>
+#include <sys/socket.h>
+#include <fcntl.h>
+#include <ev++.h>
+
+using namespace xio;
+
+static std::string readAll(int fd)
+{
+	std::string result;
+	char buf[4096];
+
+	while (ssize_t n = ::read(fd, buf, sizeof(buf))) {
+		if (n < 0)
+			break;
+
+		result.append(buf, n);
+	}
+
+	return result;
+}
+
+TEST(SpliceProxy, bidirectional)
+{
+	ev::dynamic_loop loop;
+	PipePool pipePool;
+
+	int client[2];
+	int backend[2];
+	ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, client));
+	ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, backend));
+	fcntl(client[1], F_SETFL, O_NONBLOCK);
+	fcntl(backend[0], F_SETFL, O_NONBLOCK);
+
+	std::string request(48 * 1024, 'q');
+	std::string response(32 * 1024, 'r');
+
+	ASSERT_EQ(request.size(), ::write(client[0], request.data(), request.size()));
+	ASSERT_EQ(0, ::shutdown(client[0], SHUT_WR));
+
+	ASSERT_EQ(response.size(), ::write(backend[1], response.data(), response.size()));
+	ASSERT_EQ(0, ::shutdown(backend[1], SHUT_WR));
+
+	SpliceProxy proxy(new Socket(loop, client[1], AF_UNIX), new Socket(loop, backend[0], AF_UNIX), &pipePool);
+
+	int closed = 0;
+	proxy.onClose = [&](SpliceProxy*) { ++closed; };
+	proxy.start(TimeSpan::fromSeconds(5));
+	ASSERT_TRUE(proxy.isActive());
+
+	ev_run(loop, 0);
+
+	ASSERT_EQ(1, closed);
+	ASSERT_FALSE(proxy.isActive());
+	ASSERT_EQ(0, proxy.error());
+	ASSERT_EQ(request.size(), proxy.bytesUpstream());
+	ASSERT_EQ(response.size(), proxy.bytesDownstream());
+	ASSERT_EQ(2, pipePool.size());
+
+	ASSERT_TRUE(readAll(backend[1]) == request);
+	ASSERT_TRUE(readAll(client[0]) == response);
+
+	::close(client[0]);
+	::close(backend[1]);
+}
+
+TEST(SpliceProxy, idleTimeout)
+{
+	ev::dynamic_loop loop;
+
+	int client[2];
+	int backend[2];
+	ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, client));
+	ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, backend));
+
+	SpliceProxy proxy(new Socket(loop, client[1], AF_UNIX), new Socket(loop, backend[0], AF_UNIX));
+
+	int closed = 0;
+	proxy.onClose = [&](SpliceProxy*) { ++closed; };
+	proxy.start(TimeSpan::fromMilliseconds(20));
+
+	ev_run(loop, 0);
+
+	ASSERT_EQ(1, closed);
+	ASSERT_EQ(ETIMEDOUT, proxy.error());
+
+	::close(client[0]);
+	::close(backend[1]);
+}
@@ -0,0 +1,150 @@
+#include <gtest/gtest.h>
+#include <xio/ThreadPool.h>
+#include <xio/LoopExecutor.h>
+#include <xio/FileStream.h>
+#include <xio/FileMgr.h>
+#include <xio/Buffer.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <ev++.h>
+
+using namespace xio;
+
+static std::string createTempFile(const char* content)
+{
+	char path[] = "/tmp/xio-ThreadPool-test.XXXXXX";
+	int fd = mkstemp(path);
+	::write(fd, content, strlen(content));
+	::close(fd);
+	return path;
+}
+
+TEST(ThreadPool, completion)
+{
+	ev::dynamic_loop loop;
+	LoopExecutor executor(loop);
+	ThreadPool pool(2);
+
+	ssize_t result = 0;
+	int error = 0;
+
+	ASSERT_TRUE(pool.post(&executor,
+		[]() -> ssize_t { errno = ENOENT; return -1; },
+		[&](ssize_t rv) {
+			result = rv;
+			error = errno;
+			ev_break(loop, EVBREAK_ALL);
+		}
+	));
+
+	ev_run(loop, 0);
+
+	ASSERT_EQ(-1, result);
+	ASSERT_EQ(ENOENT, error);
+}
+
+TEST(ThreadPool, bounded)
+{
+	ThreadPool pool(1, 2);
+
+	std::mutex lock;
+	std::condition_variable cond;
+	bool blocked = true;
+	std::atomic<int> count(0);
+
+	auto task = [&]() {
+		std::unique_lock<std::mutex> l(lock);
+		cond.wait(l, [&]() { return !blocked; });
+		++count;
+	};
+
+	// occupy the only thread, then fill the queue
+	ASSERT_TRUE(pool.post(task));
+	while (pool.queued() != 0)
+		std::this_thread::yield();
+
+	ASSERT_TRUE(pool.post(task));
+	ASSERT_TRUE(pool.post(task));
+	ASSERT_FALSE(pool.post(task));
+	ASSERT_EQ(EAGAIN, errno);
+
+	{
+		std::lock_guard<std::mutex> _l(lock);
+		blocked = false;
+	}
+	cond.notify_all();
+
+	pool.stop();
+	ASSERT_EQ(3, count.load());
+}
+
+TEST(ThreadPool, readAsync)
+{
+	ev::dynamic_loop loop;
+	LoopExecutor executor(loop);
+	ThreadPool pool(2);
+
+	std::string path = createTempFile("0123456789");
+	FileStream fs(::open(path.c_str(), O_RDONLY), 2, 6); // "234567"
+
+	Buffer result;
+	result.push_back("<");
+
+	ssize_t rv = 0;
+	ASSERT_TRUE(fs.readAsync(result, 1, 100, &pool, &executor, [&](ssize_t n) {
+		rv = n;
+		ev_break(loop, EVBREAK_ALL);
+	}));
+
+	ev_run(loop, 0);
+
+	ASSERT_EQ(5, rv);
+	ASSERT_EQ("<34567", result.str());
+
+	// the stream's window is left untouched
+	ASSERT_EQ(2, fs.offset());
+	ASSERT_EQ(6, fs.size());
+
+	ASSERT_FALSE(fs.readAsync(result, 7, 1, &pool, &executor, [](ssize_t) {}));
+	ASSERT_EQ(EINVAL, errno);
+
+	::unlink(path.c_str());
+}
+
+TEST(ThreadPool, queryAsync)
+{
+	ev::dynamic_loop loop;
+	LoopExecutor executor(loop);
+	ThreadPool pool(2);
+	FileMgr::Config config;
+	FileMgr mgr(loop, &config);
+
+	std::string path = createTempFile("hello");
+
+	FilePtr fi;
+	ASSERT_TRUE(mgr.queryAsync(path, &pool, &executor, [&](FilePtr f) {
+		fi = f;
+		ev_break(loop, EVBREAK_ALL);
+	}));
+	ASSERT_TRUE(fi == nullptr);
+
+	ev_run(loop, 0);
+
+	ASSERT_TRUE(fi != nullptr);
+	ASSERT_TRUE(fi->exists());
+	ASSERT_EQ(5, fi->size());
+	ASSERT_EQ(1, mgr.size());
+
+	// cache hits complete right away
+	FilePtr cached;
+	ASSERT_TRUE(mgr.queryAsync(path, &pool, &executor, [&](FilePtr f) { cached = f; }));
+	ASSERT_TRUE(cached == fi);
+	ASSERT_TRUE(mgr.query(path) == fi);
+
+	::unlink(path.c_str());
+}
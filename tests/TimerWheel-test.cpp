@@ -0,0 +1,140 @@
+#include <gtest/gtest.h>
+#include <xio/TimerWheel.h>
+#include <xio/Socket.h>
+#include <vector>
+#include <sys/socket.h>
+
+using namespace xio;
+
+struct TimerWheelHandler {
+	std::vector<int>* fired;
+	int id;
+	TimerWheel::Timer timer;
+
+	void onTimeout(TimerWheel::Timer&) { fired->push_back(id); }
+};
+
+TEST(TimerWheel, expire)
+{
+	ev::dynamic_loop loop;
+	TimerWheel wheel(loop, TimeSpan::fromMilliseconds(5), 8);
+	std::vector<int> fired;
+
+	TimerWheelHandler a { &fired, 1 };
+	TimerWheelHandler b { &fired, 2 };
+	a.timer.set<TimerWheelHandler, &TimerWheelHandler::onTimeout>(&a);
+	b.timer.set<TimerWheelHandler, &TimerWheelHandler::onTimeout>(&b);
+
+	// b's timeout exceeds one wheel revolution (8 x 5ms)
+	wheel.start(&b.timer, TimeSpan::fromMilliseconds(60));
+	wheel.start(&a.timer, TimeSpan::fromMilliseconds(10));
+	ASSERT_EQ(2, wheel.size());
+
+	ev_run(loop, 0);
+
+	ASSERT_EQ(2, fired.size());
+	ASSERT_EQ(1, fired[0]);
+	ASSERT_EQ(2, fired[1]);
+	ASSERT_EQ(0, wheel.size());
+	ASSERT_FALSE(a.timer.isActive());
+}
+
+TEST(TimerWheel, rearmAndStop)
+{
+	ev::dynamic_loop loop;
+	TimerWheel wheel(loop, TimeSpan::fromMilliseconds(5), 16);
+	std::vector<int> fired;
+
+	TimerWheelHandler a { &fired, 1 };
+	TimerWheelHandler b { &fired, 2 };
+	a.timer.set<TimerWheelHandler, &TimerWheelHandler::onTimeout>(&a);
+	b.timer.set<TimerWheelHandler, &TimerWheelHandler::onTimeout>(&b);
+
+	wheel.start(&a.timer, TimeSpan::fromMilliseconds(10));
+	wheel.start(&b.timer, TimeSpan::fromMilliseconds(20));
+
+	// re-arming must not add a second entry
+	wheel.start(&a.timer, TimeSpan::fromMilliseconds(40));
+	ASSERT_EQ(2, wheel.size());
+
+	b.timer.stop();
+	ASSERT_FALSE(b.timer.isActive());
+	ASSERT_EQ(1, wheel.size());
+
+	ev_run(loop, 0);
+
+	ASSERT_EQ(1, fired.size());
+	ASSERT_EQ(1, fired[0]);
+}
+
+struct TimerWheelActor {
+	std::vector<int>* fired;
+	int id;
+	TimerWheel* wheel;
+	TimerWheel::Timer* stopTarget;
+	TimerWheel::Timer* rearmTarget;
+	TimerWheel::Timer timer;
+
+	void onTimeout(TimerWheel::Timer&) {
+		fired->push_back(id);
+
+		if (stopTarget)
+			stopTarget->stop();
+
+		if (rearmTarget) {
+			wheel->start(rearmTarget, TimeSpan::fromMilliseconds(20));
+			rearmTarget = nullptr;
+		}
+	}
+};
+
+TEST(TimerWheel, callbackModifiesSlot)
+{
+	ev::dynamic_loop loop;
+	TimerWheel wheel(loop, TimeSpan::fromMilliseconds(5), 16);
+	std::vector<int> fired;
+
+	// all four expire within the same tick, and fire in the order they were started
+	TimerWheelActor d { &fired, 4, &wheel, nullptr, nullptr };
+	TimerWheelActor c { &fired, 3, &wheel, nullptr, &d.timer };
+	TimerWheelActor b { &fired, 2, &wheel, nullptr, nullptr };
+	TimerWheelActor a { &fired, 1, &wheel, &b.timer, nullptr };
+
+	for (TimerWheelActor* actor: { &a, &b, &c, &d }) {
+		actor->timer.set<TimerWheelActor, &TimerWheelActor::onTimeout>(actor);
+		wheel.start(&actor->timer, TimeSpan::fromMilliseconds(10));
+	}
+	ASSERT_EQ(4, wheel.size());
+
+	ev_run(loop, 0);
+
+	// a stopped b, and c re-armed d, which thus only fired once (later)
+	ASSERT_EQ(3, fired.size());
+	ASSERT_EQ(1, fired[0]);
+	ASSERT_EQ(3, fired[1]);
+	ASSERT_EQ(4, fired[2]);
+	ASSERT_EQ(0, wheel.size());
+}
+
+TEST(TimerWheel, socketTimeout)
+{
+	ev::dynamic_loop loop;
+	TimerWheel wheel(loop, TimeSpan::fromMilliseconds(5));
+
+	int fds[2];
+	ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+
+	Socket socket(loop, fds[0], AF_UNIX);
+	socket.setTimerWheel(&wheel);
+
+	int result = 0;
+	socket.on(Socket::READ, TimeSpan::fromMilliseconds(10), [&](int revents) { result = revents; });
+	ASSERT_EQ(1, wheel.size());
+
+	ev_run(loop, 0);
+
+	ASSERT_EQ(Socket::TIMEOUT, result);
+	ASSERT_EQ(0, wheel.size());
+
+	::close(fds[1]);
+}
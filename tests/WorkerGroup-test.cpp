@@ -0,0 +1,178 @@
+#include <gtest/gtest.h>
+#include <xio/WorkerGroup.h>
+#include <xio/InetServer.h>
+#include <xio/UnixServer.h>
+#include <xio/IPAddress.h>
+#include <xio/Socket.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace xio;
+
+TEST(WorkerGroup, post)
+{
+	WorkerGroup workers(2, false);
+	ASSERT_EQ(2, workers.size());
+
+	std::atomic<int> count(0);
+	std::thread::id caller = std::this_thread::get_id();
+	std::atomic<bool> foreign(true);
+
+	workers.start();
+
+	for (int i = 0; i < 10; ++i) {
+		workers.post([&]() {
+			if (std::this_thread::get_id() == caller)
+				foreign = false;
+
+			++count;
+		});
+	}
+
+	workers.post(0, [&]() { workers.stop(); });
+	workers.join();
+
+	ASSERT_TRUE(foreign);
+	ASSERT_EQ(10, count.load());
+}
+
+/* connects \p count clients to the given listener's address, accepting them on \p workers.
+ *
+ * \return number of connections accepted.
+ */
+static int acceptAll(WorkerGroup& workers, ServerSocket* listener, const struct sockaddr* addr, socklen_t addrlen, int count)
+{
+	std::atomic<int> accepted(0);
+
+	listener->callback = [&](Socket* client, ServerSocket*) {
+		delete client;
+
+		if (++accepted == count)
+			workers.stop();
+	};
+
+	if (!workers.listen(listener))
+		return -1;
+
+	workers.start();
+
+	std::vector<int> clients;
+	for (int i = 0; i < count; ++i) {
+		int fd = ::socket(addr->sa_family, SOCK_STREAM, 0);
+		if (::connect(fd, addr, addrlen) < 0)
+			break;
+
+		clients.push_back(fd);
+	}
+
+	workers.join();
+
+	for (int fd: clients)
+		::close(fd);
+
+	return accepted;
+}
+
+static int freePort()
+{
+	int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+	struct sockaddr_in sin = {};
+	sin.sin_family = AF_INET;
+	sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	socklen_t len = sizeof(sin);
+
+	::bind(fd, (struct sockaddr*) &sin, sizeof(sin));
+	::getsockname(fd, (struct sockaddr*) &sin, &len);
+	::close(fd);
+
+	return ntohs(sin.sin_port);
+}
+
+static void listenInet(bool reusePort)
+{
+	ev::dynamic_loop loop;
+	WorkerGroup workers(3, false);
+	int port = freePort();
+
+	InetServer listener(loop);
+	listener.setReusePort(reusePort);
+	ASSERT_TRUE(listener.open(IPAddress("127.0.0.1"), port, O_NONBLOCK | O_CLOEXEC));
+
+	struct sockaddr_in sin = {};
+	sin.sin_family = AF_INET;
+	sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	sin.sin_port = htons(port);
+
+	ASSERT_EQ(16, acceptAll(workers, &listener, (struct sockaddr*) &sin, sizeof(sin), 16));
+
+	// with SO_REUSEPORT, each worker has its own socket, and the template is closed
+	ASSERT_EQ(!reusePort, listener.isOpen());
+	ASSERT_FALSE(listener.isActive());
+}
+
+TEST(WorkerGroup, listenInetShared)
+{
+	listenInet(false);
+}
+
+TEST(WorkerGroup, listenInetReusePort)
+{
+	listenInet(true);
+}
+
+TEST(WorkerGroup, listenUnix)
+{
+	ev::dynamic_loop loop;
+	WorkerGroup workers(2, false);
+
+	struct sockaddr_un sun = {};
+	sun.sun_family = AF_UNIX;
+	snprintf(sun.sun_path, sizeof(sun.sun_path), "/tmp/xio-WorkerGroup-test.%d", getpid());
+
+	UnixServer listener(loop);
+	ASSERT_TRUE(listener.open(sun.sun_path, O_NONBLOCK | O_CLOEXEC));
+
+	ASSERT_EQ(8, acceptAll(workers, &listener, (struct sockaddr*) &sun, sizeof(sun), 8));
+
+	listener.close();
+}
+
+TEST(WorkerGroup, listenRollback)
+{
+	ev::dynamic_loop loop;
+	WorkerGroup workers(2, false);
+
+	InetServer listener(loop);
+	ASSERT_TRUE(listener.open(IPAddress("127.0.0.1"), freePort(), O_NONBLOCK | O_CLOEXEC));
+
+	// leave room for exactly one more file descriptor, so only the first clone can open
+	int lowest = ::fcntl(listener.handle(), F_DUPFD, 0);
+	::close(lowest);
+
+	struct rlimit saved;
+	ASSERT_EQ(0, getrlimit(RLIMIT_NOFILE, &saved));
+
+	struct rlimit limit = saved;
+	limit.rlim_cur = lowest + 1;
+	ASSERT_EQ(0, setrlimit(RLIMIT_NOFILE, &limit));
+
+	bool result = workers.listen(&listener);
+
+	ASSERT_EQ(0, setrlimit(RLIMIT_NOFILE, &saved));
+	ASSERT_FALSE(result);
+
+	// the first clone has been closed again
+	int fd = ::fcntl(listener.handle(), F_DUPFD, 0);
+	ASSERT_EQ(lowest, fd);
+	::close(fd);
+
+	ASSERT_TRUE(listener.isOpen());
+}
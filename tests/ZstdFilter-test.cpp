@@ -0,0 +1,65 @@
+#include <gtest/gtest.h>
+#include <xio/ZstdFilter.h>
+#include <xio/sysconfig.h>
+
+#if defined(HAVE_ZSTD_H) && defined(HAVE_LIBZSTD)
+#	include <zstd.h>
+#endif
+
+using namespace xio;
+
+TEST(ZstdFilter, frame)
+{
+	ZstdFilter filter;
+	Buffer output;
+
+	if (!ZstdFilter::isSupported()) {
+		ASSERT_EQ(-1, filter.process(BufferRef("hello"), output));
+		ASSERT_EQ(ENOSYS, errno);
+		return;
+	}
+
+	ASSERT_NE(-1, filter.process(BufferRef("hello, "), output));
+	ASSERT_LT(0, filter.flush(output));
+	size_t flushed = output.size();
+
+	ASSERT_NE(-1, filter.process(BufferRef("world"), output));
+	ASSERT_LT(0, filter.finish(output));
+	ASSERT_LT(flushed, output.size());
+
+	// frame magic number, little endian
+	ASSERT_EQ('\x28', output[0]);
+	ASSERT_EQ('\xb5', output[1]);
+	ASSERT_EQ('\x2f', output[2]);
+	ASSERT_EQ('\xfd', output[3]);
+}
+
+#if defined(HAVE_ZSTD_H) && defined(HAVE_LIBZSTD)
+TEST(ZstdFilter, roundTrip)
+{
+	Buffer input;
+	for (int i = 0; i < 1000; ++i) {
+		input.push_back("line ");
+		input.push_back(i);
+		input.push_back(": the quick brown fox jumps over the lazy dog\n");
+	}
+
+	ZstdFilter filter;
+	Buffer output;
+
+	// fed in pieces, with a block boundary in between
+	ASSERT_NE(-1, filter.process(input.ref(0, 1000), output));
+	ASSERT_LT(0, filter.flush(output));
+	ASSERT_NE(-1, filter.process(input.ref(1000), output));
+	ASSERT_LT(0, filter.finish(output));
+	ASSERT_GT(input.size(), output.size());
+
+	Buffer decompressed;
+	decompressed.reserve(input.size() * 2);
+	size_t n = ZSTD_decompress(decompressed.data(), decompressed.capacity(), output.data(), output.size());
+	ASSERT_FALSE(ZSTD_isError(n));
+	decompressed.resize(n);
+
+	ASSERT_EQ(input, decompressed);
+}
+#endif